@@ -0,0 +1,367 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file adjacency.c
+ * @author Ashutosh Grewal
+ * @date 02/11/17.
+ *
+ * @brief This file implements the adjacency arrays of the vertices.
+ *
+ * @details
+ * Each vertex keeps its adjacent vertices in an array. Next to each adjacent
+ * vertex sits its mirror, the position of this vertex in the adjacent
+ * vertex's array. The mirror lets us remove both halves of an edge without
+ * searching for them: the removed edge's slot is filled with the last edge of
+ * the array and the mirror of that edge is pointed at its new slot. Each edge
+ * also carries a weight, 1 unless the user gave it another one. Most vertices
+ * have only a few adjacent vertices, so the first ADJACENCY_INLINE_SLOTS of
+ * them are kept in slots inside the vertex itself and cost no allocation.
+ * Past that all three arrays live in one block allocated through the graph's
+ * allocator. The in adjacency of a graph that keeps the edges into each
+ * vertex always uses a block, sparing every vertex of such a graph a second
+ * set of slots.
+ *
+ * An edge of an undirected graph is in the arrays of both its vertices. An
+ * edge of a directed graph is only in the arrays of the vertex it goes out
+ * of, and in the in arrays of the vertex it goes into if the graph keeps
+ * those. The mirror of an out edge is then its slot in the in array and the
+ * other way round, while the out edges of a graph without in arrays have no
+ * other half to mirror.
+ */
+#include <string.h>
+#include "public.h"
+#include "graph.h"
+#include "adjacency.h"
+#include "graph_private.h"
+#include "allocator.h"
+
+/**
+ * @brief Where the other halves of the edges in an array are.
+ */
+typedef enum other_half_e {
+    OTHER_HALF_NONE, /**< The edges have no other half. */
+    OTHER_HALF_OUT, /**< In the adjacency of the adjacent vertex. */
+    OTHER_HALF_IN /**< In the in adjacency of the adjacent vertex. */
+} other_half_t;
+
+/**
+ * @brief Return the size of the block holding the adjacency arrays.
+ *
+ * @param[in] capacity Number of adjacent vertices the block has room for.
+ *
+ * @return Size of the block.
+ */
+static size_t adjacency_block_size (unsigned int capacity)
+{
+    return (sizeof(vertex_t *) + sizeof(float) + sizeof(unsigned int)) * capacity;
+}
+
+/**
+ * @brief Tell whether the arrays of an adjacency are in the inline slots.
+ *
+ * @param[in] adjacency The adjacency.
+ * @param[in] slots The inline slots of the adjacency, NULL if it has none.
+ *
+ * @return TRUE if the arrays are in the slots, FALSE otherwise.
+ */
+static boolean in_slots (adjacency_t *adjacency, adjacency_slots_t *slots)
+{
+    return slots != NULL && adjacency->vertices == slots->vertices;
+}
+
+/**
+ * @brief Make room for more edges in an adjacency.
+ *
+ * @param[in, out] adjacency The adjacency.
+ * @param[in] slots The inline slots of the adjacency, NULL if it has none.
+ * @param[in] extra Number of edges to make room for.
+ * @param[in, out] allocator The allocator, NULL to use malloc.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean grow_adjacency (adjacency_t *adjacency, adjacency_slots_t *slots,
+                               unsigned int extra, allocator_t *allocator)
+{
+    vertex_t **vertices;
+    unsigned int capacity;
+    
+    if (adjacency->count + extra <= adjacency->capacity) {
+        
+        return TRUE;
+    }
+    if (slots != NULL && adjacency->capacity == 0 && extra <= ADJACENCY_INLINE_SLOTS) {
+        adjacency->vertices = slots->vertices;
+        adjacency->weights = slots->weights;
+        adjacency->mirrors = slots->mirrors;
+        adjacency->capacity = ADJACENCY_INLINE_SLOTS;
+        
+        return TRUE;
+    }
+    capacity = adjacency->capacity ? adjacency->capacity : 2;
+    while (capacity < adjacency->count + extra) {
+        capacity *= 2;
+    }
+    vertices = (vertex_t **) allocate_memory(allocator, adjacency_block_size(capacity));
+    if (vertices == NULL) {
+        
+        return FALSE;
+    }
+    if (adjacency->vertices) {
+        memcpy(vertices, adjacency->vertices, sizeof(vertex_t *) * adjacency->count);
+        memcpy(vertices + capacity, adjacency->weights,
+               sizeof(float) * adjacency->count);
+        memcpy((float *) (vertices + capacity) + capacity, adjacency->mirrors,
+               sizeof(unsigned int) * adjacency->count);
+        if (!in_slots(adjacency, slots)) {
+            free_memory(allocator, adjacency->vertices,
+                        adjacency_block_size(adjacency->capacity));
+        }
+    }
+    adjacency->vertices = vertices;
+    adjacency->weights = (float *) (vertices + capacity);
+    adjacency->mirrors = (unsigned int *) (adjacency->weights + capacity);
+    adjacency->capacity = capacity;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Make room for more adjacent vertices of this vertex.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in] extra Number of adjacent vertices to make room for.
+ * @param[in, out] allocator The allocator, NULL to use malloc.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean reserve_adjacency (vertex_t *vertex, unsigned int extra,
+                           allocator_t *allocator)
+{
+    return grow_adjacency(&vertex->adjacency, &vertex->slots, extra, allocator);
+}
+
+/**
+ * @brief Make room for more edges into this vertex, which must have room for
+ *        its in adjacency.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in] extra Number of edges to make room for.
+ * @param[in, out] allocator The allocator, NULL to use malloc.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean reserve_in_adjacency (vertex_t *vertex, unsigned int extra,
+                              allocator_t *allocator)
+{
+    return grow_adjacency(vertex->in_adjacency, NULL, extra, allocator);
+}
+
+/**
+ * @brief Make both the vertices adjacent to each other.
+ *
+ * @param[in, out] vertex1 First vertex.
+ * @param[in, out] vertex2 Second vertex, a different vertex than the first.
+ * @param[in] weight Weight of the edge.
+ * @param[in, out] allocator The allocator, NULL to use malloc.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed, in which
+ *         case neither vertex is changed.
+ */
+boolean link_vertices (vertex_t *vertex1, vertex_t *vertex2, float weight,
+                       allocator_t *allocator)
+{
+    adjacency_t *adjacency1, *adjacency2;
+    
+    if (!reserve_adjacency(vertex1, 1, allocator) ||
+        !reserve_adjacency(vertex2, 1, allocator)) {
+        
+        return FALSE;
+    }
+    adjacency1 = &vertex1->adjacency;
+    adjacency2 = &vertex2->adjacency;
+    adjacency1->vertices[adjacency1->count] = vertex2;
+    adjacency1->weights[adjacency1->count] = weight;
+    adjacency1->mirrors[adjacency1->count] = adjacency2->count;
+    adjacency2->vertices[adjacency2->count] = vertex1;
+    adjacency2->weights[adjacency2->count] = weight;
+    adjacency2->mirrors[adjacency2->count] = adjacency1->count;
+    adjacency1->count++;
+    adjacency2->count++;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Make an edge going from one vertex to another.
+ *
+ * @param[in, out] from Vertex the edge goes out of.
+ * @param[in, out] to Vertex the edge goes into, a different vertex than from.
+ * @param[in] weight Weight of the edge.
+ * @param[in] in_edges TRUE if the vertices have an in adjacency to keep the
+ *                     edge in as well.
+ * @param[in, out] allocator The allocator, NULL to use malloc.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed, in which
+ *         case neither vertex is changed.
+ */
+boolean link_directed (vertex_t *from, vertex_t *to, float weight,
+                       boolean in_edges, allocator_t *allocator)
+{
+    adjacency_t *out, *in;
+    
+    if (!reserve_adjacency(from, 1, allocator) ||
+        (in_edges && !reserve_in_adjacency(to, 1, allocator))) {
+        
+        return FALSE;
+    }
+    out = &from->adjacency;
+    out->vertices[out->count] = to;
+    out->weights[out->count] = weight;
+    out->mirrors[out->count] = 0;
+    if (in_edges) {
+        in = to->in_adjacency;
+        out->mirrors[out->count] = in->count;
+        in->vertices[in->count] = from;
+        in->weights[in->count] = weight;
+        in->mirrors[in->count] = out->count;
+        in->count++;
+    }
+    out->count++;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Remove one half of an edge from an adjacency, filling its slot with
+ *        the last edge.
+ *
+ * @param[in, out] adjacency The adjacency.
+ * @param[in] slot Slot of the edge in the adjacency.
+ * @param[in] other_half Where the other halves of its edges are.
+ */
+static void remove_from_adjacency (adjacency_t *adjacency, unsigned int slot,
+                                   other_half_t other_half)
+{
+    vertex_t *moved;
+    unsigned int last;
+    
+    last = --adjacency->count;
+    if (slot == last) {
+        
+        return;
+    }
+    moved = adjacency->vertices[last];
+    adjacency->vertices[slot] = moved;
+    adjacency->weights[slot] = adjacency->weights[last];
+    adjacency->mirrors[slot] = adjacency->mirrors[last];
+    
+    /*
+     * The other half of the moved edge has to know where it went.
+     */
+    if (other_half == OTHER_HALF_OUT) {
+        moved->adjacency.mirrors[adjacency->mirrors[slot]] = slot;
+    } else if (other_half == OTHER_HALF_IN) {
+        moved->in_adjacency->mirrors[adjacency->mirrors[slot]] = slot;
+    }
+}
+
+/**
+ * @brief Remove the edge between this vertex and one of its adjacent
+ *        vertices, in constant time for both of them.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in] i Which one of the adjacent vertices, as for get_adjacent_vertex.
+ */
+void unlink_adjacent_vertex (vertex_t *vertex, unsigned int i)
+{
+    unsigned int slot;
+    vertex_t *adj_vertex;
+    
+    slot = vertex->adjacency.count - 1 - i;
+    adj_vertex = vertex->adjacency.vertices[slot];
+    remove_from_adjacency(&adj_vertex->adjacency, vertex->adjacency.mirrors[slot],
+                          OTHER_HALF_OUT);
+    remove_from_adjacency(&vertex->adjacency, slot, OTHER_HALF_OUT);
+}
+
+/**
+ * @brief Remove an edge going out of this vertex.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in] i Which one of the edges, as for get_adjacent_vertex.
+ * @param[in] in_edges TRUE if the vertices have an in adjacency the edge has
+ *                     to be removed from as well.
+ */
+void unlink_out_vertex (vertex_t *vertex, unsigned int i, boolean in_edges)
+{
+    unsigned int slot;
+    vertex_t *adj_vertex;
+    
+    slot = vertex->adjacency.count - 1 - i;
+    adj_vertex = vertex->adjacency.vertices[slot];
+    if (in_edges) {
+        remove_from_adjacency(adj_vertex->in_adjacency,
+                              vertex->adjacency.mirrors[slot], OTHER_HALF_OUT);
+    }
+    remove_from_adjacency(&vertex->adjacency, slot,
+                          in_edges ? OTHER_HALF_IN : OTHER_HALF_NONE);
+}
+
+/**
+ * @brief Remove an edge going into this vertex, which must have an in
+ *        adjacency.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in] i Which one of the edges, as for get_in_vertex.
+ */
+void unlink_in_vertex (vertex_t *vertex, unsigned int i)
+{
+    unsigned int slot;
+    vertex_t *adj_vertex;
+    
+    slot = vertex->in_adjacency->count - 1 - i;
+    adj_vertex = vertex->in_adjacency->vertices[slot];
+    remove_from_adjacency(&adj_vertex->adjacency,
+                          vertex->in_adjacency->mirrors[slot], OTHER_HALF_IN);
+    remove_from_adjacency(vertex->in_adjacency, slot, OTHER_HALF_OUT);
+}
+
+/**
+ * @brief Free the arrays of an adjacency.
+ *
+ * @param[in, out] adjacency The adjacency.
+ * @param[in] slots The inline slots of the adjacency, NULL if it has none.
+ * @param[in, out] allocator The allocator, NULL to use free.
+ */
+static void free_adjacency (adjacency_t *adjacency, adjacency_slots_t *slots,
+                            allocator_t *allocator)
+{
+    if (adjacency->vertices && !in_slots(adjacency, slots)) {
+        free_memory(allocator, adjacency->vertices,
+                    adjacency_block_size(adjacency->capacity));
+    }
+    memset(adjacency, 0, sizeof(adjacency_t));
+}
+
+/**
+ * @brief Free the adjacency arrays of a vertex, which must not have any
+ *        adjacent vertices left.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in, out] allocator The allocator, NULL to use free.
+ */
+void destroy_adjacency (vertex_t *vertex, allocator_t *allocator)
+{
+    free_adjacency(&vertex->adjacency, &vertex->slots, allocator);
+}
+
+/**
+ * @brief Free the in adjacency arrays of a vertex, which must not have any
+ *        edges into it left.
+ *
+ * @param[in, out] vertex The vertex.
+ * @param[in, out] allocator The allocator, NULL to use free.
+ */
+void destroy_in_adjacency (vertex_t *vertex, allocator_t *allocator)
+{
+    free_adjacency(vertex->in_adjacency, NULL, allocator);
+}
@@ -0,0 +1,99 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file adjacency.h
+ * @author Ashutosh Grewal
+ * @date 02/11/17.
+ *
+ * @brief This header file contains the APIs to the adjacency arrays of the
+ *        vertices, shared by the files that walk or change them.
+ */
+#ifndef ADJACENCY_H
+#define ADJACENCY_H
+
+#include "public.h"
+#include "graph.h"
+#include "graph_private.h"
+#include "allocator.h"
+
+boolean reserve_adjacency (vertex_t *, unsigned int, allocator_t *);
+boolean reserve_in_adjacency (vertex_t *, unsigned int, allocator_t *);
+boolean link_vertices (vertex_t *, vertex_t *, float, allocator_t *);
+boolean link_directed (vertex_t *, vertex_t *, float, boolean, allocator_t *);
+void unlink_adjacent_vertex (vertex_t *, unsigned int);
+void unlink_out_vertex (vertex_t *, unsigned int, boolean);
+void unlink_in_vertex (vertex_t *, unsigned int);
+void destroy_adjacency (vertex_t *, allocator_t *);
+void destroy_in_adjacency (vertex_t *, allocator_t *);
+
+/**
+ * @brief Return the number of vertices adjacent to this vertex.
+ *
+ * @param[in] vertex The vertex.
+ *
+ * @return Number of adjacent vertices.
+ */
+static inline unsigned int get_adjacent_count (vertex_t *vertex)
+{
+    return vertex->adjacency.count;
+}
+
+/**
+ * @brief Return an adjacent vertex of this vertex.
+ *
+ * @details
+ * The adjacent vertices come most recently linked first, the order the
+ * adjacency lists used to keep them in. Unlinking a vertex moves the most
+ * recently linked one into its place.
+ *
+ * @param[in] vertex The vertex.
+ * @param[in] i Which one of the adjacent vertices, less than the count.
+ *
+ * @return The adjacent vertex.
+ */
+static inline vertex_t *get_adjacent_vertex (vertex_t *vertex, unsigned int i)
+{
+    return vertex->adjacency.vertices[vertex->adjacency.count - 1 - i];
+}
+
+/**
+ * @brief Return the weight of the edge to an adjacent vertex of this vertex.
+ *
+ * @param[in] vertex The vertex.
+ * @param[in] i Which one of the adjacent vertices, as for get_adjacent_vertex.
+ *
+ * @return Weight of the edge.
+ */
+static inline float get_adjacent_weight (vertex_t *vertex, unsigned int i)
+{
+    return vertex->adjacency.weights[vertex->adjacency.count - 1 - i];
+}
+
+/**
+ * @brief Return the number of edges into this vertex, which must have an in
+ *        adjacency.
+ *
+ * @param[in] vertex The vertex.
+ *
+ * @return Number of edges into the vertex.
+ */
+static inline unsigned int get_in_count (vertex_t *vertex)
+{
+    return vertex->in_adjacency->count;
+}
+
+/**
+ * @brief Return a vertex with an edge into this vertex, which must have an in
+ *        adjacency.
+ *
+ * @param[in] vertex The vertex.
+ * @param[in] i Which one of the edges, less than the count, most recently
+ *              linked first.
+ *
+ * @return The vertex the edge comes from.
+ */
+static inline vertex_t *get_in_vertex (vertex_t *vertex, unsigned int i)
+{
+    return vertex->in_adjacency->vertices[vertex->in_adjacency->count - 1 - i];
+}
+
+#endif /* ADJACENCY_H */
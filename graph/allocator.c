@@ -0,0 +1,160 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file allocator.c
+ * @author Ashutosh Grewal
+ * @date 02/04/17.
+ *
+ * @brief This file implements the helpers to allocate memory through the
+ *        pluggable allocator, and the default allocator backed by a slab pool.
+ *
+ * @details
+ * An allocator is a set of function pointers and the opaque pool they work
+ * on, so the user can bring their own memory management. A NULL allocator
+ * means plain malloc and free.
+ */
+#include <stdlib.h>
+#include "public.h"
+#include "allocator.h"
+#include "slab.h"
+
+#ifdef GRAPH_ENABLE_STATS
+
+/*
+ * Counted per thread, so an API call can tell its own allocations apart from
+ * the ones other threads make at the same time.
+ */
+static __thread unsigned long thread_allocations;
+static __thread unsigned long long thread_bytes;
+
+/**
+ * @brief Return the allocations the calling thread has made through
+ *        allocate_memory.
+ *
+ * @param[out] allocations Number of allocations.
+ * @param[out] bytes Bytes they asked for.
+ */
+void get_thread_allocations (unsigned long *allocations, unsigned long long *bytes)
+{
+    *allocations = thread_allocations;
+    *bytes = thread_bytes;
+}
+
+#endif /* GRAPH_ENABLE_STATS */
+
+/**
+ * @brief Allocate memory through the allocator.
+ *
+ * @param[in, out] allocator The allocator, NULL to use malloc.
+ * @param[in] size Size of the memory.
+ *
+ * @return Pointer to the memory, NULL if memory allocation failed.
+ */
+void *allocate_memory (allocator_t *allocator, size_t size)
+{
+#ifdef GRAPH_ENABLE_STATS
+    thread_allocations++;
+    thread_bytes += size;
+#endif
+    if (allocator == NULL) {
+        
+        return malloc(size);
+    }
+    
+    return allocator->allocate(allocator->pool, size);
+}
+
+/**
+ * @brief Free memory allocated through the allocator.
+ *
+ * @param[in, out] allocator The allocator, NULL to use free.
+ * @param[in] memory Pointer to the memory.
+ * @param[in] size Size the memory was allocated with.
+ */
+void free_memory (allocator_t *allocator, void *memory, size_t size)
+{
+    if (allocator == NULL) {
+        free(memory);
+        
+        return;
+    }
+    allocator->deallocate(allocator->pool, memory, size);
+}
+
+/**
+ * @brief Allocate memory from a slab pool.
+ *
+ * @param[in, out] pool The slab pool.
+ * @param[in] size Size of the memory.
+ *
+ * @return Pointer to the memory, NULL if memory allocation failed.
+ */
+static void *slab_allocate (void *pool, size_t size)
+{
+    return allocate_from_slab_pool((slab_pool_t *) pool, size);
+}
+
+/**
+ * @brief Free memory back to a slab pool.
+ *
+ * @param[in, out] pool The slab pool.
+ * @param[in] memory Pointer to the memory.
+ * @param[in] size Size the memory was allocated with.
+ */
+static void slab_deallocate (void *pool, void *memory, size_t size)
+{
+    free_to_slab_pool((slab_pool_t *) pool, memory, size);
+}
+
+/**
+ * @brief Free everything allocated from a slab pool.
+ *
+ * @param[in, out] pool The slab pool.
+ */
+static void slab_release (void *pool)
+{
+    release_slab_pool((slab_pool_t *) pool);
+}
+
+/**
+ * @brief Initialize an allocator backed by a new slab pool.
+ *
+ * @param[out] allocator The allocator.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean init_slab_allocator (allocator_t *allocator)
+{
+    allocator->pool = create_slab_pool();
+    if (allocator->pool == NULL) {
+        
+        return FALSE;
+    }
+    allocator->allocate = slab_allocate;
+    allocator->deallocate = slab_deallocate;
+    allocator->release = slab_release;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Forget everything allocated from the slab pool backing an
+ *        allocator, keeping its memory for what is allocated next.
+ *
+ * @param[in, out] allocator The allocator.
+ */
+void reset_slab_allocator (allocator_t *allocator)
+{
+    reset_slab_pool((slab_pool_t *) allocator->pool);
+}
+
+/**
+ * @brief Destroy the slab pool backing an allocator, freeing everything
+ *        allocated from it.
+ *
+ * @param[in, out] allocator The allocator.
+ */
+void destroy_slab_allocator (allocator_t *allocator)
+{
+    destroy_slab_pool((slab_pool_t *) allocator->pool);
+    allocator->pool = NULL;
+}
@@ -0,0 +1,44 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file allocator.h
+ * @author Ashutosh Grewal
+ * @date 02/04/17.
+ *
+ * @brief This header file contains the definition of the pluggable allocator
+ *        used by the graph for its vertices and adjacency arrays, and APIs to
+ *        allocate memory through it.
+ */
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include "public.h"
+
+typedef void *(*allocate_t) (void *, size_t);
+typedef void (*deallocate_t) (void *, void *, size_t);
+typedef void (*release_t) (void *);
+
+/**
+ * @brief The allocator interface.
+ */
+typedef struct allocator_s {
+    allocate_t allocate; /**< Function pointer to allocate memory of the given
+                              size from the pool. */
+    deallocate_t deallocate; /**< Function pointer to free memory back to the
+                                  pool, along with the size it was allocated
+                                  with. */
+    release_t release; /**< Function pointer to free everything allocated from
+                            the pool at once, NULL if the pool can't do that. */
+    void *pool; /**< The user created opaque pool passed to the functions. */
+} allocator_t;
+
+void *allocate_memory (allocator_t *, size_t);
+void free_memory (allocator_t *, void *, size_t);
+boolean init_slab_allocator (allocator_t *);
+void reset_slab_allocator (allocator_t *);
+void destroy_slab_allocator (allocator_t *);
+#ifdef GRAPH_ENABLE_STATS
+void get_thread_allocations (unsigned long *, unsigned long long *);
+#endif
+
+#endif /* ALLOCATOR_H */
@@ -0,0 +1,535 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file batch_search.c
+ * @author Ashutosh Grewal
+ * @date 04/08/17
+ *
+ * @brief This file implements answering a batch of breadth first searches of
+ *        a graph at once.
+ *
+ * @details
+ * The searches are grouped by their source, and up to BATCH_LANES sources at
+ * a time are searched together as one multi-source breadth first search. Every
+ * source gets a lane, a bit of a 64 bit word, and every vertex keeps the lanes
+ * that have reached it and the lanes it's in the frontier of. Going through
+ * an edge then moves all the lanes of the frontier at once with a couple of
+ * bitwise operations, so sources whose searches cover the same parts of the
+ * graph share the work of going through them. Searches from the same source
+ * share a lane and so a single search. A lane stops moving once all its
+ * searches are answered, and a group stops once all its lanes have.
+ *
+ * The data of every search is looked up once, in the index if the graph has
+ * one and in the registry otherwise, so the searches compare vertices instead
+ * of data. The groups are handed out to a number of threads, the calling
+ * thread being one of them. Each thread keeps its lanes and frontiers for all
+ * the groups it searches and only clears what a group touched.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "graph_private.h"
+#include "adjacency.h"
+#include "batch_search.h"
+#include "stats.h"
+
+/**
+ * Number of sources searched together.
+ */
+#define BATCH_LANES 64
+
+/**
+ * @brief Searches from up to BATCH_LANES sources, searched together.
+ */
+typedef struct batch_group_s {
+    unsigned int first; /**< First of its searches in the sorted order. */
+    unsigned int last; /**< One past its last search. */
+} batch_group_t;
+
+/**
+ * @brief What is shared by the threads answering a batch.
+ */
+typedef struct batch_state_s {
+    graph_t *graph; /**< The graph being searched. */
+    const graph_query_t *queries; /**< The searches. */
+    unsigned int *order; /**< The searches sorted by source. */
+    unsigned int *lanes; /**< Lane of each search, indexed like order. */
+    vertex_t **targets; /**< Vertex containing the data of each search,
+                             indexed like order. */
+    batch_group_t *groups; /**< The groups. */
+    unsigned int num_groups; /**< Number of groups. */
+    unsigned int next_group; /**< Next group to hand out. */
+    query_done_t done; /**< Function called with every answer. */
+    void *arg; /**< Argument passed to done. */
+} batch_state_t;
+
+/**
+ * @brief What a thread keeps for all the groups it searches.
+ */
+typedef struct batch_thread_s {
+    batch_state_t *state; /**< What is shared by the threads. */
+    uint64_t *seen; /**< Lanes that reached each vertex. */
+    uint64_t *visit; /**< Lanes each vertex is in the frontier of. */
+    uint64_t *visit_next; /**< Lanes each vertex is in the next frontier of. */
+    uint64_t *wanted; /**< Lanes searching for each vertex. */
+    unsigned int *frontier; /**< Ids of the vertices in the frontier. */
+    unsigned int *next; /**< Ids of the vertices in the next frontier. */
+    unsigned int *touched; /**< Ids of the vertices reached by any lane. */
+    unsigned int num_touched; /**< Number of vertices reached. */
+    unsigned int lane_first[BATCH_LANES]; /**< First search of each lane. */
+    unsigned int lane_last[BATCH_LANES]; /**< One past its last search. */
+    unsigned int pending[BATCH_LANES]; /**< Searches of each lane not
+                                            answered yet. */
+} batch_thread_t;
+
+/**
+ * @brief Compare two sort keys for qsort.
+ *
+ * @param[in] a First key.
+ * @param[in] b Second key.
+ *
+ * @return Less than, equal to or greater than 0 as a is less than, equal to or
+ *         greater than b.
+ */
+static int compare_keys (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Find the vertex containing the given data, the caller must hold the
+ *        graph's lock.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+static vertex_t *lookup_target (graph_t *graph, void *data)
+{
+    if (graph->index != NULL) {
+        
+        return lookup_in_hash_table(graph->index, data);
+    }
+    for (unsigned int i = 0; i < graph->num_vertices; i++) {
+        if (graph->data_is_equal(data, graph->vertices[i]->data)) {
+            
+            return graph->vertices[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Note that a lane reached a vertex and answer its searches for that
+ *        vertex.
+ *
+ * @param[in, out] thread The thread.
+ * @param[in] lane The lane.
+ * @param[in] vertex The vertex.
+ * @param[in] depth Number of edges between the lane's source and the vertex.
+ *
+ * @return TRUE if the lane has no searches left, FALSE otherwise.
+ */
+static boolean answer_lane (batch_thread_t *thread, unsigned int lane,
+                            vertex_t *vertex, unsigned int depth)
+{
+    batch_state_t *state = thread->state;
+    
+    for (unsigned int i = thread->lane_first[lane]; i < thread->lane_last[lane]; i++) {
+        if (state->targets[i] == vertex) {
+            state->done(state->order[i], vertex, depth, state->arg);
+            thread->pending[lane]--;
+        }
+    }
+    
+    return thread->pending[lane] == 0;
+}
+
+/**
+ * @brief Mark the lanes that reached a vertex, answering the searches for
+ *        it, and add it to the next frontier.
+ *
+ * @param[in, out] thread The thread.
+ * @param[in] vertex The vertex.
+ * @param[in] lanes The lanes that reached it for the first time.
+ * @param[in] depth Number of edges between their sources and the vertex.
+ * @param[in, out] num_next Number of vertices in the next frontier.
+ *
+ * @return The lanes that have no searches left.
+ */
+static uint64_t reach_vertex (batch_thread_t *thread, vertex_t *vertex,
+                              uint64_t lanes, unsigned int depth,
+                              unsigned int *num_next)
+{
+    uint64_t hits, finished = 0;
+    unsigned int lane, id = vertex->id;
+    
+    if (thread->seen[id] == 0) {
+        thread->touched[thread->num_touched++] = id;
+    }
+    if (thread->visit_next[id] == 0) {
+        thread->next[(*num_next)++] = id;
+    }
+    thread->seen[id] |= lanes;
+    thread->visit_next[id] |= lanes;
+    for (hits = lanes & thread->wanted[id]; hits != 0; hits &= hits - 1) {
+        lane = (unsigned int) __builtin_ctzll(hits);
+        if (answer_lane(thread, lane, vertex, depth)) {
+            finished |= 1ULL << lane;
+        }
+    }
+    
+    return finished;
+}
+
+/**
+ * @brief Answer the searches of a group, the caller must hold the graph's
+ *        lock.
+ *
+ * @param[in, out] thread The thread.
+ * @param[in] group The group.
+ */
+static void search_group (batch_thread_t *thread, batch_group_t *group)
+{
+    batch_state_t *state = thread->state;
+    graph_t *graph = state->graph;
+    const graph_query_t *query;
+    vertex_t *vertex, *adj_vertex, *source;
+    unsigned int num_lanes, num_frontier, num_next, depth, *swap, lane;
+    uint64_t active = 0, lanes, reached;
+    
+    /*
+     * Give every source its lane and look up what its searches want.
+     */
+    num_lanes = 0;
+    for (unsigned int i = group->first; i < group->last; i++) {
+        lane = state->lanes[i];
+        if (lane == num_lanes) {
+            thread->lane_first[lane] = i;
+            thread->pending[lane] = 0;
+            num_lanes++;
+        }
+        thread->lane_last[lane] = i + 1;
+        query = &state->queries[state->order[i]];
+        state->targets[i] = lookup_target(graph, query->data);
+        if (state->targets[i] == NULL) {
+            state->done(state->order[i], NULL, 0, state->arg);
+            continue;
+        }
+        thread->wanted[state->targets[i]->id] |= 1ULL << lane;
+        thread->pending[lane]++;
+        active |= 1ULL << lane;
+    }
+    
+    thread->num_touched = 0;
+    num_next = 0;
+    for (unsigned int i = group->first; i < group->last; i++) {
+        lane = state->lanes[i];
+        if (i != thread->lane_first[lane] || thread->pending[lane] == 0) {
+            continue;
+        }
+        query = &state->queries[state->order[i]];
+        source = query->source ? query->source : graph->vertex;
+        if (reach_vertex(thread, source, 1ULL << lane, 0, &num_next)) {
+            active &= ~(1ULL << lane);
+        }
+    }
+    
+    /*
+     * Every level moves the frontier of all the lanes still searching one
+     * edge further.
+     */
+    for (depth = 1; active != 0 && num_next > 0; depth++) {
+        swap = thread->frontier;
+        thread->frontier = thread->next;
+        thread->next = swap;
+        num_frontier = num_next;
+        num_next = 0;
+        for (unsigned int i = 0; i < num_frontier; i++) {
+            thread->visit[thread->frontier[i]] = thread->visit_next[thread->frontier[i]];
+            thread->visit_next[thread->frontier[i]] = 0;
+        }
+        for (unsigned int i = 0; i < num_frontier && active != 0; i++) {
+            vertex = graph->vertices[thread->frontier[i]];
+            lanes = thread->visit[vertex->id] & active;
+            thread->visit[vertex->id] = 0;
+            if (lanes == 0) {
+                continue;
+            }
+            for (unsigned int j = 0; j < get_adjacent_count(vertex); j++) {
+                adj_vertex = get_adjacent_vertex(vertex, j);
+                reached = lanes & ~thread->seen[adj_vertex->id];
+                if (reached != 0) {
+                    active &= ~reach_vertex(thread, adj_vertex, reached, depth,
+                                            &num_next);
+                }
+            }
+        }
+    }
+    
+    /*
+     * Whatever wasn't reached can't be, and the next group starts clean.
+     */
+    for (unsigned int i = group->first; i < group->last; i++) {
+        lane = state->lanes[i];
+        if (state->targets[i] == NULL) {
+            continue;
+        }
+        if (!(thread->seen[state->targets[i]->id] & (1ULL << lane))) {
+            state->done(state->order[i], NULL, 0, state->arg);
+        }
+        thread->wanted[state->targets[i]->id] = 0;
+    }
+    for (unsigned int i = 0; i < thread->num_touched; i++) {
+        thread->seen[thread->touched[i]] = 0;
+        thread->visit[thread->touched[i]] = 0;
+        thread->visit_next[thread->touched[i]] = 0;
+    }
+}
+
+/**
+ * @brief Search the groups handed out to a thread till there are none left.
+ *
+ * @param[in, out] arg The thread.
+ *
+ * @return NULL.
+ */
+static void *batch_thread (void *arg)
+{
+    batch_thread_t *thread = (batch_thread_t *) arg;
+    batch_state_t *state = thread->state;
+    unsigned int group;
+    
+    for (;;) {
+        group = __atomic_fetch_add(&state->next_group, 1, __ATOMIC_RELAXED);
+        if (group >= state->num_groups) {
+            break;
+        }
+        search_group(thread, &state->groups[group]);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Free what a thread keeps for its groups.
+ *
+ * @param[in, out] thread The thread.
+ */
+static void free_batch_thread (batch_thread_t *thread)
+{
+    free(thread->seen);
+    free(thread->visit);
+    free(thread->visit_next);
+    free(thread->wanted);
+    free(thread->frontier);
+    free(thread->next);
+    free(thread->touched);
+}
+
+/**
+ * @brief Allocate what a thread keeps for its groups.
+ *
+ * @param[out] thread The thread.
+ * @param[in] state What is shared by the threads.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean init_batch_thread (batch_thread_t *thread, batch_state_t *state)
+{
+    unsigned int num_vertices = state->graph->num_vertices;
+    
+    memset(thread, 0, sizeof(batch_thread_t));
+    thread->state = state;
+    thread->seen = (uint64_t *) calloc (num_vertices, sizeof(uint64_t));
+    thread->visit = (uint64_t *) calloc (num_vertices, sizeof(uint64_t));
+    thread->visit_next = (uint64_t *) calloc (num_vertices, sizeof(uint64_t));
+    thread->wanted = (uint64_t *) calloc (num_vertices, sizeof(uint64_t));
+    thread->frontier = (unsigned int *) malloc (sizeof(unsigned int) * num_vertices);
+    thread->next = (unsigned int *) malloc (sizeof(unsigned int) * num_vertices);
+    thread->touched = (unsigned int *) malloc (sizeof(unsigned int) * num_vertices);
+    if (thread->seen == NULL || thread->visit == NULL || thread->visit_next == NULL ||
+        thread->wanted == NULL || thread->frontier == NULL || thread->next == NULL ||
+        thread->touched == NULL) {
+        free_batch_thread(thread);
+        
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Sort the searches by source and split them into groups of up to
+ *        BATCH_LANES sources.
+ *
+ * @param[in, out] state What is shared by the threads.
+ * @param[in] num_queries Number of searches.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean group_queries (batch_state_t *state, unsigned int num_queries)
+{
+    const graph_query_t *query;
+    uint64_t *keys;
+    unsigned int lane = 0, source, previous = 0;
+    
+    keys = (uint64_t *) malloc (sizeof(uint64_t) * num_queries);
+    if (keys == NULL) {
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < num_queries; i++) {
+        query = &state->queries[i];
+        source = query->source ? query->source->id : state->graph->vertex->id;
+        keys[i] = (uint64_t) source << 32 | i;
+    }
+    qsort(keys, num_queries, sizeof(uint64_t), compare_keys);
+    
+    state->num_groups = 0;
+    for (unsigned int i = 0; i < num_queries; i++) {
+        state->order[i] = (unsigned int) keys[i];
+        source = (unsigned int) (keys[i] >> 32);
+        if (i == 0 || source != previous) {
+            if (i == 0 || ++lane == BATCH_LANES) {
+                if (state->num_groups > 0) {
+                    state->groups[state->num_groups - 1].last = i;
+                }
+                state->groups[state->num_groups++].first = i;
+                lane = 0;
+            }
+            previous = source;
+        }
+        state->lanes[i] = lane;
+    }
+    state->groups[state->num_groups - 1].last = num_queries;
+    free(keys);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Answer a batch of breadth first searches of the graph.
+ *
+ * @details
+ * Each search looks for the vertex containing its data among the vertices
+ * that can be reached from its source, as breadth_first_search does from the
+ * graph's vertex. The done function is called once for every search, from
+ * the threads answering them and so possibly from many threads at once, in no
+ * particular order. All of them have been called by the time this returns.
+ * The searches hold the graph's lock for reading all the while, so done must
+ * not change the graph. If the data of more than one vertex is equal, the
+ * one the index or the registry has is the one searched for.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] queries The searches.
+ * @param[in] num_queries Number of searches.
+ * @param[in] num_threads Number of threads to search with, including the
+ *                        calling thread.
+ * @param[in] done Function called with the answer to every search.
+ * @param[in] arg Opaque argument passed to done.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed, in which
+ *         case none of the searches was answered.
+ */
+boolean graph_search_batch (graph_t *graph, const graph_query_t *queries,
+                            unsigned int num_queries, unsigned int num_threads,
+                            query_done_t done, void *arg)
+{
+    batch_state_t state;
+    batch_thread_t *threads = NULL;
+    pthread_t *thread_ids = NULL;
+    unsigned int num_ready = 0, num_started = 0;
+    boolean answered = FALSE;
+    GRAPH_STATS_TIMER(timer);
+    
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    if (graph->vertex == NULL) {
+        for (unsigned int i = 0; i < num_queries; i++) {
+            done(i, NULL, 0, arg);
+        }
+        answered = TRUE;
+        goto unlock;
+    }
+    memset(&state, 0, sizeof(batch_state_t));
+    state.graph = graph;
+    state.queries = queries;
+    state.done = done;
+    state.arg = arg;
+    state.order = (unsigned int *) malloc (sizeof(unsigned int) * (num_queries + 1));
+    state.lanes = (unsigned int *) malloc (sizeof(unsigned int) * (num_queries + 1));
+    state.targets = (vertex_t **) malloc (sizeof(vertex_t *) * (num_queries + 1));
+    state.groups = (batch_group_t *) malloc (sizeof(batch_group_t) *
+                                             (num_queries / BATCH_LANES + 1));
+    if (state.order == NULL || state.lanes == NULL || state.targets == NULL ||
+        state.groups == NULL) {
+        goto done;
+    }
+    if (num_queries == 0) {
+        answered = TRUE;
+        goto done;
+    }
+    if (!group_queries(&state, num_queries)) {
+        goto done;
+    }
+    
+    /*
+     * There's no point in more threads than groups.
+     */
+    if (num_threads > state.num_groups) {
+        num_threads = state.num_groups;
+    }
+    threads = (batch_thread_t *) malloc (sizeof(batch_thread_t) * num_threads);
+    thread_ids = (pthread_t *) malloc (sizeof(pthread_t) * num_threads);
+    if (threads == NULL || thread_ids == NULL) {
+        goto done;
+    }
+    for (; num_ready < num_threads; num_ready++) {
+        if (!init_batch_thread(&threads[num_ready], &state)) {
+            goto done;
+        }
+    }
+    
+    /*
+     * The threads that couldn't be started leave their groups to the others.
+     */
+    for (unsigned int i = 1; i < num_threads; i++) {
+        if (pthread_create(&thread_ids[num_started + 1], NULL, batch_thread,
+                           &threads[num_started + 1]) != 0) {
+            break;
+        }
+        num_started++;
+    }
+    batch_thread(&threads[0]);
+    for (unsigned int i = 1; i <= num_started; i++) {
+        pthread_join(thread_ids[i], NULL);
+    }
+    answered = TRUE;
+
+done:
+    for (unsigned int i = 0; i < num_ready; i++) {
+        free_batch_thread(&threads[i]);
+    }
+    free(threads);
+    free(thread_ids);
+    free(state.order);
+    free(state.lanes);
+    free(state.targets);
+    free(state.groups);
+unlock:
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_SEARCH, timer);
+    
+    return answered;
+}
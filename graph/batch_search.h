@@ -0,0 +1,38 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file batch_search.h
+ * @author Ashutosh Grewal
+ * @date 04/08/17.
+ *
+ * @brief Header file containing APIs to answer many searches of a graph at
+ *        once.
+ */
+#ifndef BATCH_SEARCH_H
+#define BATCH_SEARCH_H
+
+#include "public.h"
+#include "graph.h"
+
+/**
+ * @brief A search in a batch.
+ */
+typedef struct graph_query_s {
+    vertex_t *source; /**< Vertex to search from, NULL for the graph's
+                           vertex. */
+    void *data; /**< Opaque data for which we need to search. */
+} graph_query_t;
+
+/**
+ * @brief Called with the answer to every search in a batch.
+ *
+ * @details
+ * The arguments are the position of the search in the batch, the vertex
+ * containing the data, NULL if it can't be reached, the number of edges
+ * between the source and that vertex and the argument given for the batch.
+ */
+typedef void (*query_done_t) (unsigned int, vertex_t *, unsigned int, void *);
+
+boolean graph_search_batch (graph_t *, const graph_query_t *, unsigned int,
+                            unsigned int, query_done_t, void *);
+
+#endif /* BATCH_SEARCH_H */
@@ -0,0 +1,711 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file bench.c
+ * @author Ashutosh Grewal
+ * @date 03/27/17
+ *
+ * @brief This file contains the benchmarks of the graph data structure, built
+ *        as the bench target.
+ *
+ * @details
+ * Every run generates a synthetic graph, a uniformly random one, a power law
+ * one or a grid like a road network, and times building it, finding, searching
+ * and walking it, freezing it and working on the snapshot, and deleting from
+ * and destroying it. Each timing is printed as one JSON object per line, so
+ * the output of two builds can be compared by a script:
+ *
+ *     {"generator": "random", "vertices": 1000, "edges": 4000, "directed": 0,
+ *      "threads": 4, "op": "insert_batch", "count": 4000, "seconds": 0.0012,
+ *      "ops_per_sec": 3333333, "ns_per_edge": 300.0, "peak_rss_kb": 2404}
+ *
+ * count is the number of operations timed, ns_per_edge the time divided by
+ * the number of edges the operations went over, 0 for the ones that don't
+ * count their edges, like finding and searching. peak_rss_kb is the peak
+ * resident size of the process so far, so it only grows from line to line.
+ *
+ * Usage: bench [-g random|powerlaw|grid] [-n min] [-m max] [-d degree]
+ *              [-t threads] [-s seed] [-D]
+ *
+ * The vertex counts go from min to max, a power of 10 apart, 10^3 to 10^5 by
+ * default. -D builds directed graphs keeping the edges into every vertex.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "public.h"
+#include "graph.h"
+#include "csr.h"
+#include "batch_search.h"
+#include "partition.h"
+
+#define BENCH_SEARCHES 16
+#define BENCH_SHARDS 4
+#define BENCH_DELETE_FRACTION 10
+
+/**
+ * @brief The synthetic graph being benchmarked.
+ */
+typedef struct bench_graph_s {
+    const char *generator; /**< Name of the generator. */
+    unsigned int num_vertices; /**< Number of vertices. */
+    unsigned int num_edges; /**< Number of edges. */
+    void **data; /**< Data of every vertex, its number + 1. */
+    void **from; /**< Data of the first end of every edge. */
+    void **to; /**< Data of the second end of every edge. */
+    graph_mode_t mode; /**< Whether the edges have a direction. */
+    unsigned int num_threads; /**< Threads for the parallel APIs. */
+} bench_graph_t;
+
+static uint64_t rng_state;
+
+/**
+ * @brief Return the next pseudo random number, the same ones for the same
+ *        seed on every platform.
+ *
+ * @return The number.
+ */
+static uint64_t next_random (void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    
+    return rng_state * 2685821657736338717ULL;
+}
+
+/**
+ * @brief Return a pseudo random number below a bound.
+ *
+ * @param[in] bound The bound, more than 0.
+ *
+ * @return The number.
+ */
+static unsigned int random_below (unsigned int bound)
+{
+    return (unsigned int) ((next_random() >> 32) % bound);
+}
+
+/**
+ * @brief Return the time in seconds from some fixed point.
+ *
+ * @return The time.
+ */
+static double now (void)
+{
+    struct timeval tv;
+    
+    gettimeofday(&tv, NULL);
+    
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/**
+ * @brief Return the peak resident size of the process.
+ *
+ * @return Peak resident size in kilobytes.
+ */
+static long peak_rss_kb (void)
+{
+    struct rusage usage;
+    
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * @brief Print the timing of one operation as a line of JSON.
+ *
+ * @param[in] bench The graph benchmarked.
+ * @param[in] op Name of the operation.
+ * @param[in] count Number of operations timed.
+ * @param[in] edges Number of edges the operations went over.
+ * @param[in] seconds Time they took.
+ */
+static void report (bench_graph_t *bench, const char *op, unsigned long count,
+                    double edges, double seconds)
+{
+    printf("{\"generator\": \"%s\", \"vertices\": %u, \"edges\": %u, "
+           "\"directed\": %d, \"threads\": %u, \"op\": \"%s\", \"count\": %lu, "
+           "\"seconds\": %.6f, \"ops_per_sec\": %.0f, \"ns_per_edge\": %.2f, "
+           "\"peak_rss_kb\": %ld}\n",
+           bench->generator, bench->num_vertices, bench->num_edges,
+           bench->mode != GRAPH_UNDIRECTED, bench->num_threads, op, count,
+           seconds, seconds > 0 ? count / seconds : 0,
+           edges > 0 ? seconds * 1e9 / edges : 0, peak_rss_kb());
+    fflush(stdout);
+}
+
+/**
+ * @brief Add an edge to the graph being generated, unless it's a loop.
+ *
+ * @param[in, out] bench The graph being generated.
+ * @param[in] from Number of the first end.
+ * @param[in] to Number of the second end.
+ */
+static void add_edge (bench_graph_t *bench, unsigned int from, unsigned int to)
+{
+    if (from == to) {
+        
+        return;
+    }
+    bench->from[bench->num_edges] = bench->data[from];
+    bench->to[bench->num_edges] = bench->data[to];
+    bench->num_edges++;
+}
+
+/**
+ * @brief Generate a graph whose edges join uniformly random vertices.
+ *
+ * @param[in, out] bench The graph being generated, with room for the edges.
+ * @param[in] max_edges Number of edges to try.
+ */
+static void generate_random (bench_graph_t *bench, unsigned int max_edges)
+{
+    for (unsigned int i = 0; i < max_edges; i++) {
+        add_edge(bench, random_below(bench->num_vertices),
+                 random_below(bench->num_vertices));
+    }
+}
+
+/**
+ * @brief Generate a graph whose degrees follow a power law.
+ *
+ * @details
+ * This is the R-MAT recursive matrix generator: every edge picks one quarter
+ * of the adjacency matrix after the other, favoring the top left, so a few
+ * vertices end up with most of the edges, as in social and web graphs. Edges
+ * landing past the last vertex are dropped.
+ *
+ * @param[in, out] bench The graph being generated, with room for the edges.
+ * @param[in] max_edges Number of edges to try.
+ */
+static void generate_power_law (bench_graph_t *bench, unsigned int max_edges)
+{
+    unsigned int scale = 0, from, to, quarter;
+    
+    while ((1UL << scale) < bench->num_vertices) {
+        scale++;
+    }
+    for (unsigned int i = 0; i < max_edges; i++) {
+        from = 0;
+        to = 0;
+        for (unsigned int bit = 0; bit < scale; bit++) {
+            quarter = random_below(100);
+            from = (from << 1) | (quarter >= 76);
+            to = (to << 1) | ((quarter >= 57 && quarter < 76) || quarter >= 95);
+        }
+        if (from < bench->num_vertices && to < bench->num_vertices) {
+            add_edge(bench, from, to);
+        }
+    }
+}
+
+/**
+ * @brief Generate a grid, every vertex joined to the ones right of and below
+ *        it, like the streets of a city.
+ *
+ * @param[in, out] bench The graph being generated, with room for the edges.
+ */
+static void generate_grid (bench_graph_t *bench)
+{
+    unsigned int side = 1;
+    
+    while ((unsigned long) side * side < bench->num_vertices) {
+        side++;
+    }
+    for (unsigned int i = 0; i < bench->num_vertices; i++) {
+        if (i % side + 1 < side && i + 1 < bench->num_vertices) {
+            add_edge(bench, i, i + 1);
+        }
+        if (i + side < bench->num_vertices) {
+            add_edge(bench, i, i + side);
+        }
+    }
+}
+
+/**
+ * @brief Generate the graph to benchmark.
+ *
+ * @param[out] bench The graph generated.
+ * @param[in] generator Name of the generator.
+ * @param[in] num_vertices Number of vertices.
+ * @param[in] degree Average number of edges of a vertex, for the random and
+ *                   power law graphs.
+ *
+ * @return TRUE if successful, FALSE if the generator is unknown or memory
+ *         allocation failed.
+ */
+static boolean generate (bench_graph_t *bench, const char *generator,
+                         unsigned int num_vertices, unsigned int degree)
+{
+    unsigned long max_edges;
+    
+    max_edges = strcmp(generator, "grid") ? (unsigned long) num_vertices * degree / 2 :
+                2UL * num_vertices;
+    if (max_edges >= UINT32_MAX) {
+        
+        return FALSE;
+    }
+    bench->generator = generator;
+    bench->num_vertices = num_vertices;
+    bench->num_edges = 0;
+    bench->data = (void **) malloc (sizeof(void *) * (num_vertices + 1));
+    bench->from = (void **) malloc (sizeof(void *) * (max_edges + 1));
+    bench->to = (void **) malloc (sizeof(void *) * (max_edges + 1));
+    if (bench->data == NULL || bench->from == NULL || bench->to == NULL) {
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        bench->data[i] = (void *) (uintptr_t) (i + 1);
+    }
+    if (strcmp(generator, "random") == 0) {
+        generate_random(bench, (unsigned int) max_edges);
+    } else if (strcmp(generator, "powerlaw") == 0) {
+        generate_power_law(bench, (unsigned int) max_edges);
+    } else if (strcmp(generator, "grid") == 0) {
+        generate_grid(bench);
+    } else {
+        
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Free the graph generated.
+ *
+ * @param[in] bench The graph generated.
+ */
+static void free_generated (bench_graph_t *bench)
+{
+    free(bench->data);
+    free(bench->from);
+    free(bench->to);
+    bench->data = NULL;
+    bench->from = NULL;
+    bench->to = NULL;
+}
+
+/**
+ * @brief Print nothing, the benchmarks don't print the vertices.
+ *
+ * @param[in] data The opaque data.
+ */
+static void print_nothing (void *data)
+{
+}
+
+/**
+ * @brief Count the vertices a walk reaches.
+ *
+ * @param[in] vertex The vertex reached.
+ * @param[in] parent The vertex it was reached from.
+ * @param[in] depth Its depth in the walk.
+ * @param[in, out] arg The count.
+ *
+ * @return VISIT_CONTINUE.
+ */
+static visit_t count_vertex (vertex_t *vertex, vertex_t *parent,
+                             unsigned int depth, void *arg)
+{
+    (*(unsigned long *) arg)++;
+    
+    return VISIT_CONTINUE;
+}
+
+/**
+ * @brief Count the searches of a batch that found their data.
+ *
+ * @param[in] query Position of the search in the batch.
+ * @param[in] found The vertex containing the data, NULL if not reached.
+ * @param[in] depth Edges between the source and that vertex.
+ * @param[in, out] arg The count.
+ */
+static void count_found (unsigned int query, vertex_t *found,
+                         unsigned int depth, void *arg)
+{
+    if (found) {
+        __atomic_fetch_add((unsigned long *) arg, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Create an empty graph to benchmark.
+ *
+ * @param[in] bench The graph generated.
+ *
+ * @return Pointer to the graph if successful, NULL otherwise.
+ */
+static graph_t *create_bench_graph (bench_graph_t *bench)
+{
+    return create_graph_with_keys(print_nothing, GRAPH_KEY_INTEGER, bench->mode);
+}
+
+/**
+ * @brief Time adding the vertices one at a time, each with its edges to the
+ *        vertices added before it.
+ *
+ * @details
+ * The edges are grouped by their later end first, which isn't timed. In a
+ * directed graph they go from their later end to their earlier one.
+ *
+ * @param[in] bench The graph generated.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean bench_insert (bench_graph_t *bench)
+{
+    graph_t *graph;
+    unsigned int *offsets, *next, later, earlier;
+    void **adjacent;
+    boolean added = TRUE;
+    double start;
+    
+    graph = create_bench_graph(bench);
+    offsets = (unsigned int *) calloc (bench->num_vertices + 1, sizeof(unsigned int));
+    next = (unsigned int *) malloc (sizeof(unsigned int) * (bench->num_vertices + 1));
+    adjacent = (void **) malloc (sizeof(void *) * (bench->num_edges + 1));
+    if (graph == NULL || offsets == NULL || next == NULL || adjacent == NULL) {
+        added = FALSE;
+        goto done;
+    }
+    for (unsigned int i = 0; i < bench->num_edges; i++) {
+        later = (unsigned int) ((uintptr_t) bench->from[i] > (uintptr_t) bench->to[i] ?
+                                (uintptr_t) bench->from[i] : (uintptr_t) bench->to[i]) - 1;
+        offsets[later + 1]++;
+    }
+    for (unsigned int i = 0; i < bench->num_vertices; i++) {
+        offsets[i + 1] += offsets[i];
+        next[i] = offsets[i];
+    }
+    for (unsigned int i = 0; i < bench->num_edges; i++) {
+        later = (unsigned int) (uintptr_t) bench->from[i] - 1;
+        earlier = (unsigned int) (uintptr_t) bench->to[i] - 1;
+        if (later < earlier) {
+            later = earlier;
+            earlier = (unsigned int) (uintptr_t) bench->from[i] - 1;
+        }
+        adjacent[next[later]++] = bench->data[earlier];
+    }
+    
+    start = now();
+    for (unsigned int i = 0; added && i < bench->num_vertices; i++) {
+        added = add_vertex_to_graph(graph, bench->data[i], adjacent + offsets[i],
+                                    offsets[i + 1] - offsets[i]);
+    }
+    report(bench, "insert", bench->num_vertices, bench->num_edges, now() - start);
+
+done:
+    if (graph) {
+        destroy_graph(graph);
+    }
+    free(offsets);
+    free(next);
+    free(adjacent);
+    
+    return added;
+}
+
+/**
+ * @brief Time working on a snapshot of the graph.
+ *
+ * @param[in] bench The graph generated.
+ * @param[in] csr The snapshot.
+ * @param[in] name Name of the snapshot in the timings.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean bench_csr (bench_graph_t *bench, csr_graph_t *csr, const char *name)
+{
+    unsigned int *levels, *parents, num_components, rounds = 0;
+    float *ranks;
+    boolean searched = FALSE;
+    char op[64];
+    double start;
+    
+    levels = (unsigned int *) malloc (sizeof(unsigned int) * (csr_num_vertices(csr) + 1));
+    parents = (unsigned int *) malloc (sizeof(unsigned int) * (csr_num_vertices(csr) + 1));
+    ranks = (float *) malloc (sizeof(float) * (csr_num_vertices(csr) + 1));
+    if (levels == NULL || parents == NULL || ranks == NULL) {
+        goto done;
+    }
+    start = now();
+    searched = csr_parallel_breadth_first_search(csr, 0, 1, levels, parents);
+    snprintf(op, sizeof(op), "%s_bfs_1_thread", name);
+    report(bench, op, 1, bench->num_edges, now() - start);
+    start = now();
+    searched = searched &&
+               csr_parallel_breadth_first_search(csr, 0, bench->num_threads,
+                                                 levels, parents);
+    snprintf(op, sizeof(op), "%s_parallel_bfs", name);
+    report(bench, op, 1, bench->num_edges, now() - start);
+    start = now();
+    searched = searched &&
+               csr_connected_components(csr, bench->num_threads, levels,
+                                        &num_components);
+    snprintf(op, sizeof(op), "%s_components", name);
+    report(bench, op, 1, bench->num_edges, now() - start);
+    start = now();
+    searched = searched &&
+               csr_pagerank(csr, 0.85f, 1e-6f, 100, bench->num_threads, ranks, &rounds);
+    snprintf(op, sizeof(op), "%s_pagerank", name);
+    report(bench, op, rounds, (double) rounds * bench->num_edges, now() - start);
+    start = now();
+    searched = searched &&
+               csr_label_propagation(csr, 100, bench->num_threads, levels, &rounds);
+    snprintf(op, sizeof(op), "%s_label_propagation", name);
+    report(bench, op, rounds, (double) rounds * bench->num_edges, now() - start);
+
+done:
+    free(levels);
+    free(parents);
+    free(ranks);
+    
+    return searched;
+}
+
+/**
+ * @brief Time splitting a snapshot into shards and searching them.
+ *
+ * @param[in] bench The graph generated.
+ * @param[in] csr The snapshot.
+ * @param[in] method How to split it.
+ * @param[in] name Name of the method in the timings.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean bench_partition (bench_graph_t *bench, csr_graph_t *csr,
+                                partition_method_t method, const char *name)
+{
+    graph_partition_t *partition;
+    unsigned int *levels;
+    boolean searched = FALSE;
+    char op[64];
+    double start;
+    
+    levels = (unsigned int *) malloc (sizeof(unsigned int) * (csr_num_vertices(csr) + 1));
+    start = now();
+    partition = csr_partition(csr, BENCH_SHARDS, method);
+    snprintf(op, sizeof(op), "partition_%s", name);
+    report(bench, op, 1, bench->num_edges, now() - start);
+    if (levels && partition) {
+        start = now();
+        searched = partition_breadth_first_search(partition, 0, NULL, levels);
+        snprintf(op, sizeof(op), "partition_%s_bfs", name);
+        report(bench, op, 1, bench->num_edges, now() - start);
+    }
+    destroy_graph_partition(partition);
+    free(levels);
+    
+    return searched;
+}
+
+/**
+ * @brief Run all the benchmarks on a generated graph.
+ *
+ * @param[in] bench The graph generated.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean run_benchmarks (bench_graph_t *bench)
+{
+    graph_t *graph;
+    csr_graph_t *csr, *reordered;
+    graph_query_t queries[BENCH_SEARCHES];
+    unsigned long visited, found;
+    unsigned int num_deleted;
+    boolean passed;
+    double start;
+    
+    if (!bench_insert(bench)) {
+        
+        return FALSE;
+    }
+    
+    start = now();
+    graph = create_bench_graph(bench);
+    passed = graph && add_vertices_batch(graph, bench->data, bench->num_vertices) &&
+             add_edges_batch(graph, bench->from, bench->to, bench->num_edges);
+    report(bench, "insert_batch", bench->num_edges, bench->num_edges, now() - start);
+    if (!passed) {
+        goto done;
+    }
+    
+    found = 0;
+    start = now();
+    for (unsigned int i = 0; i < bench->num_vertices; i++) {
+        found += find_in_graph(graph, bench->data[i]) != NULL;
+    }
+    report(bench, "find", bench->num_vertices, 0, now() - start);
+    passed = found == bench->num_vertices;
+    
+    /*
+     * Each search finds its target in the index and then walks the graph
+     * until it gets there, over however many edges lie before the target, so
+     * the searches are timed per search and not per edge.
+     */
+    start = now();
+    for (unsigned int i = 0; i < BENCH_SEARCHES; i++) {
+        breadth_first_search(graph, bench->data[random_below(bench->num_vertices)]);
+    }
+    report(bench, "bfs_search", BENCH_SEARCHES, 0, now() - start);
+    start = now();
+    for (unsigned int i = 0; i < BENCH_SEARCHES; i++) {
+        depth_first_search(graph, bench->data[random_below(bench->num_vertices)]);
+    }
+    report(bench, "dfs_search", BENCH_SEARCHES, 0, now() - start);
+    
+    /*
+     * The same number of searches from random sources, answered together so
+     * that they share their walks of the graph.
+     */
+    for (unsigned int i = 0; i < BENCH_SEARCHES; i++) {
+        queries[i].source = get_graph_vertex(graph, random_below(bench->num_vertices));
+        queries[i].data = bench->data[random_below(bench->num_vertices)];
+    }
+    found = 0;
+    start = now();
+    passed = passed &&
+             graph_search_batch(graph, queries, BENCH_SEARCHES, bench->num_threads,
+                                count_found, &found);
+    report(bench, "batch_search", BENCH_SEARCHES, (double) bench->num_edges,
+           now() - start);
+    
+    visited = 0;
+    start = now();
+    graph_bfs_visit(graph, get_graph_vertex(graph, 0), count_vertex, &visited);
+    report(bench, "bfs_traverse", visited, bench->num_edges, now() - start);
+    visited = 0;
+    start = now();
+    graph_dfs_visit(graph, get_graph_vertex(graph, 0), count_vertex, &visited);
+    report(bench, "dfs_traverse", visited, bench->num_edges, now() - start);
+    
+    start = now();
+    csr = graph_freeze(graph);
+    report(bench, "freeze", 1, bench->num_edges, now() - start);
+    if (csr == NULL) {
+        passed = FALSE;
+        goto done;
+    }
+    passed = passed && bench_csr(bench, csr, "csr");
+    start = now();
+    reordered = csr_reorder(csr, CSR_ORDER_RCM);
+    report(bench, "csr_reorder_rcm", 1, bench->num_edges, now() - start);
+    passed = passed && reordered && bench_csr(bench, reordered, "csr_rcm");
+    passed = passed && bench_partition(bench, csr, PARTITION_HASH, "hash");
+    passed = passed && bench_partition(bench, csr, PARTITION_GREEDY, "greedy");
+    destroy_csr_graph(reordered);
+    destroy_csr_graph(csr);
+    
+    num_deleted = bench->num_vertices / BENCH_DELETE_FRACTION;
+    start = now();
+    for (unsigned int i = 0; i < num_deleted; i++) {
+        delete_from_graph(graph, bench->data[random_below(bench->num_vertices)]);
+    }
+    report(bench, "delete", num_deleted, 0, now() - start);
+    
+    /*
+     * Rebuilding after a clear reuses the memory the first build allocated.
+     */
+    start = now();
+    graph_clear(graph);
+    report(bench, "clear", 1, bench->num_edges, now() - start);
+    start = now();
+    passed = passed && add_vertices_batch(graph, bench->data, bench->num_vertices) &&
+             add_edges_batch(graph, bench->from, bench->to, bench->num_edges);
+    report(bench, "insert_batch_cleared", bench->num_edges, bench->num_edges,
+           now() - start);
+
+done:
+    start = now();
+    if (graph) {
+        destroy_graph(graph);
+    }
+    report(bench, "destroy", 1, bench->num_edges, now() - start);
+    
+    return passed;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *generators[] = {"random", "powerlaw", "grid"}, *only = NULL;
+    unsigned long min_vertices = 1000, max_vertices = 100000, degree = 8, seed = 1;
+    bench_graph_t bench;
+    long cpus;
+    int option, status = EXIT_SUCCESS;
+    
+    memset(&bench, 0, sizeof(bench));
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    bench.num_threads = cpus > 0 ? (unsigned int) cpus : 1;
+    bench.mode = GRAPH_UNDIRECTED;
+    while ((option = getopt(argc, argv, "g:n:m:d:t:s:D")) != -1) {
+        switch (option) {
+        case 'g':
+            only = optarg;
+            break;
+        case 'n':
+            min_vertices = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            max_vertices = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            degree = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            bench.num_threads = (unsigned int) strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'D':
+            bench.mode = GRAPH_DIRECTED_IN_EDGES;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-g random|powerlaw|grid] [-n min] [-m max] "
+                    "[-d degree] [-t threads] [-s seed] [-D]\n", argv[0]);
+            
+            return EXIT_FAILURE;
+        }
+    }
+    if (only && strcmp(only, "random") && strcmp(only, "powerlaw") &&
+        strcmp(only, "grid")) {
+        fprintf(stderr, "%s: unknown generator %s\n", argv[0], only);
+        
+        return EXIT_FAILURE;
+    }
+    if (min_vertices < 2 || max_vertices >= UINT32_MAX || bench.num_threads == 0) {
+        fprintf(stderr, "%s: need 2 <= min <= max < 2^32 and a thread\n", argv[0]);
+        
+        return EXIT_FAILURE;
+    }
+    
+    for (unsigned int g = 0; g < sizeof(generators) / sizeof(generators[0]); g++) {
+        if (only && strcmp(only, generators[g])) {
+            continue;
+        }
+        for (unsigned long n = min_vertices; n <= max_vertices; n *= 10) {
+            rng_state = seed * 0x9e3779b97f4a7c15ULL + 1;
+            if (!generate(&bench, generators[g], (unsigned int) n,
+                          (unsigned int) degree) || !run_benchmarks(&bench)) {
+                fprintf(stderr, "%s: %s graph of %lu vertices failed\n", argv[0],
+                        generators[g], n);
+                status = EXIT_FAILURE;
+            }
+            free_generated(&bench);
+        }
+    }
+    
+    return status;
+}
@@ -0,0 +1,274 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file bidirectional_search.c
+ * @author Ashutosh Grewal
+ * @date 03/04/17.
+ *
+ * @brief This file implements the bidirectional breadth first search between
+ *        two vertices of a graph.
+ *
+ * @details
+ * Two breadth first searches run at once, one from the source and one from
+ * the target, each taking a whole level at a time. The side with the smaller
+ * frontier goes next, so the search stays around the two vertices instead of
+ * spreading over the whole graph. It ends as soon as one side reaches a
+ * vertex the other side has reached. Both sides share the traversal context,
+ * each with an epoch of its own, so a vertex's mark tells which side reached
+ * it and nothing has to be cleared between searches.
+ *
+ * In a directed graph the side of the target follows the edges backwards,
+ * which needs the graph to keep the edges into each vertex. Without them only
+ * the side of the source moves, and the search is a plain breadth first
+ * search stopping at the target.
+ */
+#include <stdlib.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "bidirectional_search.h"
+#include "graph_private.h"
+#include "adjacency.h"
+#include "traversal_private.h"
+#include "queue.h"
+#include "stats.h"
+
+/**
+ * @brief One side of the search.
+ */
+typedef struct search_side_s {
+    queue_t *queue; /**< Frontier of this side. */
+    unsigned int epoch; /**< Mark of the vertices this side reached. */
+    unsigned int other_epoch; /**< Mark of the vertices the other side reached. */
+    unsigned int level_size; /**< Number of vertices in the frontier. */
+    boolean in_edges; /**< TRUE if the side follows the edges backwards. */
+} search_side_t;
+
+/**
+ * @brief Expand one level of a side of the search.
+ *
+ * @param[in, out] ctx The traversal context.
+ * @param[in, out] side The side of the search.
+ * @param[out] near Vertex of this side next to the other side if they met,
+ *                  NULL otherwise.
+ * @param[out] far Vertex of the other side next to this side, if they met.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean expand_level (traversal_ctx_t *ctx, search_side_t *side,
+                             vertex_t **near, vertex_t **far)
+{
+    vertex_t *vertex, *adj_vertex;
+    unsigned int next_size = 0, num_edges;
+    
+    *near = NULL;
+    for (unsigned int count = side->level_size; count > 0; count--) {
+        vertex = pop_from_queue(side->queue);
+        num_edges = side->in_edges ? get_in_count(vertex) : get_adjacent_count(vertex);
+        for (unsigned int i = 0; i < num_edges; i++) {
+            adj_vertex = side->in_edges ? get_in_vertex(vertex, i) :
+                                          get_adjacent_vertex(vertex, i);
+            if (ctx->marks[adj_vertex->id] == side->epoch) {
+                continue;
+            }
+            if (ctx->marks[adj_vertex->id] == side->other_epoch) {
+                *near = vertex;
+                *far = adj_vertex;
+                
+                return TRUE;
+            }
+            ctx->marks[adj_vertex->id] = side->epoch;
+            ctx->depths[adj_vertex->id] = ctx->depths[vertex->id] + 1;
+            ctx->parents[adj_vertex->id] = vertex;
+            if (!push_to_queue(side->queue, adj_vertex)) {
+                
+                return FALSE;
+            }
+            next_size++;
+        }
+    }
+    side->level_size = next_size;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Search for the shortest path between two vertices, the caller must
+ *        hold the graph's lock.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ * @param[in] source Vertex the path starts from.
+ * @param[in] target Vertex the path ends at.
+ * @param[out] hops Number of edges in the path.
+ * @param[out] path Array for the vertices of the path, NULL if not needed.
+ * @param[in] max_length Number of vertices path has room for.
+ *
+ * @return TRUE if the target can be reached from the source, FALSE if it
+ *         can't or memory allocation failed.
+ */
+static boolean search_bidirectional (graph_t *graph, traversal_ctx_t *ctx,
+                                     vertex_t *source, vertex_t *target,
+                                     unsigned int *hops, vertex_t **path,
+                                     unsigned int max_length)
+{
+    search_side_t forward, backward, *side;
+    vertex_t *near, *far, *source_side, *target_side;
+    unsigned int length;
+    boolean two_sided;
+    
+    if (source == target) {
+        *hops = 0;
+        if (path && max_length > 0) {
+            path[0] = source;
+        }
+        
+        return TRUE;
+    }
+    if (!begin_context_bidirectional(ctx, graph->num_vertices)) {
+        
+        return FALSE;
+    }
+    forward.queue = ctx->queue;
+    forward.epoch = ctx->epoch - 1;
+    forward.other_epoch = ctx->epoch;
+    forward.level_size = 1;
+    forward.in_edges = FALSE;
+    backward.queue = ctx->reverse_queue;
+    backward.epoch = ctx->epoch;
+    backward.other_epoch = ctx->epoch - 1;
+    backward.level_size = 1;
+    backward.in_edges = (graph->mode == GRAPH_DIRECTED_IN_EDGES);
+    two_sided = (graph->mode != GRAPH_DIRECTED);
+    ctx->marks[source->id] = forward.epoch;
+    ctx->depths[source->id] = 0;
+    ctx->parents[source->id] = NULL;
+    ctx->marks[target->id] = backward.epoch;
+    ctx->depths[target->id] = 0;
+    ctx->parents[target->id] = NULL;
+    if (!push_to_queue(forward.queue, source) ||
+        !push_to_queue(backward.queue, target)) {
+        
+        return FALSE;
+    }
+    
+    /*
+     * Once either side runs out of vertices, it has reached everything that
+     * can be reached from its end without meeting the other side.
+     */
+    while (forward.level_size > 0 && backward.level_size > 0) {
+        if (two_sided && backward.level_size < forward.level_size) {
+            side = &backward;
+        } else {
+            side = &forward;
+        }
+        if (!expand_level(ctx, side, &near, &far)) {
+            
+            return FALSE;
+        }
+        if (near == NULL) {
+            continue;
+        }
+        source_side = (side == &forward) ? near : far;
+        target_side = (side == &forward) ? far : near;
+        *hops = ctx->depths[source_side->id] + 1 + ctx->depths[target_side->id];
+        length = *hops + 1;
+        if (path == NULL || length > max_length) {
+            
+            return TRUE;
+        }
+        
+        /*
+         * The parents lead from each side's vertex back to its own end.
+         */
+        for (unsigned int i = ctx->depths[source_side->id] + 1; i > 0; i--) {
+            path[i - 1] = source_side;
+            source_side = ctx->parents[source_side->id];
+        }
+        for (unsigned int i = length - 1 - ctx->depths[target_side->id]; i < length; i++) {
+            path[i] = target_side;
+            target_side = ctx->parents[target_side->id];
+        }
+        
+        return TRUE;
+    }
+    
+    return FALSE;
+}
+
+/**
+ * @brief Find the number of hops between two vertices of the graph.
+ *
+ * @details
+ * This uses the graph's own context, use bidirectional_search_with_context
+ * to search from many threads at once or to get the path as well.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] source Vertex the path starts from.
+ * @param[in] target Vertex the path ends at.
+ * @param[out] hops Number of edges in the shortest path between them.
+ *
+ * @return TRUE if the target can be reached from the source, FALSE if it
+ *         can't or memory allocation failed.
+ */
+boolean bidirectional_search (graph_t *graph, vertex_t *source, vertex_t *target,
+                              unsigned int *hops)
+{
+    boolean found;
+    GRAPH_STATS_TIMER(timer);
+    
+    if (source == NULL || target == NULL) {
+        
+        return FALSE;
+    }
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    found = search_bidirectional(graph, graph->ctx, source, target, hops, NULL, 0);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_PATH, timer);
+    
+    return found;
+}
+
+/**
+ * @brief Find the shortest path, in hops, between two vertices of the graph
+ *        using the caller's traversal context.
+ *
+ * @details
+ * The path is only filled in if it fits, hops + 1 being the number of
+ * vertices it needs room for.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] source Vertex the path starts from.
+ * @param[in] target Vertex the path ends at.
+ * @param[out] hops Number of edges in the shortest path between them.
+ * @param[out] path Array for the vertices of the path, the source first,
+ *                  NULL if not needed.
+ * @param[in] max_length Number of vertices path has room for.
+ *
+ * @return TRUE if the target can be reached from the source, FALSE if it
+ *         can't or memory allocation failed.
+ */
+boolean bidirectional_search_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                           vertex_t *source, vertex_t *target,
+                                           unsigned int *hops, vertex_t **path,
+                                           unsigned int max_length)
+{
+    boolean found;
+    GRAPH_STATS_TIMER(timer);
+    
+    if (source == NULL || target == NULL) {
+        
+        return FALSE;
+    }
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    found = search_bidirectional(graph, ctx, source, target, hops, path, max_length);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_PATH, timer);
+    
+    return found;
+}
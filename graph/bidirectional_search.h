@@ -0,0 +1,22 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file bidirectional_search.h
+ * @author Ashutosh Grewal
+ * @date 03/04/17.
+ *
+ * @brief Header file containing APIs to find the number of hops between two
+ *        vertices of a graph.
+ */
+#ifndef BIDIRECTIONAL_SEARCH_H
+#define BIDIRECTIONAL_SEARCH_H
+
+#include "public.h"
+#include "graph.h"
+#include "traversal.h"
+
+boolean bidirectional_search (graph_t *, vertex_t *, vertex_t *, unsigned int *);
+boolean bidirectional_search_with_context (graph_t *, traversal_ctx_t *, vertex_t *,
+                                           vertex_t *, unsigned int *, vertex_t **,
+                                           unsigned int);
+
+#endif /* BIDIRECTIONAL_SEARCH_H */
@@ -0,0 +1,306 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file connectivity.c
+ * @author Ashutosh Grewal
+ * @date 04/01/17
+ *
+ * @brief This file implements keeping the connected components of the graph
+ *        up to date as it changes.
+ *
+ * @details
+ * The components are a union-find forest over the vertex ids, joined as every
+ * edge is added, so counting them or telling whether two vertices are
+ * connected doesn't need a traversal. The components of a directed graph are
+ * the weakly connected ones, an edge joining its ends whatever its direction.
+ *
+ * A union-find forest can't take edges out. Deleting a vertex leaves the
+ * forest stale, to be rebuilt out of the edges by the next call that needs it.
+ * The number of components stays exact across the deletes that can't split a
+ * component: a vertex without edges takes its component with it and a vertex
+ * with one edge leaves the rest of its component connected. Only deleting a
+ * vertex with more edges than that costs the next count a rebuild.
+ */
+#include <stdlib.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "graph_private.h"
+#include "adjacency.h"
+#include "connectivity.h"
+
+/**
+ * @brief Make room in the forest for more vertex ids.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] capacity Number of vertex ids the forest should have room for.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean reserve_components (graph_t *graph, unsigned int capacity)
+{
+    unsigned int *parents;
+    unsigned char *ranks;
+    
+    if (capacity <= graph->components_capacity) {
+        
+        return TRUE;
+    }
+    parents = (unsigned int *) realloc (graph->component_parents,
+                                        sizeof(unsigned int) * capacity);
+    if (parents == NULL) {
+        
+        return FALSE;
+    }
+    graph->component_parents = parents;
+    ranks = (unsigned char *) realloc (graph->component_ranks, capacity);
+    if (ranks == NULL) {
+        
+        return FALSE;
+    }
+    graph->component_ranks = ranks;
+    graph->components_capacity = capacity;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Find the root of a vertex id's tree, halving the path to it on the
+ *        way. The caller must hold the graph's lock for writing.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] id The vertex id.
+ *
+ * @return The root.
+ */
+static unsigned int find_root (graph_t *graph, unsigned int id)
+{
+    unsigned int *parents = graph->component_parents;
+    
+    while (parents[id] != id) {
+        parents[id] = parents[parents[id]];
+        id = parents[id];
+    }
+    
+    return id;
+}
+
+/**
+ * @brief Add a new vertex, without any edges yet, as a component of its own.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex The vertex, already in the registry.
+ */
+void add_component (graph_t *graph, vertex_t *vertex)
+{
+    graph->num_components++;
+    if (!graph->components_stale) {
+        graph->component_parents[vertex->id] = vertex->id;
+        graph->component_ranks[vertex->id] = 0;
+    }
+}
+
+/**
+ * @brief Join the components of the two ends of a new edge.
+ *
+ * @details
+ * While the forest is stale there is no telling whether the edge joins two
+ * components, so the count goes stale as well.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex1 One end of the edge.
+ * @param[in] vertex2 The other end.
+ */
+void join_components (graph_t *graph, vertex_t *vertex1, vertex_t *vertex2)
+{
+    unsigned int root1, root2, swap;
+    
+    if (graph->components_stale) {
+        graph->component_count_stale = TRUE;
+        
+        return;
+    }
+    root1 = find_root(graph, vertex1->id);
+    root2 = find_root(graph, vertex2->id);
+    if (root1 == root2) {
+        
+        return;
+    }
+    if (graph->component_ranks[root1] < graph->component_ranks[root2]) {
+        swap = root1;
+        root1 = root2;
+        root2 = swap;
+    }
+    graph->component_parents[root2] = root1;
+    if (graph->component_ranks[root1] == graph->component_ranks[root2]) {
+        graph->component_ranks[root1]++;
+    }
+    graph->num_components--;
+}
+
+/**
+ * @brief Account for a vertex deleted along with its edges.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] num_edges Number of edges the vertex had, in and out.
+ */
+void split_components (graph_t *graph, unsigned long num_edges)
+{
+    graph->components_stale = TRUE;
+    if (num_edges == 0) {
+        graph->num_components--;
+    } else if (num_edges > 1) {
+        graph->component_count_stale = TRUE;
+    }
+}
+
+/**
+ * @brief Rebuild the forest and the count out of the edges of the graph. The
+ *        caller must hold the graph's lock for writing.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ */
+static void rebuild_components (graph_t *graph)
+{
+    vertex_t *vertex;
+    
+    graph->num_components = graph->num_vertices;
+    for (unsigned int i = 0; i < graph->num_vertices; i++) {
+        graph->component_parents[i] = i;
+        graph->component_ranks[i] = 0;
+    }
+    graph->components_stale = FALSE;
+    graph->component_count_stale = FALSE;
+    for (unsigned int i = 0; i < graph->num_vertices; i++) {
+        vertex = graph->vertices[i];
+        for (unsigned int j = 0; j < get_adjacent_count(vertex); j++) {
+            join_components(graph, vertex, get_adjacent_vertex(vertex, j));
+        }
+    }
+}
+
+/**
+ * @brief Find the component a vertex is in. The caller must hold the graph's
+ *        lock for writing.
+ *
+ * @details
+ * The components are rebuilt first if a vertex was deleted since they were
+ * last up to date, so the roots of any two vertices can be compared till the
+ * graph changes again.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex The vertex.
+ *
+ * @return Id of the root of the vertex's component.
+ */
+unsigned int get_component_root (graph_t *graph, vertex_t *vertex)
+{
+    if (graph->components_stale) {
+        rebuild_components(graph);
+    }
+    
+    return find_root(graph, vertex->id);
+}
+
+/**
+ * @brief Return the number of connected components of the graph.
+ *
+ * @details
+ * This takes constant time unless a vertex with more than one edge was
+ * deleted since the last count, in which case the components are rebuilt in
+ * time proportional to the size of the graph. A graph whose count stays at 1
+ * has no vertex cut off from the rest, which the bug noted in graph.c can't
+ * otherwise tell.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ *
+ * @return Number of components, weakly connected ones for a directed graph.
+ */
+unsigned int get_graph_component_count (graph_t *graph)
+{
+    unsigned int num_components;
+    
+    pthread_rwlock_rdlock(&graph->lock);
+    if (!graph->component_count_stale) {
+        num_components = graph->num_components;
+        pthread_rwlock_unlock(&graph->lock);
+        
+        return num_components;
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    
+    /*
+     * Someone else may have rebuilt them while we waited for the lock.
+     */
+    pthread_rwlock_wrlock(&graph->lock);
+    if (graph->component_count_stale) {
+        rebuild_components(graph);
+    }
+    num_components = graph->num_components;
+    pthread_rwlock_unlock(&graph->lock);
+    
+    return num_components;
+}
+
+/**
+ * @brief Find out whether there is a path between two vertices, ignoring the
+ *        direction of the edges.
+ *
+ * @details
+ * This takes time proportional to the log of the number of vertices, unless
+ * a vertex was deleted since the last call, in which case the components are
+ * rebuilt first.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex1 One vertex of the graph.
+ * @param[in] vertex2 Another vertex of the graph.
+ *
+ * @return TRUE if the vertices are in the same component, FALSE otherwise or
+ *         if either vertex is NULL.
+ */
+boolean vertices_are_connected (graph_t *graph, vertex_t *vertex1,
+                                vertex_t *vertex2)
+{
+    unsigned int root1, root2;
+    boolean connected;
+    
+    if (vertex1 == NULL || vertex2 == NULL) {
+        
+        return FALSE;
+    }
+    pthread_rwlock_rdlock(&graph->lock);
+    if (graph->components_stale) {
+        pthread_rwlock_unlock(&graph->lock);
+        pthread_rwlock_wrlock(&graph->lock);
+        if (graph->components_stale) {
+            rebuild_components(graph);
+        }
+    }
+    
+    /*
+     * Readers may be walking the forest side by side, so they leave the paths
+     * as they find them. Joining by rank keeps them short.
+     */
+    root1 = vertex1->id;
+    while (graph->component_parents[root1] != root1) {
+        root1 = graph->component_parents[root1];
+    }
+    root2 = vertex2->id;
+    while (graph->component_parents[root2] != root2) {
+        root2 = graph->component_parents[root2];
+    }
+    connected = root1 == root2;
+    pthread_rwlock_unlock(&graph->lock);
+    
+    return connected;
+}
+
+/**
+ * @brief Free the forest.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ */
+void destroy_components (graph_t *graph)
+{
+    free(graph->component_parents);
+    free(graph->component_ranks);
+}
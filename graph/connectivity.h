@@ -0,0 +1,24 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file connectivity.h
+ * @author Ashutosh Grewal
+ * @date 04/01/17.
+ *
+ * @brief This header file contains the APIs the graph keeps its connected
+ *        components up to date with as it changes.
+ */
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include "public.h"
+#include "graph.h"
+#include "graph_private.h"
+
+boolean reserve_components (graph_t *, unsigned int);
+void add_component (graph_t *, vertex_t *);
+void join_components (graph_t *, vertex_t *, vertex_t *);
+void split_components (graph_t *, unsigned long);
+unsigned int get_component_root (graph_t *, vertex_t *);
+void destroy_components (graph_t *);
+
+#endif /* CONNECTIVITY_H */
@@ -0,0 +1,580 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr.c
+ * @author Ashutosh Grewal
+ * @date 01/21/17
+ *
+ * @brief This file implements the compressed sparse row (CSR) snapshot of a
+ *        graph.
+ *
+ * @details
+ * The graph stores the adjacent vertices of each vertex as pointers to
+ * separately allocated vertices, so every step of a traversal chases one.
+ * Freezing the graph copies it into three contiguous arrays: an array of
+ * offsets, an array of adjacent vertex numbers and an array of the data
+ * stored at each vertex. The snapshot is immutable, changes made to the graph
+ * after freezing it are not seen by the snapshot. A snapshot of a directed
+ * graph that keeps the edges into each vertex gets a second set of offsets
+ * and neighbors for those, found by turning the edges around. The traversal
+ * and search functions mirror the ones offered by the graph but use plain
+ * arrays for the frontier and a bitmap for the visited vertices.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "public.h"
+#include "graph.h"
+#include "csr.h"
+#include "csr_private.h"
+#include "graph_private.h"
+#include "adjacency.h"
+#include "hash_table.h"
+#include "traversal_private.h"
+
+#define BITS_PER_WORD (sizeof(unsigned long) * CHAR_BIT)
+
+/**
+ * @brief Collect all the vertices of the graph in breadth first order and
+ *        number them in that order. The caller must hold the graph's lock and
+ *        be free to use the graph's context.
+ *
+ * @details
+ * The vertices reachable from the graph's vertex come first. The ones not
+ * reachable from it follow, each part of the graph in breadth first order
+ * from the first of its vertices found in the graph's registry.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[out] num_vertices Number of vertices collected.
+ * @param[out] position Number of each vertex in the snapshot indexed by the
+ *                      vertex id, to be freed by the caller.
+ *
+ * @return Array of the vertices if successful, NULL otherwise.
+ */
+static vertex_t **collect_vertices (graph_t *graph, unsigned int *num_vertices,
+                                    unsigned int **position)
+{
+    vertex_t **vertices, *start, *adj_vertex;
+    unsigned int count, head, next;
+    traversal_ctx_t *ctx;
+    
+    *num_vertices = 0;
+    ctx = graph->ctx;
+    vertices = (vertex_t **) malloc (sizeof(vertex_t *) * (graph->num_vertices + 1));
+    *position = (unsigned int *) malloc (sizeof(unsigned int) * (graph->num_vertices + 1));
+    if (vertices == NULL || *position == NULL ||
+        !begin_context_traversal(ctx, graph->num_vertices)) {
+        goto fail;
+    }
+    
+    /*
+     * The array we're collecting in doubles up as the queue. As the registry
+     * tells us the number of vertices upfront, it never needs to grow.
+     */
+    count = 0;
+    next = 0;
+    start = graph->vertex;
+    while (start) {
+        vertices[count++] = start;
+        context_mark_visited(ctx, start->id);
+        for (head = count - 1; head < count; head++) {
+            for (unsigned int i = 0; i < get_adjacent_count(vertices[head]); i++) {
+                adj_vertex = get_adjacent_vertex(vertices[head], i);
+                if (!context_is_visited(ctx, adj_vertex->id)) {
+                    context_mark_visited(ctx, adj_vertex->id);
+                    vertices[count++] = adj_vertex;
+                }
+            }
+        }
+        
+        /*
+         * Pick up the next vertex we haven't reached yet, if any.
+         */
+        start = NULL;
+        for (; next < graph->num_vertices; next++) {
+            if (!context_is_visited(ctx, next)) {
+                start = graph->vertices[next];
+                break;
+            }
+        }
+    }
+    
+    for (unsigned int i = 0; i < count; i++) {
+        (*position)[vertices[i]->id] = i;
+    }
+    *num_vertices = count;
+    
+    return vertices;
+
+fail:
+    free(vertices);
+    free(*position);
+    *position = NULL;
+    
+    return NULL;
+}
+
+/**
+ * @brief Build the index from the data to the vertex number.
+ *
+ * @details
+ * The index stores the address of the vertex's slot in the data array, as
+ * the hash table can't store a vertex number of 0.
+ *
+ * @param[in, out] csr Pointer to the CSR snapshot.
+ * @param[in] data_hash Function to hash the opaque data.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+boolean build_csr_index (csr_graph_t *csr, data_hash_t data_hash)
+{
+    csr->data_hash = data_hash;
+    csr->index = create_hash_table(data_hash, csr->data_is_equal);
+    if (csr->index == NULL) {
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        if (!insert_to_hash_table(csr->index, csr->data[i], &csr->data[i])) {
+            
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Lay out the edges into each vertex of the snapshot of a directed
+ *        graph.
+ *
+ * @details
+ * Counting the edges into each vertex gives the offsets, and going through
+ * the vertices in order to place each edge keeps the in neighbors of every
+ * vertex sorted by number.
+ *
+ * @param[in, out] csr Pointer to the CSR snapshot.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean build_csr_in_edges (csr_graph_t *csr)
+{
+    unsigned int num_entries, *next;
+    
+    num_entries = csr->offsets[csr->num_vertices];
+    csr->in_offsets = (unsigned int *) calloc (csr->num_vertices + 1, sizeof(unsigned int));
+    csr->in_neighbors = (unsigned int *) malloc (sizeof(unsigned int) * (num_entries + 1));
+    next = (unsigned int *) malloc (sizeof(unsigned int) * (csr->num_vertices + 1));
+    if (csr->in_offsets == NULL || csr->in_neighbors == NULL || next == NULL) {
+        free(next);
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < num_entries; i++) {
+        csr->in_offsets[csr->neighbors[i] + 1]++;
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        csr->in_offsets[i + 1] += csr->in_offsets[i];
+        next[i] = csr->in_offsets[i];
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        for (unsigned int j = csr->offsets[i]; j < csr->offsets[i + 1]; j++) {
+            csr->in_neighbors[next[csr->neighbors[j]]++] = i;
+        }
+    }
+    free(next);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Build an immutable CSR snapshot of the graph.
+ *
+ * @details
+ * The vertices are numbered in breadth first order, so the graph's vertex is
+ * always vertex 0 in the snapshot. The vertices it can't reach are numbered
+ * after the ones it can, so the snapshot has every vertex of the graph.
+ * The order of the adjacent vertices is the same as in the graph, which keeps
+ * the traversals of the snapshot identical to the traversals of the graph.
+ * A directed graph is numbered following its edges out of each vertex.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ *
+ * @return Pointer to the CSR snapshot if successful, NULL otherwise.
+ */
+csr_graph_t *graph_freeze (graph_t *graph)
+{
+    csr_graph_t *csr = NULL;
+    vertex_t **vertices;
+    unsigned int num_vertices, num_entries, *position;
+    
+    /*
+     * Block changes to the graph till we're done copying it.
+     */
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    vertices = collect_vertices(graph, &num_vertices, &position);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    if (vertices == NULL) {
+        goto fail;
+    }
+    csr = (csr_graph_t *) calloc (1, sizeof(csr_graph_t));
+    if (csr == NULL) {
+        goto fail;
+    }
+    csr->num_vertices = num_vertices;
+    csr->directed = (graph->mode != GRAPH_UNDIRECTED);
+    csr->print_data = graph->print_data;
+    csr->data_is_equal = graph->data_is_equal;
+    csr->offsets = (unsigned int *) malloc (sizeof(unsigned int) * (num_vertices + 1));
+    csr->data = (void **) malloc (sizeof(void *) * (num_vertices + 1));
+    if (csr->offsets == NULL || csr->data == NULL) {
+        goto fail;
+    }
+    
+    /*
+     * First pass counts the adjacent vertices to lay out the offsets, the
+     * second one fills them in.
+     */
+    num_entries = 0;
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        csr->offsets[i] = num_entries;
+        csr->data[i] = vertices[i]->data;
+        num_entries += get_adjacent_count(vertices[i]);
+    }
+    csr->offsets[num_vertices] = num_entries;
+    csr->neighbors = (unsigned int *) malloc (sizeof(unsigned int) * (num_entries + 1));
+    if (csr->neighbors == NULL) {
+        goto fail;
+    }
+    num_entries = 0;
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        for (unsigned int j = 0; j < get_adjacent_count(vertices[i]); j++) {
+            csr->neighbors[num_entries++] =
+                position[get_adjacent_vertex(vertices[i], j)->id];
+        }
+    }
+    if (graph->mode == GRAPH_DIRECTED_IN_EDGES && !build_csr_in_edges(csr)) {
+        goto fail;
+    }
+    if (graph->data_hash != NULL && !build_csr_index(csr, graph->data_hash)) {
+        goto fail;
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    free(vertices);
+    free(position);
+    
+    return csr;
+
+fail:
+    pthread_rwlock_unlock(&graph->lock);
+    free(vertices);
+    free(position);
+    destroy_csr_graph(csr);
+    
+    return NULL;
+}
+
+/**
+ * @brief Return the number of vertices in the snapshot.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ *
+ * @return Number of vertices.
+ */
+unsigned int csr_num_vertices (csr_graph_t *csr)
+{
+    return csr->num_vertices;
+}
+
+/**
+ * @brief Return the number of edges in the snapshot.
+ *
+ * @details
+ * Each edge of an undirected graph is in the neighbors of both its vertices.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ *
+ * @return Number of edges.
+ */
+unsigned int csr_num_edges (csr_graph_t *csr)
+{
+    if (csr->directed) {
+        
+        return csr->offsets[csr->num_vertices];
+    }
+    
+    return csr->offsets[csr->num_vertices] / 2;
+}
+
+/**
+ * @brief Return the data stored at a vertex of the snapshot.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return The opaque data, NULL if there is no such vertex.
+ */
+void *csr_get_data (csr_graph_t *csr, unsigned int vertex)
+{
+    if (vertex >= csr->num_vertices) {
+        
+        return NULL;
+    }
+    
+    return csr->data[vertex];
+}
+
+/**
+ * @brief Return the adjacent vertices of a vertex of the snapshot as one
+ *        array.
+ *
+ * @details
+ * In a directed snapshot these are the vertices the edges out of the vertex
+ * go to. The array lives as long as the snapshot.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] vertex Number of the vertex.
+ * @param[out] begin Numbers of the adjacent vertices.
+ * @param[out] count Number of adjacent vertices.
+ *
+ * @return TRUE if successful, FALSE if there is no such vertex.
+ */
+boolean csr_neighbors (csr_graph_t *csr, unsigned int vertex,
+                       const unsigned int **begin, unsigned int *count)
+{
+    if (vertex >= csr->num_vertices) {
+        
+        return FALSE;
+    }
+    *begin = csr->neighbors + csr->offsets[vertex];
+    *count = csr->offsets[vertex + 1] - csr->offsets[vertex];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Return the vertices with an edge into a vertex of the snapshot as
+ *        one array.
+ *
+ * @details
+ * In an undirected snapshot these are the adjacent vertices. A directed
+ * snapshot only has them if it was frozen from a GRAPH_DIRECTED_IN_EDGES
+ * graph. The array lives as long as the snapshot.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] vertex Number of the vertex.
+ * @param[out] begin Numbers of the vertices.
+ * @param[out] count Number of vertices.
+ *
+ * @return TRUE if successful, FALSE if there is no such vertex or the
+ *         snapshot doesn't have the edges into its vertices.
+ */
+boolean csr_in_neighbors (csr_graph_t *csr, unsigned int vertex,
+                          const unsigned int **begin, unsigned int *count)
+{
+    if (!csr->directed) {
+        
+        return csr_neighbors(csr, vertex, begin, count);
+    }
+    if (vertex >= csr->num_vertices || csr->in_offsets == NULL) {
+        
+        return FALSE;
+    }
+    *begin = csr->in_neighbors + csr->in_offsets[vertex];
+    *count = csr->in_offsets[vertex + 1] - csr->in_offsets[vertex];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Find the vertex containing the given data in the snapshot.
+ *
+ * @details
+ * This uses the index if the graph was indexed and falls back to a scan of
+ * the data of the vertices otherwise, which finds the vertex whichever
+ * component it is in.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] data Opaque data for which we need to search.
+ * @param[out] vertex Number of the vertex containing the data.
+ *
+ * @return TRUE if a vertex contains the data, FALSE otherwise.
+ */
+boolean csr_find (csr_graph_t *csr, void *data, unsigned int *vertex)
+{
+    void **slot;
+    
+    if (csr->index == NULL) {
+        for (unsigned int i = 0; i < csr->num_vertices; i++) {
+            if (csr->data_is_equal(data, csr->data[i])) {
+                *vertex = i;
+                
+                return TRUE;
+            }
+        }
+        
+        return FALSE;
+    }
+    slot = lookup_in_hash_table(csr->index, data);
+    if (slot == NULL) {
+        
+        return FALSE;
+    }
+    *vertex = (unsigned int) (slot - csr->data);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Walk the whole snapshot starting from vertex 0.
+ *
+ * @details
+ * The frontier is kept in a single array. A breadth first walk takes vertices
+ * from the front of the array while a depth first walk takes them from the
+ * back, which gives the same visiting orders as the queue and the stack used
+ * by the graph. A vertex is marked visited when it is added to the frontier.
+ * Once the frontier runs out, the walk starts again from the lowest numbered
+ * vertex not visited yet, so vertices in other components, or ones that
+ * can't be reached along the edges of a directed snapshot, are walked too.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] depth_first TRUE to walk depth first, FALSE for breadth first.
+ * @param[in] data Opaque data we're searching for, only used if print is FALSE.
+ * @param[in] print TRUE to print every vertex instead of searching.
+ * @param[out] vertex Number of the vertex containing the data.
+ *
+ * @return TRUE if the data was found, FALSE otherwise.
+ */
+static boolean csr_walk (csr_graph_t *csr, boolean depth_first, void *data,
+                         boolean print, unsigned int *vertex)
+{
+    unsigned int *frontier, head, tail, current, adj_vertex;
+    unsigned long *visited;
+    boolean found = FALSE;
+    
+    if (csr->num_vertices == 0) {
+        
+        return FALSE;
+    }
+    frontier = (unsigned int *) malloc (sizeof(unsigned int) * csr->num_vertices);
+    visited = (unsigned long *) calloc (csr->num_vertices / BITS_PER_WORD + 1,
+                                        sizeof(unsigned long));
+    if (frontier == NULL || visited == NULL) {
+        goto done;
+    }
+    
+    head = tail = 0;
+    for (unsigned int root = 0; root < csr->num_vertices && !found; root++) {
+        if (visited[root / BITS_PER_WORD] & (1UL << (root % BITS_PER_WORD))) {
+            continue;
+        }
+        visited[root / BITS_PER_WORD] |= 1UL << (root % BITS_PER_WORD);
+        frontier[tail++] = root;
+        while (head < tail) {
+            current = depth_first ? frontier[--tail] : frontier[head++];
+            if (print) {
+                csr->print_data(csr->data[current]);
+            } else if (csr->data_is_equal(data, csr->data[current])) {
+                *vertex = current;
+                found = TRUE;
+                break;
+            }
+            for (unsigned int i = csr->offsets[current]; i < csr->offsets[current + 1]; i++) {
+                adj_vertex = csr->neighbors[i];
+                if (visited[adj_vertex / BITS_PER_WORD] & (1UL << (adj_vertex % BITS_PER_WORD))) {
+                    continue;
+                }
+                visited[adj_vertex / BITS_PER_WORD] |= 1UL << (adj_vertex % BITS_PER_WORD);
+                frontier[tail++] = adj_vertex;
+            }
+        }
+    }
+
+done:
+    free(frontier);
+    free(visited);
+    
+    return found;
+}
+
+/**
+ * @brief Find a vertex with the given data in the snapshot traversing in a
+ *        breadth first fashion.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] data Opaque data for which we need to search.
+ * @param[out] vertex Number of the vertex containing the data.
+ *
+ * @return TRUE if a vertex contains the data, FALSE otherwise.
+ */
+boolean csr_breadth_first_search (csr_graph_t *csr, void *data, unsigned int *vertex)
+{
+    return csr_walk(csr, FALSE, data, FALSE, vertex);
+}
+
+/**
+ * @brief Find a vertex with the given data in the snapshot traversing in a
+ *        depth first fashion.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] data Opaque data for which we need to search.
+ * @param[out] vertex Number of the vertex containing the data.
+ *
+ * @return TRUE if a vertex contains the data, FALSE otherwise.
+ */
+boolean csr_depth_first_search (csr_graph_t *csr, void *data, unsigned int *vertex)
+{
+    return csr_walk(csr, TRUE, data, FALSE, vertex);
+}
+
+/**
+ * @brief Traverse the snapshot in a breadth first fashion printing the data
+ *        of every vertex.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ */
+void csr_breadth_first_traversal (csr_graph_t *csr)
+{
+    csr_walk(csr, FALSE, NULL, TRUE, NULL);
+}
+
+/**
+ * @brief Traverse the snapshot in a depth first fashion printing the data
+ *        of every vertex.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ */
+void csr_depth_first_traversal (csr_graph_t *csr)
+{
+    csr_walk(csr, TRUE, NULL, TRUE, NULL);
+}
+
+/**
+ * @brief Destroy the CSR snapshot. The data stored at the vertices is owned
+ *        by the user and is not freed, unless it's in the file the snapshot
+ *        was loaded from, which is unmapped.
+ *
+ * @param[in, out] csr Pointer to the CSR snapshot.
+ */
+void destroy_csr_graph (csr_graph_t *csr)
+{
+    if (csr == NULL) {
+        
+        return;
+    }
+    destroy_hash_table(csr->index);
+    if (csr->mapping) {
+        munmap(csr->mapping, csr->mapping_size);
+    } else {
+        free(csr->offsets);
+        free(csr->neighbors);
+        free(csr->in_offsets);
+        free(csr->in_neighbors);
+        free(csr->original_ids);
+    }
+    free(csr->data);
+    free(csr);
+}
@@ -0,0 +1,70 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr.h
+ * @date 01/21/17
+ * @author Ashutosh Grewal
+ *
+ * @brief Header file containing APIs to the compressed sparse row (CSR)
+ *        snapshot of a graph and some public structure declarations (the
+ *        definitions of these structures is not visible to the rest of the
+ *        system to prevent them from manipulating without using APIs).
+ */
+#ifndef CSR_H
+#define CSR_H
+
+#include <limits.h>
+#include <stddef.h>
+#include "public.h"
+#include "graph.h"
+
+/**
+ * Level and parent of the vertices a search couldn't reach.
+ */
+#define CSR_UNREACHED UINT_MAX
+
+/**
+ * @brief How to renumber the vertices of a snapshot.
+ */
+typedef enum csr_order_e {
+    CSR_ORDER_BFS, /**< Breadth first from vertex 0, then from the lowest
+                        numbered vertex not reached yet. */
+    CSR_ORDER_RCM, /**< Reverse Cuthill-McKee, which keeps the numbers of
+                        adjacent vertices close together. */
+    CSR_ORDER_DEGREE /**< Most adjacent vertices first. */
+} csr_order_t;
+
+typedef struct csr_graph_s csr_graph_t;
+typedef size_t (*serialize_data_t) (void *, void *, size_t);
+
+csr_graph_t *graph_freeze (graph_t *);
+unsigned int csr_num_vertices (csr_graph_t *);
+unsigned int csr_num_edges (csr_graph_t *);
+void *csr_get_data (csr_graph_t *, unsigned int);
+boolean csr_neighbors (csr_graph_t *, unsigned int, const unsigned int **,
+                       unsigned int *);
+boolean csr_in_neighbors (csr_graph_t *, unsigned int, const unsigned int **,
+                          unsigned int *);
+boolean csr_find (csr_graph_t *, void *, unsigned int *);
+boolean csr_breadth_first_search (csr_graph_t *, void *, unsigned int *);
+boolean csr_depth_first_search (csr_graph_t *, void *, unsigned int *);
+void csr_breadth_first_traversal (csr_graph_t *);
+void csr_depth_first_traversal (csr_graph_t *);
+boolean csr_parallel_breadth_first_search (csr_graph_t *, unsigned int, unsigned int,
+                                           unsigned int *, unsigned int *);
+boolean csr_connected_components (csr_graph_t *, unsigned int, unsigned int *,
+                                  unsigned int *);
+boolean csr_pagerank (csr_graph_t *, float, float, unsigned int, unsigned int,
+                      float *, unsigned int *);
+void csr_degree_centrality (csr_graph_t *, float *);
+boolean csr_label_propagation (csr_graph_t *, unsigned int, unsigned int,
+                               unsigned int *, unsigned int *);
+csr_graph_t *csr_reorder (csr_graph_t *, csr_order_t);
+csr_graph_t *csr_permute (csr_graph_t *, const unsigned int *);
+unsigned int csr_original_id (csr_graph_t *, unsigned int);
+boolean csr_save (csr_graph_t *, const char *, serialize_data_t);
+boolean graph_save (graph_t *, const char *, serialize_data_t);
+csr_graph_t *graph_load_mmap (const char *, print_data_t, data_is_equal_t,
+                              data_hash_t);
+void destroy_csr_graph (csr_graph_t *);
+
+#endif /* CSR_H */
@@ -0,0 +1,637 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_analytics.c
+ * @author Ashutosh Grewal
+ * @date 04/10/17
+ *
+ * @brief This file implements PageRank, degree centrality and label
+ *        propagation over the CSR snapshot.
+ *
+ * @details
+ * PageRank and label propagation go over the snapshot again and again until
+ * the values of the vertices settle. Each round pulls the values of the
+ * vertices with an edge into each vertex, so every vertex is written by the
+ * one thread owning its row and the threads need no locks or atomics. The
+ * values are kept in two arrays, one read by a round and one written by it,
+ * which swap places for the next one. The threads split the rows so that
+ * each one gets about the same number of vertices and edges, which keeps the
+ * threads busy on graphs where a few vertices have most of the edges. They are
+ * started for every round, and should one fail to start, the caller does its
+ * share instead.
+ *
+ * The loops over the neighbors of a vertex add up four values at a time in
+ * separate sums. The additions then don't wait on each other, and the
+ * compiler is free to turn the loop into vector gathers where the machine has
+ * them.
+ *
+ * A directed snapshot without its in edges gets a copy of them for the
+ * duration of the call.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "public.h"
+#include "csr.h"
+#include "csr_private.h"
+
+/**
+ * @brief The edges each vertex pulls the values of other vertices along.
+ */
+typedef struct pull_edges_s {
+    const unsigned int *offsets; /**< Start of each vertex's edges. */
+    const unsigned int *neighbors; /**< Vertices at the other end. */
+    unsigned int *built_offsets; /**< offsets, if built for this call. */
+    unsigned int *built_neighbors; /**< neighbors, if built for this call. */
+} pull_edges_t;
+
+/**
+ * @brief What a PageRank thread shares with the others, along with which
+ *        vertices it looks after.
+ */
+typedef struct rank_thread_s {
+    const unsigned int *offsets; /**< Start of the in edges of each vertex. */
+    const unsigned int *neighbors; /**< Vertices the in edges come from. */
+    const float *inverse_degrees; /**< 1 over the out degree of each vertex,
+                                       0 for the vertices without edges
+                                       out. */
+    const float *ranks; /**< Ranks from the last round. */
+    const float *contributions; /**< Share of its rank each vertex gives
+                                     every vertex its edges go to. */
+    float *next_ranks; /**< Ranks of this round. */
+    float *next_contributions; /**< Shares for the next round. */
+    float base; /**< Rank every vertex gets whatever its edges. */
+    float damping; /**< Share of the rank that follows the edges. */
+    unsigned int first; /**< First vertex of the thread. */
+    unsigned int last; /**< One past the last vertex of the thread. */
+    double change; /**< How much the ranks of the thread's vertices moved. */
+    double dangling; /**< Rank of the thread's vertices without edges out. */
+} rank_thread_t;
+
+/**
+ * @brief What a label propagation thread shares with the others, along with
+ *        which vertices it looks after.
+ */
+typedef struct label_thread_s {
+    const unsigned int *offsets; /**< Start of the edges of each vertex. */
+    const unsigned int *neighbors; /**< Vertices at the other end. */
+    const unsigned int *in_offsets; /**< Start of the in edges of each
+                                         vertex, NULL if undirected. */
+    const unsigned int *in_neighbors; /**< Vertices the in edges come from. */
+    const unsigned int *labels; /**< Labels from the last round. */
+    unsigned int *next_labels; /**< Labels of this round. */
+    unsigned int *slot_labels; /**< Label in each slot of the counting
+                                    table. */
+    unsigned int *counts; /**< Times the label of each slot was seen around
+                               a vertex, 0 for an empty slot. */
+    unsigned int *seen; /**< Slots with a count. */
+    unsigned int mask; /**< Number of slots in the counting table less one. */
+    unsigned int first; /**< First vertex of the thread. */
+    unsigned int last; /**< One past the last vertex of the thread. */
+    unsigned long changed; /**< Number of the thread's vertices whose label
+                                changed. */
+} label_thread_t;
+
+/**
+ * @brief Run a pass on all the threads and wait for them to finish.
+ *
+ * @details
+ * Should a thread fail to start, the caller does its share instead.
+ *
+ * @param[in, out] threads Each thread's share of the work.
+ * @param[in] size Size of a thread's share.
+ * @param[out] thread_ids Room for the thread ids.
+ * @param[out] started Room to note which threads started.
+ * @param[in] num_threads Number of threads.
+ * @param[in] pass The pass to run.
+ */
+static void run_pass (void *threads, size_t size, pthread_t *thread_ids,
+                      boolean *started, unsigned int num_threads,
+                      void *(*pass) (void *))
+{
+    char *shares = (char *) threads;
+    
+    for (unsigned int i = 1; i < num_threads; i++) {
+        started[i] = (pthread_create(&thread_ids[i], NULL, pass,
+                                     shares + size * i) == 0);
+    }
+    pass(shares);
+    for (unsigned int i = 1; i < num_threads; i++) {
+        if (started[i]) {
+            pthread_join(thread_ids[i], NULL);
+        } else {
+            pass(shares + size * i);
+        }
+    }
+}
+
+/**
+ * @brief Find where a thread's rows start.
+ *
+ * @details
+ * Each thread gets about the same share of the vertices plus their edges,
+ * found with a binary search over the offsets.
+ *
+ * @param[in] offsets Start of each vertex's edges.
+ * @param[in] num_vertices Number of vertices.
+ * @param[in] thread Number of the thread, num_threads for the end of the
+ *                   last thread's rows.
+ * @param[in] num_threads Number of threads.
+ *
+ * @return First vertex of the thread.
+ */
+static unsigned int split_rows (const unsigned int *offsets, unsigned int num_vertices,
+                                unsigned int thread, unsigned int num_threads)
+{
+    unsigned long target, low = 0, high = num_vertices, middle;
+    
+    target = ((unsigned long) offsets[num_vertices] + num_vertices) * thread /
+             num_threads;
+    while (low < high) {
+        middle = (low + high) / 2;
+        if ((unsigned long) offsets[middle] + middle < target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    return (unsigned int) low;
+}
+
+/**
+ * @brief Find the edges into each vertex of the snapshot, building them if
+ *        the snapshot doesn't have them.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[out] edges The edges into each vertex.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean find_in_edges (csr_graph_t *csr, pull_edges_t *edges)
+{
+    csr_graph_t reversed;
+    
+    memset(edges, 0, sizeof(pull_edges_t));
+    if (!csr->directed) {
+        edges->offsets = csr->offsets;
+        edges->neighbors = csr->neighbors;
+        
+        return TRUE;
+    }
+    if (csr->in_offsets) {
+        edges->offsets = csr->in_offsets;
+        edges->neighbors = csr->in_neighbors;
+        
+        return TRUE;
+    }
+    reversed = *csr;
+    if (!build_csr_in_edges(&reversed)) {
+        free(reversed.in_offsets);
+        free(reversed.in_neighbors);
+        
+        return FALSE;
+    }
+    edges->offsets = edges->built_offsets = reversed.in_offsets;
+    edges->neighbors = edges->built_neighbors = reversed.in_neighbors;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Free the edges built for a call.
+ *
+ * @param[in, out] edges The edges into each vertex.
+ */
+static void free_in_edges (pull_edges_t *edges)
+{
+    free(edges->built_offsets);
+    free(edges->built_neighbors);
+}
+
+/**
+ * @brief Work out the new ranks of the thread's vertices.
+ *
+ * @param[in, out] arg The thread's share of the work.
+ *
+ * @return NULL.
+ */
+static void *rank_thread (void *arg)
+{
+    rank_thread_t *thread = (rank_thread_t *) arg;
+    const unsigned int *neighbors = thread->neighbors;
+    const float *contributions = thread->contributions;
+    unsigned int edge, end;
+    float sum0, sum1, sum2, sum3, rank;
+    double change = 0, dangling = 0;
+    
+    for (unsigned int vertex = thread->first; vertex < thread->last; vertex++) {
+        edge = thread->offsets[vertex];
+        end = thread->offsets[vertex + 1];
+        sum0 = sum1 = sum2 = sum3 = 0;
+        for (; edge + 4 <= end; edge += 4) {
+            sum0 += contributions[neighbors[edge]];
+            sum1 += contributions[neighbors[edge + 1]];
+            sum2 += contributions[neighbors[edge + 2]];
+            sum3 += contributions[neighbors[edge + 3]];
+        }
+        for (; edge < end; edge++) {
+            sum0 += contributions[neighbors[edge]];
+        }
+        rank = thread->base + thread->damping * ((sum0 + sum1) + (sum2 + sum3));
+        change += fabsf(rank - thread->ranks[vertex]);
+        thread->next_ranks[vertex] = rank;
+        thread->next_contributions[vertex] = rank * thread->inverse_degrees[vertex];
+        if (thread->inverse_degrees[vertex] == 0) {
+            dangling += rank;
+        }
+    }
+    thread->change = change;
+    thread->dangling = dangling;
+    
+    return NULL;
+}
+
+/**
+ * @brief Rank the vertices of the snapshot by PageRank using many threads.
+ *
+ * @details
+ * A vertex's rank is the chance of a random walk being at it. At every step
+ * the walk follows one of the edges out of the vertex it's at with chance
+ * damping, and jumps to a vertex picked at random otherwise, as it also does
+ * from a vertex without edges out. The ranks add up to 1. The edges of an
+ * undirected snapshot go both ways. The rounds stop once the ranks move by
+ * less than tolerance in all, or after max_iterations rounds.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] damping Chance of following an edge, usually 0.85.
+ * @param[in] tolerance How little the ranks must move in a round to stop.
+ * @param[in] max_iterations Most rounds to run.
+ * @param[in] num_threads Number of threads to rank with, including the
+ *                        calling thread.
+ * @param[out] ranks Array of csr_num_vertices entries for the ranks.
+ * @param[out] iterations Number of rounds run, NULL if not needed.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean csr_pagerank (csr_graph_t *csr, float damping, float tolerance,
+                      unsigned int max_iterations, unsigned int num_threads,
+                      float *ranks, unsigned int *iterations)
+{
+    pull_edges_t edges;
+    rank_thread_t *threads = NULL;
+    pthread_t *thread_ids = NULL;
+    boolean *started = NULL, ranked = FALSE;
+    float *buffers[2] = {NULL, NULL}, *contributions[2] = {NULL, NULL};
+    float *inverse_degrees = NULL, *swap;
+    unsigned int n = csr->num_vertices, degree, rounds = 0;
+    double change, dangling = 0;
+    
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    if (!find_in_edges(csr, &edges)) {
+        
+        return FALSE;
+    }
+    threads = (rank_thread_t *) malloc (sizeof(rank_thread_t) * num_threads);
+    thread_ids = (pthread_t *) malloc (sizeof(pthread_t) * num_threads);
+    started = (boolean *) calloc (num_threads, sizeof(boolean));
+    buffers[1] = (float *) malloc (sizeof(float) * (n + 1));
+    contributions[0] = (float *) malloc (sizeof(float) * (n + 1));
+    contributions[1] = (float *) malloc (sizeof(float) * (n + 1));
+    inverse_degrees = (float *) malloc (sizeof(float) * (n + 1));
+    if (threads == NULL || thread_ids == NULL || started == NULL ||
+        buffers[1] == NULL || contributions[0] == NULL || contributions[1] == NULL ||
+        inverse_degrees == NULL) {
+        goto done;
+    }
+    buffers[0] = ranks;
+    
+    for (unsigned int i = 0; i < n; i++) {
+        degree = csr->offsets[i + 1] - csr->offsets[i];
+        inverse_degrees[i] = degree ? 1.0f / degree : 0;
+        ranks[i] = 1.0f / n;
+        contributions[0][i] = ranks[i] * inverse_degrees[i];
+        if (degree == 0) {
+            dangling += ranks[i];
+        }
+    }
+    for (unsigned int i = 0; i < num_threads; i++) {
+        threads[i].offsets = edges.offsets;
+        threads[i].neighbors = edges.neighbors;
+        threads[i].inverse_degrees = inverse_degrees;
+        threads[i].damping = damping;
+        threads[i].first = split_rows(edges.offsets, n, i, num_threads);
+        threads[i].last = split_rows(edges.offsets, n, i + 1, num_threads);
+    }
+    
+    while (n > 0 && rounds < max_iterations) {
+        for (unsigned int i = 0; i < num_threads; i++) {
+            threads[i].base = (float) ((1 - damping + damping * dangling) / n);
+            threads[i].ranks = buffers[0];
+            threads[i].contributions = contributions[0];
+            threads[i].next_ranks = buffers[1];
+            threads[i].next_contributions = contributions[1];
+        }
+        run_pass(threads, sizeof(rank_thread_t), thread_ids, started, num_threads,
+                 rank_thread);
+        rounds++;
+        change = 0;
+        dangling = 0;
+        for (unsigned int i = 0; i < num_threads; i++) {
+            change += threads[i].change;
+            dangling += threads[i].dangling;
+        }
+        swap = buffers[0];
+        buffers[0] = buffers[1];
+        buffers[1] = swap;
+        swap = contributions[0];
+        contributions[0] = contributions[1];
+        contributions[1] = swap;
+        if (change < tolerance) {
+            break;
+        }
+    }
+    
+    /*
+     * The last round may have left the ranks in our own buffer.
+     */
+    if (buffers[0] != ranks) {
+        memcpy(ranks, buffers[0], sizeof(float) * n);
+        buffers[1] = buffers[0];
+    }
+    if (iterations) {
+        *iterations = rounds;
+    }
+    ranked = TRUE;
+
+done:
+    free_in_edges(&edges);
+    free(threads);
+    free(thread_ids);
+    free(started);
+    free(buffers[1]);
+    free(contributions[0]);
+    free(contributions[1]);
+    free(inverse_degrees);
+    
+    return ranked;
+}
+
+/**
+ * @brief Work out the degree centrality of every vertex of the snapshot.
+ *
+ * @details
+ * A vertex's degree centrality is its number of edges over the number of
+ * other vertices. The edges into a vertex of a directed snapshot count along
+ * with the edges out of it.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[out] centrality Array of csr_num_vertices entries for the degree
+ *                        centralities.
+ */
+void csr_degree_centrality (csr_graph_t *csr, float *centrality)
+{
+    unsigned int n = csr->num_vertices;
+    float scale = n > 1 ? 1.0f / (n - 1) : 0;
+    
+    for (unsigned int i = 0; i < n; i++) {
+        centrality[i] = (float) (csr->offsets[i + 1] - csr->offsets[i]);
+    }
+    if (csr->directed && csr->in_offsets) {
+        for (unsigned int i = 0; i < n; i++) {
+            centrality[i] += (float) (csr->in_offsets[i + 1] - csr->in_offsets[i]);
+        }
+    } else if (csr->directed) {
+        for (unsigned int i = 0; i < csr->offsets[n]; i++) {
+            centrality[csr->neighbors[i]] += 1;
+        }
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        centrality[i] *= scale;
+    }
+}
+
+/**
+ * @brief Find the most labels one of the thread's vertices can count.
+ *
+ * @param[in] thread The thread's share of the work.
+ *
+ * @return One more than the most edges of any of the thread's vertices.
+ */
+static unsigned int most_labels (const label_thread_t *thread)
+{
+    unsigned int most = 0, degree;
+    
+    for (unsigned int vertex = thread->first; vertex < thread->last; vertex++) {
+        degree = thread->offsets[vertex + 1] - thread->offsets[vertex];
+        if (thread->in_offsets) {
+            degree += thread->in_offsets[vertex + 1] - thread->in_offsets[vertex];
+        }
+        if (degree > most) {
+            most = degree;
+        }
+    }
+    
+    return most + 1;
+}
+
+/**
+ * @brief Count a label seen around a vertex.
+ *
+ * @details
+ * The labels are counted in a small table with open addressing, at least
+ * twice as big as the most labels a vertex can count, so a vertex only
+ * touches as many slots as it has edges whatever the size of the snapshot.
+ *
+ * @param[in, out] thread The thread working on the vertex.
+ * @param[in] label The label.
+ * @param[in, out] num_seen Number of slots in seen.
+ */
+static inline void count_label (label_thread_t *thread, unsigned int label,
+                                unsigned int *num_seen)
+{
+    unsigned int slot;
+    
+    for (slot = (label * 2654435761u) & thread->mask;
+         thread->counts[slot] && thread->slot_labels[slot] != label;
+         slot = (slot + 1) & thread->mask);
+    if (thread->counts[slot]++ == 0) {
+        thread->slot_labels[slot] = label;
+        thread->seen[(*num_seen)++] = slot;
+    }
+}
+
+/**
+ * @brief Give each of the thread's vertices the label most common around it.
+ *
+ * @details
+ * A vertex counts its own label along with those of its adjacent vertices,
+ * which keeps two halves of a bipartite graph from swapping labels forever.
+ * Ties go to the smallest label, so the labels don't depend on the order of
+ * the edges or the timing of the threads.
+ *
+ * @param[in, out] arg The thread's share of the work.
+ *
+ * @return NULL.
+ */
+static void *label_thread (void *arg)
+{
+    label_thread_t *thread = (label_thread_t *) arg;
+    unsigned int num_seen, best, slot;
+    unsigned long changed = 0;
+    
+    for (unsigned int vertex = thread->first; vertex < thread->last; vertex++) {
+        num_seen = 0;
+        count_label(thread, thread->labels[vertex], &num_seen);
+        for (unsigned int i = thread->offsets[vertex]; i < thread->offsets[vertex + 1]; i++) {
+            count_label(thread, thread->labels[thread->neighbors[i]], &num_seen);
+        }
+        if (thread->in_offsets) {
+            for (unsigned int i = thread->in_offsets[vertex];
+                 i < thread->in_offsets[vertex + 1]; i++) {
+                count_label(thread, thread->labels[thread->in_neighbors[i]], &num_seen);
+            }
+        }
+        best = thread->seen[0];
+        for (unsigned int i = 1; i < num_seen; i++) {
+            slot = thread->seen[i];
+            if (thread->counts[slot] > thread->counts[best] ||
+                (thread->counts[slot] == thread->counts[best] &&
+                 thread->slot_labels[slot] < thread->slot_labels[best])) {
+                best = slot;
+            }
+        }
+        for (unsigned int i = 0; i < num_seen; i++) {
+            thread->counts[thread->seen[i]] = 0;
+        }
+        thread->next_labels[vertex] = thread->slot_labels[best];
+        changed += (thread->slot_labels[best] != thread->labels[vertex]);
+    }
+    thread->changed = changed;
+    
+    return NULL;
+}
+
+/**
+ * @brief Find communities of the snapshot by label propagation using many
+ *        threads.
+ *
+ * @details
+ * Every vertex starts with its own number as its label. In every round, all
+ * the vertices at once take the label most common among themselves and
+ * their adjacent vertices, so tightly knit groups of vertices end up sharing
+ * one. The edges of a directed snapshot are taken as going both ways. The
+ * rounds stop once no label changes, or after max_iterations rounds. Each
+ * thread counts the labels in a table sized by the most edges of one of its
+ * vertices, so the memory the threads need doesn't grow with the snapshot.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] max_iterations Most rounds to run.
+ * @param[in] num_threads Number of threads to propagate with, including the
+ *                        calling thread.
+ * @param[out] labels Array of csr_num_vertices entries for the label of
+ *                    every vertex.
+ * @param[out] iterations Number of rounds run, NULL if not needed.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean csr_label_propagation (csr_graph_t *csr, unsigned int max_iterations,
+                               unsigned int num_threads, unsigned int *labels,
+                               unsigned int *iterations)
+{
+    pull_edges_t edges;
+    label_thread_t *threads = NULL;
+    pthread_t *thread_ids = NULL;
+    boolean *started = NULL, propagated = FALSE;
+    unsigned int *buffers[2] = {labels, NULL}, *swap;
+    unsigned int n = csr->num_vertices, rounds = 0, most, slots;
+    unsigned long changed;
+    
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    if (!find_in_edges(csr, &edges)) {
+        
+        return FALSE;
+    }
+    threads = (label_thread_t *) calloc (num_threads, sizeof(label_thread_t));
+    thread_ids = (pthread_t *) malloc (sizeof(pthread_t) * num_threads);
+    started = (boolean *) calloc (num_threads, sizeof(boolean));
+    buffers[1] = (unsigned int *) malloc (sizeof(unsigned int) * (n + 1));
+    if (threads == NULL || thread_ids == NULL || started == NULL || buffers[1] == NULL) {
+        goto done;
+    }
+    for (unsigned int i = 0; i < num_threads; i++) {
+        threads[i].offsets = csr->offsets;
+        threads[i].neighbors = csr->neighbors;
+        if (csr->directed) {
+            threads[i].in_offsets = edges.offsets;
+            threads[i].in_neighbors = edges.neighbors;
+        }
+        threads[i].first = split_rows(csr->offsets, n, i, num_threads);
+        threads[i].last = split_rows(csr->offsets, n, i + 1, num_threads);
+        most = most_labels(&threads[i]);
+        for (slots = 2; slots < 2 * most; slots *= 2);
+        threads[i].mask = slots - 1;
+        threads[i].slot_labels = (unsigned int *) malloc (sizeof(unsigned int) * slots);
+        threads[i].counts = (unsigned int *) calloc (slots, sizeof(unsigned int));
+        threads[i].seen = (unsigned int *) malloc (sizeof(unsigned int) * most);
+        if (threads[i].slot_labels == NULL || threads[i].counts == NULL ||
+            threads[i].seen == NULL) {
+            goto done;
+        }
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        labels[i] = i;
+    }
+    
+    while (n > 0 && rounds < max_iterations) {
+        for (unsigned int i = 0; i < num_threads; i++) {
+            threads[i].labels = buffers[0];
+            threads[i].next_labels = buffers[1];
+        }
+        run_pass(threads, sizeof(label_thread_t), thread_ids, started, num_threads,
+                 label_thread);
+        rounds++;
+        changed = 0;
+        for (unsigned int i = 0; i < num_threads; i++) {
+            changed += threads[i].changed;
+        }
+        swap = buffers[0];
+        buffers[0] = buffers[1];
+        buffers[1] = swap;
+        if (changed == 0) {
+            break;
+        }
+    }
+    
+    /*
+     * The last round may have left the labels in our own buffer.
+     */
+    if (buffers[0] != labels) {
+        memcpy(labels, buffers[0], sizeof(unsigned int) * n);
+        buffers[1] = buffers[0];
+    }
+    if (iterations) {
+        *iterations = rounds;
+    }
+    propagated = TRUE;
+
+done:
+    if (threads) {
+        for (unsigned int i = 0; i < num_threads; i++) {
+            free(threads[i].slot_labels);
+            free(threads[i].counts);
+            free(threads[i].seen);
+        }
+    }
+    free_in_edges(&edges);
+    free(threads);
+    free(thread_ids);
+    free(started);
+    free(buffers[1]);
+    
+    return propagated;
+}
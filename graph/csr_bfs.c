@@ -0,0 +1,533 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_bfs.c
+ * @author Ashutosh Grewal
+ * @date 02/18/17
+ *
+ * @brief This file implements a multi-threaded, direction optimizing breadth
+ *        first search over the CSR snapshot.
+ *
+ * @details
+ * The search goes level by level. A top down step has every thread take a
+ * share of the frontier and claim the unvisited adjacent vertices of its
+ * vertices, which is cheap while the frontier is small. Once the frontier
+ * has more edges than the rest of the graph, a bottom up step is cheaper:
+ * every thread takes a share of the unvisited vertices and looks for an
+ * adjacent vertex in the frontier, stopping at the first one it finds. The
+ * frontier is an array of vertices for the top down steps and a bitmap for
+ * the bottom up ones. We switch back to top down once the frontier gets
+ * small again. A bottom up step looks for the frontier among the vertices
+ * with an edge into each vertex, so a directed snapshot without its in edges
+ * is searched top down all the way.
+ *
+ * The threads are started once per search and meet at a barrier after every
+ * step, where the calling thread, which also does its share of the work,
+ * decides on the next step. POSIX barriers aren't available everywhere, so we
+ * build one out of a mutex and a condition variable.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include "public.h"
+#include "csr.h"
+#include "csr_private.h"
+
+#define BITS_PER_WORD (sizeof(unsigned long) * CHAR_BIT)
+
+/**
+ * Switch to bottom up once the frontier's edges are more than the unexplored
+ * edges divided by this.
+ */
+#define BFS_ALPHA 14
+
+/**
+ * Switch back to top down once the frontier has fewer vertices than the
+ * graph's vertices divided by this.
+ */
+#define BFS_BETA 24
+
+/**
+ * Number of vertices a thread claims before adding them to the next frontier.
+ */
+#define BFS_BATCH 256
+
+/**
+ * @brief A reusable barrier for a fixed number of threads.
+ */
+typedef struct bfs_barrier_s {
+    pthread_mutex_t lock; /**< Protects the rest of the barrier. */
+    pthread_cond_t all_arrived; /**< Signalled when the last thread arrives. */
+    unsigned int num_threads; /**< Number of threads meeting at the barrier. */
+    unsigned int arrived; /**< Number of threads waiting at the barrier. */
+    unsigned int cycle; /**< Number of times the barrier has opened. */
+} bfs_barrier_t;
+
+/**
+ * @brief What each thread found during a step.
+ */
+typedef struct bfs_count_s {
+    unsigned long vertices; /**< Number of vertices claimed. */
+    unsigned long edges; /**< Sum of the degrees of the vertices claimed. */
+} bfs_count_t;
+
+/**
+ * @brief The state of a search, shared by all its threads.
+ */
+typedef struct bfs_state_s {
+    csr_graph_t *csr; /**< The snapshot being searched. */
+    unsigned int *levels; /**< Level of each vertex. */
+    unsigned int *parents; /**< Parent of each vertex. */
+    unsigned int num_threads; /**< Number of threads, including the caller. */
+    bfs_barrier_t barrier; /**< Where the threads meet after every step. */
+    boolean done; /**< TRUE once there are no more steps. */
+    boolean bottom_up; /**< TRUE if the current step is bottom up. */
+    unsigned int level; /**< Level of the frontier. */
+    unsigned int *frontier; /**< Frontier of a top down step. */
+    unsigned int frontier_size; /**< Number of vertices in frontier. */
+    unsigned int *next; /**< Frontier a top down step is building. */
+    unsigned int next_size; /**< Number of vertices in next. */
+    unsigned long *frontier_bits; /**< Frontier of a bottom up step. */
+    unsigned long *next_bits; /**< Frontier a bottom up step is building. */
+    unsigned int num_words; /**< Number of words in each bitmap. */
+    bfs_count_t *counts; /**< What each thread found during the step. */
+} bfs_state_t;
+
+/**
+ * @brief Argument of each thread.
+ */
+typedef struct bfs_thread_s {
+    bfs_state_t *state; /**< The search. */
+    unsigned int id; /**< Number of the thread, 0 being the caller. */
+} bfs_thread_t;
+
+/**
+ * @brief Initialize the barrier.
+ *
+ * @param[out] barrier The barrier.
+ * @param[in] num_threads Number of threads meeting at the barrier.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean init_barrier (bfs_barrier_t *barrier, unsigned int num_threads)
+{
+    if (pthread_mutex_init(&barrier->lock, NULL) != 0) {
+        
+        return FALSE;
+    }
+    if (pthread_cond_init(&barrier->all_arrived, NULL) != 0) {
+        pthread_mutex_destroy(&barrier->lock);
+        
+        return FALSE;
+    }
+    barrier->num_threads = num_threads;
+    barrier->arrived = 0;
+    barrier->cycle = 0;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Wait till all the threads arrive at the barrier.
+ *
+ * @param[in, out] barrier The barrier.
+ */
+static void wait_at_barrier (bfs_barrier_t *barrier)
+{
+    unsigned int cycle;
+    
+    pthread_mutex_lock(&barrier->lock);
+    cycle = barrier->cycle;
+    if (++barrier->arrived == barrier->num_threads) {
+        barrier->arrived = 0;
+        barrier->cycle++;
+        pthread_cond_broadcast(&barrier->all_arrived);
+    } else {
+        while (cycle == barrier->cycle) {
+            pthread_cond_wait(&barrier->all_arrived, &barrier->lock);
+        }
+    }
+    pthread_mutex_unlock(&barrier->lock);
+}
+
+/**
+ * @brief Destroy the barrier.
+ *
+ * @param[in, out] barrier The barrier.
+ */
+static void destroy_barrier (bfs_barrier_t *barrier)
+{
+    pthread_cond_destroy(&barrier->all_arrived);
+    pthread_mutex_destroy(&barrier->lock);
+}
+
+/**
+ * @brief Return the degree of a vertex.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return Number of adjacent vertices.
+ */
+static inline unsigned int degree (csr_graph_t *csr, unsigned int vertex)
+{
+    return csr->offsets[vertex + 1] - csr->offsets[vertex];
+}
+
+/**
+ * @brief Add the vertices a thread claimed to the next frontier.
+ *
+ * @param[in, out] state The search.
+ * @param[in] claimed The vertices.
+ * @param[in] count Number of vertices.
+ */
+static void add_to_next (bfs_state_t *state, unsigned int *claimed,
+                         unsigned int count)
+{
+    unsigned int position;
+    
+    position = __atomic_fetch_add(&state->next_size, count, __ATOMIC_RELAXED);
+    memcpy(state->next + position, claimed, sizeof(unsigned int) * count);
+}
+
+/**
+ * @brief A thread's share of a top down step.
+ *
+ * @details
+ * Several threads may find the same unvisited vertex, so claiming it is a
+ * compare and swap of its parent. Whoever wins sets its level and adds it to
+ * the next frontier.
+ *
+ * @param[in, out] state The search.
+ * @param[in] id Number of the thread.
+ */
+static void top_down_step (bfs_state_t *state, unsigned int id)
+{
+    csr_graph_t *csr = state->csr;
+    unsigned int claimed[BFS_BATCH], num_claimed, first, last, vertex, adj_vertex;
+    unsigned int unreached;
+    bfs_count_t *count;
+    
+    count = &state->counts[id];
+    first = (unsigned int) ((unsigned long) state->frontier_size * id / state->num_threads);
+    last = (unsigned int) ((unsigned long) state->frontier_size * (id + 1) / state->num_threads);
+    num_claimed = 0;
+    for (unsigned int i = first; i < last; i++) {
+        vertex = state->frontier[i];
+        for (unsigned int j = csr->offsets[vertex]; j < csr->offsets[vertex + 1]; j++) {
+            adj_vertex = csr->neighbors[j];
+            if (__atomic_load_n(&state->parents[adj_vertex], __ATOMIC_RELAXED) != CSR_UNREACHED) {
+                continue;
+            }
+            unreached = CSR_UNREACHED;
+            if (!__atomic_compare_exchange_n(&state->parents[adj_vertex], &unreached,
+                                             vertex, FALSE, __ATOMIC_RELAXED,
+                                             __ATOMIC_RELAXED)) {
+                continue;
+            }
+            state->levels[adj_vertex] = state->level + 1;
+            count->vertices++;
+            count->edges += degree(csr, adj_vertex);
+            claimed[num_claimed++] = adj_vertex;
+            if (num_claimed == BFS_BATCH) {
+                add_to_next(state, claimed, num_claimed);
+                num_claimed = 0;
+            }
+        }
+    }
+    if (num_claimed > 0) {
+        add_to_next(state, claimed, num_claimed);
+    }
+}
+
+/**
+ * @brief A thread's share of a bottom up step.
+ *
+ * @details
+ * Each thread owns whole words of the bitmaps, so it can clear and set the
+ * bits of its vertices without stepping on the others.
+ *
+ * @param[in, out] state The search.
+ * @param[in] id Number of the thread.
+ */
+static void bottom_up_step (bfs_state_t *state, unsigned int id)
+{
+    csr_graph_t *csr = state->csr;
+    unsigned int first_word, last_word, first, last, adj_vertex;
+    unsigned int *offsets, *neighbors;
+    bfs_count_t *count;
+    
+    offsets = csr->directed ? csr->in_offsets : csr->offsets;
+    neighbors = csr->directed ? csr->in_neighbors : csr->neighbors;
+    
+    count = &state->counts[id];
+    first_word = (unsigned int) ((unsigned long) state->num_words * id / state->num_threads);
+    last_word = (unsigned int) ((unsigned long) state->num_words * (id + 1) / state->num_threads);
+    memset(state->next_bits + first_word, 0,
+           sizeof(unsigned long) * (last_word - first_word));
+    first = first_word * BITS_PER_WORD;
+    last = last_word * BITS_PER_WORD;
+    if (last > csr->num_vertices) {
+        last = csr->num_vertices;
+    }
+    
+    for (unsigned int vertex = first; vertex < last; vertex++) {
+        if (state->parents[vertex] != CSR_UNREACHED) {
+            continue;
+        }
+        for (unsigned int j = offsets[vertex]; j < offsets[vertex + 1]; j++) {
+            adj_vertex = neighbors[j];
+            if (state->frontier_bits[adj_vertex / BITS_PER_WORD] &
+                (1UL << (adj_vertex % BITS_PER_WORD))) {
+                state->parents[vertex] = adj_vertex;
+                state->levels[vertex] = state->level + 1;
+                state->next_bits[vertex / BITS_PER_WORD] |= 1UL << (vertex % BITS_PER_WORD);
+                count->vertices++;
+                count->edges += degree(csr, vertex);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Do a thread's share of the current step.
+ *
+ * @param[in, out] state The search.
+ * @param[in] id Number of the thread.
+ */
+static void do_step (bfs_state_t *state, unsigned int id)
+{
+    state->counts[id].vertices = 0;
+    state->counts[id].edges = 0;
+    if (state->bottom_up) {
+        bottom_up_step(state, id);
+    } else {
+        top_down_step(state, id);
+    }
+}
+
+/**
+ * @brief Body of the threads other than the caller.
+ *
+ * @param[in] arg The thread's argument.
+ *
+ * @return NULL.
+ */
+static void *bfs_thread (void *arg)
+{
+    bfs_thread_t *thread = (bfs_thread_t *) arg;
+    bfs_state_t *state = thread->state;
+    
+    for (;;) {
+        wait_at_barrier(&state->barrier);
+        if (state->done) {
+            break;
+        }
+        do_step(state, thread->id);
+        wait_at_barrier(&state->barrier);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Turn the array frontier into the bitmap frontier.
+ *
+ * @param[in, out] state The search.
+ */
+static void frontier_to_bits (bfs_state_t *state)
+{
+    unsigned int vertex;
+    
+    memset(state->frontier_bits, 0, sizeof(unsigned long) * state->num_words);
+    for (unsigned int i = 0; i < state->frontier_size; i++) {
+        vertex = state->frontier[i];
+        state->frontier_bits[vertex / BITS_PER_WORD] |= 1UL << (vertex % BITS_PER_WORD);
+    }
+}
+
+/**
+ * @brief Turn the bitmap frontier into the array frontier.
+ *
+ * @param[in, out] state The search.
+ */
+static void bits_to_frontier (bfs_state_t *state)
+{
+    unsigned long word;
+    unsigned int bit;
+    
+    state->frontier_size = 0;
+    for (unsigned int i = 0; i < state->num_words; i++) {
+        for (word = state->frontier_bits[i]; word; word &= word - 1) {
+            bit = (unsigned int) __builtin_ctzl(word);
+            state->frontier[state->frontier_size++] = i * BITS_PER_WORD + bit;
+        }
+    }
+}
+
+/**
+ * @brief Search the snapshot in a breadth first fashion using many threads.
+ *
+ * @details
+ * Every vertex gets its level, the number of edges between it and the
+ * source, and its parent, the vertex at the level before it that it was
+ * reached from. The source is its own parent. The vertices that can't be
+ * reached have CSR_UNREACHED for both. Which of the many possible parents a
+ * vertex gets depends on the timing of the threads, the levels don't.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] source Number of the vertex to start from.
+ * @param[in] num_threads Number of threads to search with, including the
+ *                        calling thread.
+ * @param[out] levels Array of csr_num_vertices entries for the levels.
+ * @param[out] parents Array of csr_num_vertices entries for the parents.
+ *
+ * @return TRUE if successful, FALSE if the source isn't in the snapshot or
+ *         we ran out of memory or threads.
+ */
+boolean csr_parallel_breadth_first_search (csr_graph_t *csr, unsigned int source,
+                                           unsigned int num_threads,
+                                           unsigned int *levels,
+                                           unsigned int *parents)
+{
+    bfs_state_t state;
+    bfs_thread_t *threads = NULL;
+    pthread_t *thread_ids = NULL;
+    unsigned int *swap, num_started = 0;
+    unsigned long *swap_bits, explored_edges, frontier_edges, total_edges;
+    boolean barrier_ready = FALSE, searched = FALSE, can_go_bottom_up;
+    
+    if (source >= csr->num_vertices) {
+        
+        return FALSE;
+    }
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    memset(&state, 0, sizeof(bfs_state_t));
+    state.csr = csr;
+    state.levels = levels;
+    state.parents = parents;
+    state.num_threads = num_threads;
+    state.num_words = (unsigned int) (csr->num_vertices / BITS_PER_WORD + 1);
+    state.frontier = (unsigned int *) malloc (sizeof(unsigned int) * csr->num_vertices);
+    state.next = (unsigned int *) malloc (sizeof(unsigned int) * csr->num_vertices);
+    state.frontier_bits = (unsigned long *) calloc (state.num_words, sizeof(unsigned long));
+    state.next_bits = (unsigned long *) calloc (state.num_words, sizeof(unsigned long));
+    state.counts = (bfs_count_t *) calloc (num_threads, sizeof(bfs_count_t));
+    threads = (bfs_thread_t *) malloc (sizeof(bfs_thread_t) * num_threads);
+    thread_ids = (pthread_t *) malloc (sizeof(pthread_t) * num_threads);
+    if (state.frontier == NULL || state.next == NULL || state.frontier_bits == NULL ||
+        state.next_bits == NULL || state.counts == NULL || threads == NULL ||
+        thread_ids == NULL) {
+        goto done;
+    }
+    if (!init_barrier(&state.barrier, num_threads)) {
+        goto done;
+    }
+    barrier_ready = TRUE;
+    
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        levels[i] = CSR_UNREACHED;
+        parents[i] = CSR_UNREACHED;
+    }
+    levels[source] = 0;
+    parents[source] = source;
+    state.frontier[0] = source;
+    state.frontier_size = 1;
+    total_edges = csr->offsets[csr->num_vertices];
+    can_go_bottom_up = (!csr->directed || csr->in_offsets != NULL);
+    frontier_edges = degree(csr, source);
+    explored_edges = frontier_edges;
+    
+    /*
+     * If we can't start as many threads as asked for, the barrier would wait
+     * for them forever, so give up right away and let the ones we did start
+     * go.
+     */
+    for (unsigned int i = 1; i < num_threads; i++) {
+        threads[i].state = &state;
+        threads[i].id = i;
+        if (pthread_create(&thread_ids[i], NULL, bfs_thread, &threads[i]) != 0) {
+            break;
+        }
+        num_started++;
+    }
+    if (num_started != num_threads - 1) {
+        pthread_mutex_lock(&state.barrier.lock);
+        state.barrier.num_threads = num_started + 1;
+        pthread_mutex_unlock(&state.barrier.lock);
+        state.done = TRUE;
+        wait_at_barrier(&state.barrier);
+        goto join;
+    }
+    
+    for (;;) {
+        
+        /*
+         * Pick the direction of this step.
+         */
+        if (!state.bottom_up && can_go_bottom_up &&
+            frontier_edges > (total_edges - explored_edges) / BFS_ALPHA) {
+            frontier_to_bits(&state);
+            state.bottom_up = TRUE;
+        } else if (state.bottom_up &&
+                   state.frontier_size < csr->num_vertices / BFS_BETA) {
+            bits_to_frontier(&state);
+            state.bottom_up = FALSE;
+        }
+        state.next_size = 0;
+        
+        wait_at_barrier(&state.barrier);
+        do_step(&state, 0);
+        wait_at_barrier(&state.barrier);
+        
+        /*
+         * The other threads are waiting for the next step, tally what they
+         * found and move the next frontier in as the current one.
+         */
+        state.frontier_size = 0;
+        frontier_edges = 0;
+        for (unsigned int i = 0; i < num_threads; i++) {
+            state.frontier_size += (unsigned int) state.counts[i].vertices;
+            frontier_edges += state.counts[i].edges;
+        }
+        explored_edges += frontier_edges;
+        state.level++;
+        if (state.bottom_up) {
+            swap_bits = state.frontier_bits;
+            state.frontier_bits = state.next_bits;
+            state.next_bits = swap_bits;
+        } else {
+            swap = state.frontier;
+            state.frontier = state.next;
+            state.next = swap;
+        }
+        if (state.frontier_size == 0) {
+            break;
+        }
+    }
+    state.done = TRUE;
+    wait_at_barrier(&state.barrier);
+    searched = TRUE;
+
+join:
+    for (unsigned int i = 1; i <= num_started; i++) {
+        pthread_join(thread_ids[i], NULL);
+    }
+
+done:
+    if (barrier_ready) {
+        destroy_barrier(&state.barrier);
+    }
+    free(state.frontier);
+    free(state.next);
+    free(state.frontier_bits);
+    free(state.next_bits);
+    free(state.counts);
+    free(threads);
+    free(thread_ids);
+    
+    return searched;
+}
@@ -0,0 +1,246 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_components.c
+ * @author Ashutosh Grewal
+ * @date 02/19/17
+ *
+ * @brief This file implements a multi-threaded connected components search
+ *        over the CSR snapshot.
+ *
+ * @details
+ * Each vertex starts out as a component of its own. The threads split the
+ * vertices between them and, for every edge, join the components of its two
+ * vertices in a union-find forest shared by all of them. The forest needs no
+ * lock: a root is only ever linked below a smaller root with a compare and
+ * swap, and a parent only ever moves up to one of its ancestors, so the
+ * vertices of a component always lead to its smallest vertex. Once all the
+ * edges are in, a second pass points every vertex straight at its root.
+ */
+#include <stdlib.h>
+#include <pthread.h>
+#include "public.h"
+#include "csr.h"
+#include "csr_private.h"
+
+/**
+ * @brief What is shared by the threads, along with which vertices each thread
+ *        looks after.
+ */
+typedef struct components_thread_s {
+    csr_graph_t *csr; /**< The snapshot being searched. */
+    unsigned int *parents; /**< The union-find forest. */
+    unsigned int first; /**< First vertex of the thread. */
+    unsigned int last; /**< One past the last vertex of the thread. */
+} components_thread_t;
+
+/**
+ * @brief Find the root of a vertex's tree, halving the path to it on the way.
+ *
+ * @param[in, out] parents The union-find forest.
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return Number of the root.
+ */
+static unsigned int find_root (unsigned int *parents, unsigned int vertex)
+{
+    unsigned int parent, grandparent;
+    
+    for (;;) {
+        parent = __atomic_load_n(&parents[vertex], __ATOMIC_RELAXED);
+        if (parent == vertex) {
+            
+            return vertex;
+        }
+        grandparent = __atomic_load_n(&parents[parent], __ATOMIC_RELAXED);
+        if (grandparent != parent) {
+            
+            /*
+             * Losing this race only means someone else moved it further up.
+             */
+            __atomic_compare_exchange_n(&parents[vertex], &parent, grandparent,
+                                        FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        vertex = grandparent;
+    }
+}
+
+/**
+ * @brief Join the components of two vertices.
+ *
+ * @param[in, out] parents The union-find forest.
+ * @param[in] vertex1 Number of the first vertex.
+ * @param[in] vertex2 Number of the second vertex.
+ */
+static void join_components (unsigned int *parents, unsigned int vertex1,
+                             unsigned int vertex2)
+{
+    unsigned int root1, root2, expected;
+    
+    for (;;) {
+        root1 = find_root(parents, vertex1);
+        root2 = find_root(parents, vertex2);
+        if (root1 == root2) {
+            
+            return;
+        }
+        
+        /*
+         * Always link the larger root below the smaller one. If the larger
+         * root got linked by someone else in the meantime, start over.
+         */
+        if (root1 < root2) {
+            expected = root2;
+            root2 = root1;
+            root1 = expected;
+        }
+        expected = root1;
+        if (__atomic_compare_exchange_n(&parents[root1], &expected, root2, FALSE,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            
+            return;
+        }
+        vertex1 = root1;
+        vertex2 = root2;
+    }
+}
+
+/**
+ * @brief Join the components across the edges of the thread's vertices.
+ *
+ * @details
+ * Each edge of an undirected graph is in the snapshot twice, once for each
+ * of its vertices, so it is only taken from the side of its larger vertex.
+ *
+ * @param[in] arg The thread's share of the work.
+ *
+ * @return NULL.
+ */
+static void *link_thread (void *arg)
+{
+    components_thread_t *thread = (components_thread_t *) arg;
+    csr_graph_t *csr = thread->csr;
+    unsigned int adj_vertex;
+    
+    for (unsigned int vertex = thread->first; vertex < thread->last; vertex++) {
+        for (unsigned int i = csr->offsets[vertex]; i < csr->offsets[vertex + 1]; i++) {
+            adj_vertex = csr->neighbors[i];
+            if (csr->directed || adj_vertex < vertex) {
+                join_components(thread->parents, vertex, adj_vertex);
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Point each of the thread's vertices straight at its root.
+ *
+ * @param[in] arg The thread's share of the work.
+ *
+ * @return NULL.
+ */
+static void *compress_thread (void *arg)
+{
+    components_thread_t *thread = (components_thread_t *) arg;
+    
+    for (unsigned int vertex = thread->first; vertex < thread->last; vertex++) {
+        __atomic_store_n(&thread->parents[vertex],
+                         find_root(thread->parents, vertex), __ATOMIC_RELAXED);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Run a pass on all the threads and wait for them to finish.
+ *
+ * @details
+ * Should a thread fail to start, the caller does its share instead.
+ *
+ * @param[in, out] threads Each thread's share of the work.
+ * @param[out] thread_ids Room for the thread ids.
+ * @param[in] num_threads Number of threads.
+ * @param[in] pass The pass to run.
+ */
+static void run_pass (components_thread_t *threads, pthread_t *thread_ids,
+                      unsigned int num_threads, void *(*pass) (void *))
+{
+    boolean *started;
+    
+    started = (boolean *) calloc (num_threads, sizeof(boolean));
+    for (unsigned int i = 1; i < num_threads && started; i++) {
+        started[i] = (pthread_create(&thread_ids[i], NULL, pass, &threads[i]) == 0);
+    }
+    pass(&threads[0]);
+    for (unsigned int i = 1; i < num_threads; i++) {
+        if (started && started[i]) {
+            pthread_join(thread_ids[i], NULL);
+        } else {
+            pass(&threads[i]);
+        }
+    }
+    free(started);
+}
+
+/**
+ * @brief Find the connected components of the snapshot using many threads.
+ *
+ * @details
+ * Every vertex is labelled with the smallest vertex number in its
+ * component, so the labels don't depend on the timing of the threads. The
+ * edges of a directed graph are taken as going both ways, which gives its
+ * weakly connected components.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] num_threads Number of threads to search with, including the
+ *                        calling thread.
+ * @param[out] components Array of csr_num_vertices entries for the label of
+ *                        every vertex.
+ * @param[out] num_components Number of components found.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean csr_connected_components (csr_graph_t *csr, unsigned int num_threads,
+                                  unsigned int *components,
+                                  unsigned int *num_components)
+{
+    components_thread_t *threads;
+    pthread_t *thread_ids;
+    unsigned int count;
+    
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    threads = (components_thread_t *) malloc (sizeof(components_thread_t) * num_threads);
+    thread_ids = (pthread_t *) malloc (sizeof(pthread_t) * num_threads);
+    if (threads == NULL || thread_ids == NULL) {
+        free(threads);
+        free(thread_ids);
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        components[i] = i;
+    }
+    for (unsigned int i = 0; i < num_threads; i++) {
+        threads[i].csr = csr;
+        threads[i].parents = components;
+        threads[i].first = (unsigned int) ((unsigned long) csr->num_vertices * i / num_threads);
+        threads[i].last = (unsigned int) ((unsigned long) csr->num_vertices * (i + 1) / num_threads);
+    }
+    run_pass(threads, thread_ids, num_threads, link_thread);
+    run_pass(threads, thread_ids, num_threads, compress_thread);
+    
+    count = 0;
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        if (components[i] == i) {
+            count++;
+        }
+    }
+    *num_components = count;
+    free(threads);
+    free(thread_ids);
+    
+    return TRUE;
+}
@@ -0,0 +1,433 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_file.c
+ * @author Ashutosh Grewal
+ * @date 03/11/17
+ *
+ * @brief This file implements saving a CSR snapshot to a file and loading it
+ *        back by mapping the file into memory.
+ *
+ * @details
+ * The file starts with a header, followed by the sections of the snapshot,
+ * each starting at a multiple of 8 bytes:
+ *
+ *   - the offsets, num_vertices + 1 32 bit numbers,
+ *   - the neighbors, offsets[num_vertices] 32 bit numbers,
+ *   - the in offsets and in neighbors, laid out the same way, only if the
+ *     graph kept the edges into each vertex,
+ *   - the original ids, num_vertices 32 bit numbers, the number each vertex
+ *     had when the graph was frozen, only if the snapshot was reordered,
+ *   - the payload offsets, num_vertices + 1 64 bit numbers, the start of each
+ *     vertex's data in the payload,
+ *   - the payload, the data of every vertex as written by the user's
+ *     serialize function, each starting at a multiple of 8 bytes.
+ *
+ * Numbers are stored in the byte order of the machine that saved the file,
+ * which the header records. Loading the file maps it read only and points
+ * the snapshot's arrays straight into the mapping, and the data of each
+ * vertex is a pointer to its bytes in the payload. The pages are only read
+ * from the disk, or the page cache, once a query touches them. The only
+ * memory allocated is the array of data pointers, and the index if one is
+ * asked for.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "public.h"
+#include "graph.h"
+#include "csr.h"
+#include "csr_private.h"
+#include "hash_table.h"
+
+#define CSR_FILE_MAGIC "GRAPHCSR"
+#define CSR_FILE_VERSION 2
+#define CSR_FILE_BYTE_ORDER 0x01020304
+#define CSR_FILE_DIRECTED 0x1
+#define CSR_FILE_IN_EDGES 0x2
+#define CSR_FILE_ORIGINAL_IDS 0x4
+
+/*
+ * The arrays of the snapshot are mapped straight from the file.
+ */
+_Static_assert(sizeof(unsigned int) == sizeof(uint32_t),
+               "unsigned int must be 32 bits");
+
+/**
+ * @brief The header of the file, all positions being from its start.
+ */
+typedef struct csr_file_header_s {
+    char magic[8]; /**< CSR_FILE_MAGIC, without its terminating 0. */
+    uint32_t version; /**< CSR_FILE_VERSION. */
+    uint32_t byte_order; /**< CSR_FILE_BYTE_ORDER in the order of the saver. */
+    uint32_t flags; /**< CSR_FILE_DIRECTED, CSR_FILE_IN_EDGES and
+                         CSR_FILE_ORIGINAL_IDS. */
+    uint32_t num_vertices; /**< Number of vertices. */
+    uint64_t num_entries; /**< Number of neighbors. */
+    uint64_t offsets_at; /**< Position of the offsets. */
+    uint64_t neighbors_at; /**< Position of the neighbors. */
+    uint64_t in_offsets_at; /**< Position of the in offsets, 0 if none. */
+    uint64_t in_neighbors_at; /**< Position of the in neighbors, 0 if none. */
+    uint64_t original_ids_at; /**< Position of the original ids, 0 if none. */
+    uint64_t payload_offsets_at; /**< Position of the payload offsets. */
+    uint64_t payload_at; /**< Position of the payload. */
+    uint64_t file_size; /**< Size of the whole file. */
+} csr_file_header_t;
+
+/**
+ * @brief Round a size up to a multiple of 8.
+ *
+ * @param[in] size The size.
+ *
+ * @return The rounded size.
+ */
+static uint64_t align_to_8 (uint64_t size)
+{
+    return (size + 7) & ~(uint64_t) 7;
+}
+
+/**
+ * @brief Write a section of the file, padding it to a multiple of 8 bytes.
+ *
+ * @param[in, out] file The file.
+ * @param[in] buffer What to write.
+ * @param[in] size Number of bytes to write.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean write_section (FILE *file, const void *buffer, uint64_t size)
+{
+    static const char padding[8];
+    size_t pad;
+    
+    pad = (size_t) (align_to_8(size) - size);
+    if (size > 0 && fwrite(buffer, 1, (size_t) size, file) != size) {
+        
+        return FALSE;
+    }
+    
+    return pad == 0 || fwrite(padding, 1, pad, file) == pad;
+}
+
+/**
+ * @brief Save a snapshot to a file.
+ *
+ * @details
+ * The serialize function is called twice for every vertex, first without a
+ * buffer to find out the size of the data and then with a buffer of that
+ * size to write it.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] path Path of the file, replaced if it exists.
+ * @param[in] serialize Function to write the opaque data as bytes.
+ *
+ * @return TRUE if successful, FALSE if the file couldn't be written or
+ *         memory allocation failed.
+ */
+boolean csr_save (csr_graph_t *csr, const char *path, serialize_data_t serialize)
+{
+    csr_file_header_t header;
+    uint64_t *payload_offsets = NULL, position;
+    unsigned int num_vertices;
+    void *buffer = NULL;
+    size_t size, buffer_size = 0;
+    FILE *file = NULL;
+    boolean saved = FALSE;
+    
+    if (serialize == NULL) {
+        
+        return FALSE;
+    }
+    num_vertices = csr->num_vertices;
+    payload_offsets = (uint64_t *) malloc (sizeof(uint64_t) * (num_vertices + 1));
+    if (payload_offsets == NULL) {
+        goto done;
+    }
+    
+    /*
+     * Lay the payload out first, the header needs its size.
+     */
+    position = 0;
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        payload_offsets[i] = position;
+        position += align_to_8(serialize(csr->data[i], NULL, 0));
+    }
+    payload_offsets[num_vertices] = position;
+    
+    memset(&header, 0, sizeof(csr_file_header_t));
+    memcpy(header.magic, CSR_FILE_MAGIC, sizeof(header.magic));
+    header.version = CSR_FILE_VERSION;
+    header.byte_order = CSR_FILE_BYTE_ORDER;
+    header.flags = (csr->directed ? CSR_FILE_DIRECTED : 0) |
+                   (csr->in_offsets ? CSR_FILE_IN_EDGES : 0) |
+                   (csr->original_ids ? CSR_FILE_ORIGINAL_IDS : 0);
+    header.num_vertices = num_vertices;
+    header.num_entries = csr->offsets[num_vertices];
+    header.offsets_at = align_to_8(sizeof(csr_file_header_t));
+    header.neighbors_at = header.offsets_at +
+                          align_to_8(sizeof(uint32_t) * ((uint64_t) num_vertices + 1));
+    header.payload_offsets_at = header.neighbors_at +
+                                align_to_8(sizeof(uint32_t) * header.num_entries);
+    if (csr->in_offsets) {
+        header.in_offsets_at = header.payload_offsets_at;
+        header.in_neighbors_at = header.in_offsets_at +
+                                 align_to_8(sizeof(uint32_t) * ((uint64_t) num_vertices + 1));
+        header.payload_offsets_at = header.in_neighbors_at +
+                                    align_to_8(sizeof(uint32_t) * header.num_entries);
+    }
+    if (csr->original_ids) {
+        header.original_ids_at = header.payload_offsets_at;
+        header.payload_offsets_at = header.original_ids_at +
+                                    align_to_8(sizeof(uint32_t) * (uint64_t) num_vertices);
+    }
+    header.payload_at = header.payload_offsets_at +
+                        sizeof(uint64_t) * ((uint64_t) num_vertices + 1);
+    header.file_size = header.payload_at + payload_offsets[num_vertices];
+    
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        goto done;
+    }
+    if (!write_section(file, &header, sizeof(csr_file_header_t)) ||
+        !write_section(file, csr->offsets, sizeof(uint32_t) * ((uint64_t) num_vertices + 1)) ||
+        !write_section(file, csr->neighbors, sizeof(uint32_t) * header.num_entries)) {
+        goto done;
+    }
+    if (csr->in_offsets &&
+        (!write_section(file, csr->in_offsets,
+                        sizeof(uint32_t) * ((uint64_t) num_vertices + 1)) ||
+         !write_section(file, csr->in_neighbors, sizeof(uint32_t) * header.num_entries))) {
+        goto done;
+    }
+    if (csr->original_ids &&
+        !write_section(file, csr->original_ids, sizeof(uint32_t) * (uint64_t) num_vertices)) {
+        goto done;
+    }
+    if (!write_section(file, payload_offsets,
+                       sizeof(uint64_t) * ((uint64_t) num_vertices + 1))) {
+        goto done;
+    }
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        size = (size_t) (payload_offsets[i + 1] - payload_offsets[i]);
+        if (size > buffer_size) {
+            free(buffer);
+            buffer = malloc (size);
+            buffer_size = buffer ? size : 0;
+            if (buffer == NULL) {
+                goto done;
+            }
+        }
+        
+        /*
+         * The data must come out the same size as it did the first time.
+         */
+        memset(buffer, 0, size);
+        if (align_to_8(serialize(csr->data[i], buffer, size)) != size ||
+            !write_section(file, buffer, size)) {
+            goto done;
+        }
+    }
+    saved = TRUE;
+
+done:
+    if (file != NULL && fclose(file) != 0) {
+        saved = FALSE;
+    }
+    free(payload_offsets);
+    free(buffer);
+    
+    return saved;
+}
+
+/**
+ * @brief Save a snapshot of the graph to a file.
+ *
+ * @see csr_save
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] path Path of the file, replaced if it exists.
+ * @param[in] serialize Function to write the opaque data as bytes.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+boolean graph_save (graph_t *graph, const char *path, serialize_data_t serialize)
+{
+    csr_graph_t *csr;
+    boolean saved;
+    
+    csr = graph_freeze(graph);
+    if (csr == NULL) {
+        
+        return FALSE;
+    }
+    saved = csr_save(csr, path, serialize);
+    destroy_csr_graph(csr);
+    
+    return saved;
+}
+
+/**
+ * @brief Check that the header describes a file we can load.
+ *
+ * @details
+ * Only the header and the ends of the offsets are checked, anything more
+ * would read the whole file. The rest of the file is trusted to be written by
+ * csr_save.
+ *
+ * @param[in] header The header.
+ * @param[in] file_size Size of the file.
+ *
+ * @return TRUE if the header is good, FALSE otherwise.
+ */
+static boolean header_is_valid (const csr_file_header_t *header, uint64_t file_size)
+{
+    uint64_t offsets_size, neighbors_size, edges_end;
+    
+    if (memcmp(header->magic, CSR_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CSR_FILE_VERSION ||
+        header->byte_order != CSR_FILE_BYTE_ORDER ||
+        header->file_size != file_size) {
+        
+        return FALSE;
+    }
+    if ((header->offsets_at | header->neighbors_at | header->in_offsets_at |
+         header->in_neighbors_at | header->original_ids_at |
+         header->payload_offsets_at | header->payload_at) & 7) {
+        
+        return FALSE;
+    }
+    offsets_size = sizeof(uint32_t) * ((uint64_t) header->num_vertices + 1);
+    neighbors_size = sizeof(uint32_t) * header->num_entries;
+    if (header->offsets_at < sizeof(csr_file_header_t) ||
+        header->neighbors_at < header->offsets_at + offsets_size ||
+        header->payload_offsets_at < header->neighbors_at + neighbors_size ||
+        header->payload_at < header->payload_offsets_at +
+                             sizeof(uint64_t) * ((uint64_t) header->num_vertices + 1) ||
+        header->payload_at > file_size) {
+        
+        return FALSE;
+    }
+    if ((header->flags & CSR_FILE_IN_EDGES) &&
+        (header->in_offsets_at < header->neighbors_at + neighbors_size ||
+         header->in_neighbors_at < header->in_offsets_at + offsets_size ||
+         header->payload_offsets_at < header->in_neighbors_at + neighbors_size)) {
+        
+        return FALSE;
+    }
+    edges_end = (header->flags & CSR_FILE_IN_EDGES) ?
+                header->in_neighbors_at + neighbors_size :
+                header->neighbors_at + neighbors_size;
+    if ((header->flags & CSR_FILE_ORIGINAL_IDS) &&
+        (header->original_ids_at < edges_end ||
+         header->payload_offsets_at < header->original_ids_at +
+                                      sizeof(uint32_t) * (uint64_t) header->num_vertices)) {
+        
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Load a snapshot saved by csr_save or graph_save, mapping the file
+ *        into memory instead of reading it.
+ *
+ * @details
+ * The data of every vertex is a pointer to the bytes its serialize function
+ * wrote, so print_data, data_is_equal and data_hash work on those bytes, and
+ * they stay valid till the snapshot is destroyed. The file must not be
+ * changed while it's loaded. With a hash function the snapshot is indexed
+ * like a frozen indexed graph, at the cost of going through all the data.
+ *
+ * @param[in] path Path of the file.
+ * @param[in] print_data Function to print the data of a vertex.
+ * @param[in] data_is_equal Function to compare the data of the vertices.
+ * @param[in] data_hash Function to hash the data of a vertex, NULL if the
+ *                      snapshot should not be indexed.
+ *
+ * @return Pointer to the CSR snapshot if successful, NULL if the file is
+ *         missing, not a snapshot or from a machine with another byte order,
+ *         or memory allocation failed.
+ */
+csr_graph_t *graph_load_mmap (const char *path, print_data_t print_data,
+                              data_is_equal_t data_is_equal, data_hash_t data_hash)
+{
+    csr_file_header_t *header;
+    csr_graph_t *csr = NULL;
+    uint64_t *payload_offsets;
+    struct stat file_stat;
+    char *mapping = MAP_FAILED;
+    int fd;
+    
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        
+        return NULL;
+    }
+    if (fstat(fd, &file_stat) != 0 ||
+        (uint64_t) file_stat.st_size < sizeof(csr_file_header_t)) {
+        goto fail;
+    }
+    mapping = (char *) mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        goto fail;
+    }
+    header = (csr_file_header_t *) mapping;
+    if (!header_is_valid(header, (uint64_t) file_stat.st_size)) {
+        goto fail;
+    }
+    csr = (csr_graph_t *) calloc (1, sizeof(csr_graph_t));
+    if (csr == NULL) {
+        goto fail;
+    }
+    csr->mapping = mapping;
+    csr->mapping_size = (size_t) file_stat.st_size;
+    mapping = MAP_FAILED;
+    csr->num_vertices = header->num_vertices;
+    csr->offsets = (unsigned int *) (csr->mapping + header->offsets_at);
+    csr->neighbors = (unsigned int *) (csr->mapping + header->neighbors_at);
+    csr->directed = (header->flags & CSR_FILE_DIRECTED) != 0;
+    if (header->flags & CSR_FILE_IN_EDGES) {
+        csr->in_offsets = (unsigned int *) (csr->mapping + header->in_offsets_at);
+        csr->in_neighbors = (unsigned int *) (csr->mapping + header->in_neighbors_at);
+    }
+    if (header->flags & CSR_FILE_ORIGINAL_IDS) {
+        csr->original_ids = (unsigned int *) (csr->mapping + header->original_ids_at);
+    }
+    if (csr->offsets[0] != 0 || csr->offsets[csr->num_vertices] != header->num_entries) {
+        goto fail;
+    }
+    csr->print_data = print_data;
+    csr->data_is_equal = data_is_equal;
+    
+    payload_offsets = (uint64_t *) (csr->mapping + header->payload_offsets_at);
+    if (payload_offsets[csr->num_vertices] > header->file_size - header->payload_at) {
+        goto fail;
+    }
+    csr->data = (void **) malloc (sizeof(void *) * (csr->num_vertices + 1));
+    if (csr->data == NULL) {
+        goto fail;
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        csr->data[i] = csr->mapping + header->payload_at + payload_offsets[i];
+    }
+    if (data_hash != NULL && !build_csr_index(csr, data_hash)) {
+        goto fail;
+    }
+    close(fd);
+    
+    return csr;
+
+fail:
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, (size_t) file_stat.st_size);
+    }
+    close(fd);
+    destroy_csr_graph(csr);
+    
+    return NULL;
+}
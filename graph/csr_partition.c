@@ -0,0 +1,554 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_partition.c
+ * @author Ashutosh Grewal
+ * @date 04/09/17
+ *
+ * @brief This file implements splitting a CSR snapshot into shards, each
+ *        owning some of the vertices along with their edges.
+ *
+ * @details
+ * A shard holds everything needed to walk its own vertices, so the shards can
+ * live in different processes or on different machines. An edge between
+ * vertices of different shards shows up in the shard owning the vertex it
+ * starts from as an edge to a ghost, a stand in for a vertex owned elsewhere
+ * that records which shard owns it and its number there. Every such edge
+ * costs a message when the shards are searched together, so the greedy
+ * method tries to keep the vertices of an edge in the same shard.
+ *
+ * The greedy method is the linear deterministic greedy one. It takes the
+ * vertices in order and gives each to the shard with the most of its
+ * adjacent vertices so far, scaled down by how full the shard is. No shard
+ * takes more than its share of the vertices, rounded up. A directed snapshot
+ * without its in edges only shows it the vertices each vertex's edges go to,
+ * so it does better with them.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "public.h"
+#include "csr.h"
+#include "csr_private.h"
+#include "partition.h"
+#include "partition_private.h"
+
+/**
+ * Owner of a vertex that isn't in a shard yet.
+ */
+#define UNASSIGNED UINT_MAX
+
+/**
+ * @brief Scramble the number of a vertex.
+ *
+ * @details
+ * The numbers of adjacent vertices are often close together, which would put
+ * runs of them in the same shard if we took them modulo the number of shards
+ * as they are.
+ *
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return Hash of the number.
+ */
+static inline uint32_t hash_vertex (uint32_t vertex)
+{
+    vertex ^= vertex >> 16;
+    vertex *= 0x85ebca6bU;
+    vertex ^= vertex >> 13;
+    vertex *= 0xc2b2ae35U;
+    vertex ^= vertex >> 16;
+    
+    return vertex;
+}
+
+/**
+ * @brief Count the adjacent vertices in each shard of one list of neighbors.
+ *
+ * @param[in] neighbors The neighbors.
+ * @param[in] count Number of neighbors.
+ * @param[in] owners Shard owning each vertex so far.
+ * @param[in, out] counts Number of the vertex's neighbors in each shard.
+ */
+static void count_in_shards (const unsigned int *neighbors, unsigned int count,
+                             const unsigned int *owners, unsigned int *counts)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        if (owners[neighbors[i]] != UNASSIGNED) {
+            counts[owners[neighbors[i]]]++;
+        }
+    }
+}
+
+/**
+ * @brief Give every vertex a shard using the linear deterministic greedy
+ *        method.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] num_shards Number of shards.
+ * @param[out] owners Shard owning each vertex.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean assign_greedy (csr_graph_t *csr, unsigned int num_shards,
+                              unsigned int *owners)
+{
+    unsigned int *counts, *sizes, best, capacity;
+    double score, best_score;
+    
+    counts = (unsigned int *) calloc (num_shards, sizeof(unsigned int));
+    sizes = (unsigned int *) calloc (num_shards, sizeof(unsigned int));
+    if (counts == NULL || sizes == NULL) {
+        free(counts);
+        free(sizes);
+        
+        return FALSE;
+    }
+    capacity = csr->num_vertices / num_shards +
+               (csr->num_vertices % num_shards != 0);
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        owners[i] = UNASSIGNED;
+    }
+    
+    for (unsigned int vertex = 0; vertex < csr->num_vertices; vertex++) {
+        count_in_shards(csr->neighbors + csr->offsets[vertex],
+                        csr->offsets[vertex + 1] - csr->offsets[vertex],
+                        owners, counts);
+        if (csr->directed && csr->in_offsets) {
+            count_in_shards(csr->in_neighbors + csr->in_offsets[vertex],
+                            csr->in_offsets[vertex + 1] - csr->in_offsets[vertex],
+                            owners, counts);
+        }
+        
+        /*
+         * A full shard scores 0 at best, and there is always a shard with
+         * room that scores at least that, so ties going to the emptier shard
+         * keep every shard within its capacity.
+         */
+        best = 0;
+        best_score = -1;
+        for (unsigned int shard = 0; shard < num_shards; shard++) {
+            score = counts[shard] * (1 - (double) sizes[shard] / capacity);
+            if (sizes[shard] >= capacity) {
+                score = -1;
+            }
+            if (score > best_score ||
+                (score == best_score && sizes[shard] < sizes[best])) {
+                best = shard;
+                best_score = score;
+            }
+            counts[shard] = 0;
+        }
+        owners[vertex] = best;
+        sizes[best]++;
+    }
+    free(counts);
+    free(sizes);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Free the arrays of a shard.
+ *
+ * @param[in, out] shard Pointer to the shard.
+ */
+static void free_shard (graph_shard_t *shard)
+{
+    free(shard->global_ids);
+    free(shard->offsets);
+    free(shard->neighbors);
+    free(shard->owners);
+    free(shard->remote_ids);
+    free(shard->data);
+}
+
+/**
+ * @brief Build one shard out of the vertices it owns.
+ *
+ * @details
+ * The first pass over the edges finds the ghosts, the second one lays out the
+ * neighbors. A ghost's number in the shard is kept in slots while the shard
+ * is built, and marks says which ghosts belong to this shard, so neither is
+ * cleared between shards.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] partition The partition, with the owners and local numbers of
+ *                      the vertices filled in.
+ * @param[in] vertices The vertices the shard owns, by number.
+ * @param[in, out] marks Shard each vertex was last found to be a ghost of,
+ *                       plus 1.
+ * @param[in, out] slots Number of each ghost in the shard.
+ * @param[in, out] shard Pointer to the shard, with its id and num_vertices
+ *                       filled in.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean build_shard (csr_graph_t *csr, graph_partition_t *partition,
+                            const unsigned int *vertices, unsigned int *marks,
+                            unsigned int *slots, graph_shard_t *shard)
+{
+    unsigned int vertex, adj_vertex, num_edges = 0, position;
+    
+    for (unsigned int i = 0; i < shard->num_vertices; i++) {
+        vertex = vertices[i];
+        num_edges += csr->offsets[vertex + 1] - csr->offsets[vertex];
+        for (unsigned int j = csr->offsets[vertex]; j < csr->offsets[vertex + 1]; j++) {
+            adj_vertex = csr->neighbors[j];
+            if (partition->owners[adj_vertex] != shard->id &&
+                marks[adj_vertex] != shard->id + 1) {
+                marks[adj_vertex] = shard->id + 1;
+                slots[adj_vertex] = shard->num_vertices + shard->num_ghosts++;
+            }
+        }
+    }
+    shard->global_ids = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                 (shard->num_vertices +
+                                                  shard->num_ghosts + 1));
+    shard->offsets = (unsigned int *) malloc (sizeof(unsigned int) *
+                                              (shard->num_vertices + 1));
+    shard->neighbors = (unsigned int *) malloc (sizeof(unsigned int) * (num_edges + 1));
+    shard->owners = (unsigned int *) malloc (sizeof(unsigned int) * (shard->num_ghosts + 1));
+    shard->remote_ids = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                 (shard->num_ghosts + 1));
+    shard->data = (void **) malloc (sizeof(void *) * (shard->num_vertices + 1));
+    if (shard->global_ids == NULL || shard->offsets == NULL ||
+        shard->neighbors == NULL || shard->owners == NULL ||
+        shard->remote_ids == NULL || shard->data == NULL) {
+        
+        return FALSE;
+    }
+    
+    position = 0;
+    for (unsigned int i = 0; i < shard->num_vertices; i++) {
+        vertex = vertices[i];
+        shard->global_ids[i] = vertex;
+        shard->data[i] = csr->data[vertex];
+        shard->offsets[i] = position;
+        for (unsigned int j = csr->offsets[vertex]; j < csr->offsets[vertex + 1]; j++) {
+            adj_vertex = csr->neighbors[j];
+            if (partition->owners[adj_vertex] == shard->id) {
+                shard->neighbors[position++] = partition->local_ids[adj_vertex];
+                continue;
+            }
+            shard->neighbors[position++] = slots[adj_vertex];
+            shard->global_ids[slots[adj_vertex]] = adj_vertex;
+            shard->owners[slots[adj_vertex] - shard->num_vertices] =
+                partition->owners[adj_vertex];
+            shard->remote_ids[slots[adj_vertex] - shard->num_vertices] =
+                partition->local_ids[adj_vertex];
+        }
+    }
+    shard->offsets[shard->num_vertices] = position;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Split a CSR snapshot into shards.
+ *
+ * @details
+ * Each vertex is owned by one shard, which keeps its data and its edges. The
+ * vertices of a shard keep the order of their numbers in the snapshot. The
+ * snapshot can be destroyed once it's split, but the shards point to the same
+ * data it did.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] num_shards Number of shards to split it into.
+ * @param[in] method How to pick the shard owning each vertex.
+ *
+ * @return Pointer to the partition if successful, NULL otherwise.
+ */
+graph_partition_t *csr_partition (csr_graph_t *csr, unsigned int num_shards,
+                                  partition_method_t method)
+{
+    graph_partition_t *partition;
+    graph_shard_t *shard;
+    unsigned int *starts = NULL, *by_shard = NULL, *marks = NULL, *slots = NULL;
+    boolean built = FALSE;
+    
+    if (num_shards == 0) {
+        
+        return NULL;
+    }
+    partition = (graph_partition_t *) calloc (1, sizeof(graph_partition_t));
+    if (partition == NULL) {
+        
+        return NULL;
+    }
+    partition->num_shards = num_shards;
+    partition->num_vertices = csr->num_vertices;
+    partition->owners = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                 (csr->num_vertices + 1));
+    partition->local_ids = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                    (csr->num_vertices + 1));
+    partition->shards = (graph_shard_t *) calloc (num_shards, sizeof(graph_shard_t));
+    starts = (unsigned int *) calloc (num_shards + 1, sizeof(unsigned int));
+    by_shard = (unsigned int *) malloc (sizeof(unsigned int) * (csr->num_vertices + 1));
+    marks = (unsigned int *) calloc (csr->num_vertices + 1, sizeof(unsigned int));
+    slots = (unsigned int *) malloc (sizeof(unsigned int) * (csr->num_vertices + 1));
+    if (partition->owners == NULL || partition->local_ids == NULL ||
+        partition->shards == NULL || starts == NULL || by_shard == NULL ||
+        marks == NULL || slots == NULL) {
+        goto done;
+    }
+    
+    if (method == PARTITION_GREEDY) {
+        if (!assign_greedy(csr, num_shards, partition->owners)) {
+            goto done;
+        }
+    } else {
+        for (unsigned int i = 0; i < csr->num_vertices; i++) {
+            partition->owners[i] = hash_vertex(i) % num_shards;
+        }
+    }
+    
+    /*
+     * Sort the vertices by their shard, keeping the order of their numbers
+     * within each one, which also gives them their numbers in the shard.
+     */
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        starts[partition->owners[i] + 1]++;
+    }
+    for (unsigned int id = 0; id < num_shards; id++) {
+        partition->shards[id].id = id;
+        starts[id + 1] += starts[id];
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        shard = &partition->shards[partition->owners[i]];
+        partition->local_ids[i] = shard->num_vertices++;
+        by_shard[starts[shard->id] + partition->local_ids[i]] = i;
+    }
+    
+    /*
+     * Every edge to a ghost is cut, and an undirected edge is in the
+     * neighbors of both its vertices.
+     */
+    for (unsigned int id = 0; id < num_shards; id++) {
+        shard = &partition->shards[id];
+        if (!build_shard(csr, partition, by_shard + starts[id], marks, slots, shard)) {
+            goto done;
+        }
+        for (unsigned int i = 0; i < shard->offsets[shard->num_vertices]; i++) {
+            partition->edge_cut += shard->neighbors[i] >= shard->num_vertices;
+        }
+    }
+    if (!csr->directed) {
+        partition->edge_cut /= 2;
+    }
+    built = TRUE;
+
+done:
+    free(starts);
+    free(by_shard);
+    free(marks);
+    free(slots);
+    if (!built) {
+        destroy_graph_partition(partition);
+        
+        return NULL;
+    }
+    
+    return partition;
+}
+
+/**
+ * @brief Return the number of shards of a partition.
+ *
+ * @param[in] partition Pointer to the partition.
+ *
+ * @return Number of shards.
+ */
+unsigned int partition_num_shards (graph_partition_t *partition)
+{
+    return partition->num_shards;
+}
+
+/**
+ * @brief Return the number of edges between vertices owned by different
+ *        shards.
+ *
+ * @param[in] partition Pointer to the partition.
+ *
+ * @return Number of edges cut.
+ */
+unsigned long partition_edge_cut (graph_partition_t *partition)
+{
+    return partition->edge_cut;
+}
+
+/**
+ * @brief Find the shard owning a vertex of the snapshot.
+ *
+ * @param[in] partition Pointer to the partition.
+ * @param[in] vertex Number of the vertex in the snapshot.
+ * @param[out] shard Number of the shard owning it.
+ * @param[out] local_id Number of the vertex in that shard.
+ *
+ * @return TRUE if successful, FALSE if there is no such vertex.
+ */
+boolean partition_owner (graph_partition_t *partition, unsigned int vertex,
+                         unsigned int *shard, unsigned int *local_id)
+{
+    if (vertex >= partition->num_vertices) {
+        
+        return FALSE;
+    }
+    *shard = partition->owners[vertex];
+    *local_id = partition->local_ids[vertex];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Return a shard of a partition.
+ *
+ * @param[in] partition Pointer to the partition.
+ * @param[in] shard Number of the shard.
+ *
+ * @return Pointer to the shard, NULL if there is no such shard.
+ */
+graph_shard_t *partition_get_shard (graph_partition_t *partition, unsigned int shard)
+{
+    if (shard >= partition->num_shards) {
+        
+        return NULL;
+    }
+    
+    return &partition->shards[shard];
+}
+
+/**
+ * @brief Return the number of vertices a shard owns.
+ *
+ * @param[in] shard Pointer to the shard.
+ *
+ * @return Number of vertices, not counting the ghosts.
+ */
+unsigned int shard_num_vertices (graph_shard_t *shard)
+{
+    return shard->num_vertices;
+}
+
+/**
+ * @brief Return the number of ghosts of a shard, the vertices owned by other
+ *        shards that the shard's vertices have edges to.
+ *
+ * @param[in] shard Pointer to the shard.
+ *
+ * @return Number of ghosts.
+ */
+unsigned int shard_num_ghosts (graph_shard_t *shard)
+{
+    return shard->num_ghosts;
+}
+
+/**
+ * @brief Return the number a vertex of a shard has in the snapshot.
+ *
+ * @param[in] shard Pointer to the shard.
+ * @param[in] vertex Number of the vertex, or of a ghost, in the shard.
+ *
+ * @return Number in the snapshot, UINT_MAX if there is no such vertex.
+ */
+unsigned int shard_global_id (graph_shard_t *shard, unsigned int vertex)
+{
+    if (vertex >= shard->num_vertices + shard->num_ghosts) {
+        
+        return UINT_MAX;
+    }
+    
+    return shard->global_ids[vertex];
+}
+
+/**
+ * @brief Return the data stored at a vertex a shard owns.
+ *
+ * @param[in] shard Pointer to the shard.
+ * @param[in] vertex Number of the vertex in the shard.
+ *
+ * @return The opaque data, NULL if the shard doesn't own such a vertex.
+ */
+void *shard_get_data (graph_shard_t *shard, unsigned int vertex)
+{
+    if (vertex >= shard->num_vertices) {
+        
+        return NULL;
+    }
+    
+    return shard->data[vertex];
+}
+
+/**
+ * @brief Return the adjacent vertices of a vertex a shard owns as one array.
+ *
+ * @details
+ * The neighbors are numbered in the shard, those numbered shard_num_vertices
+ * or more being ghosts. The array lives as long as the partition.
+ *
+ * @param[in] shard Pointer to the shard.
+ * @param[in] vertex Number of the vertex in the shard.
+ * @param[out] begin Numbers of the adjacent vertices.
+ * @param[out] count Number of adjacent vertices.
+ *
+ * @return TRUE if successful, FALSE if the shard doesn't own such a vertex.
+ */
+boolean shard_neighbors (graph_shard_t *shard, unsigned int vertex,
+                         const unsigned int **begin, unsigned int *count)
+{
+    if (vertex >= shard->num_vertices) {
+        
+        return FALSE;
+    }
+    *begin = shard->neighbors + shard->offsets[vertex];
+    *count = shard->offsets[vertex + 1] - shard->offsets[vertex];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Find the shard owning a ghost of a shard.
+ *
+ * @param[in] shard Pointer to the shard.
+ * @param[in] vertex Number of the ghost in the shard, at least
+ *                   shard_num_vertices.
+ * @param[out] owner Number of the shard owning it.
+ * @param[out] remote_id Number of the vertex in that shard.
+ *
+ * @return TRUE if successful, FALSE if there is no such ghost.
+ */
+boolean shard_ghost_owner (graph_shard_t *shard, unsigned int vertex,
+                           unsigned int *owner, unsigned int *remote_id)
+{
+    if (vertex < shard->num_vertices ||
+        vertex >= shard->num_vertices + shard->num_ghosts) {
+        
+        return FALSE;
+    }
+    *owner = shard->owners[vertex - shard->num_vertices];
+    *remote_id = shard->remote_ids[vertex - shard->num_vertices];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Destroy a partition and its shards. The data stored at the vertices
+ *        is owned by the user and is not freed.
+ *
+ * @param[in, out] partition Pointer to the partition.
+ */
+void destroy_graph_partition (graph_partition_t *partition)
+{
+    if (partition == NULL) {
+        
+        return;
+    }
+    if (partition->shards) {
+        for (unsigned int shard = 0; shard < partition->num_shards; shard++) {
+            free_shard(&partition->shards[shard]);
+        }
+    }
+    free(partition->shards);
+    free(partition->owners);
+    free(partition->local_ids);
+    free(partition);
+}
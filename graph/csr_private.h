@@ -0,0 +1,58 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_private.h
+ * @date 01/21/17
+ * @author Ashutosh Grewal
+ *
+ * @brief Private definition of the CSR snapshot shared by the files that
+ *        build or walk it. This separate header file is made as we do not
+ *        want these definitions made visible to the rest of the system.
+ */
+#ifndef CSR_PRIVATE_H
+#define CSR_PRIVATE_H
+
+#include <stddef.h>
+#include "public.h"
+#include "graph.h"
+#include "hash_table.h"
+
+/**
+ * @brief The compressed sparse row snapshot of a graph.
+ *
+ * @details
+ * Vertices are numbered from 0 to num_vertices - 1. The neighbors of vertex i
+ * are neighbors[offsets[i]] to neighbors[offsets[i + 1] - 1], so walking the
+ * adjacent vertices is a scan over contiguous memory. The neighbors of a
+ * vertex of a directed graph are the vertices its edges go to, and the ones
+ * its edges come from are laid out the same way in the in arrays, if the
+ * graph kept those.
+ */
+struct csr_graph_s {
+    unsigned int num_vertices; /**< Number of vertices. */
+    unsigned int *offsets; /**< Start of each vertex's neighbors, has
+                                num_vertices + 1 entries. */
+    unsigned int *neighbors; /**< Adjacent vertex numbers of all vertices. */
+    boolean directed; /**< TRUE if the edges have a direction. */
+    unsigned int *in_offsets; /**< Start of each vertex's in neighbors, NULL
+                                   without them. */
+    unsigned int *in_neighbors; /**< Numbers of the vertices with an edge into
+                                     each vertex, NULL without them. */
+    void **data; /**< The data stored at each vertex. */
+    print_data_t print_data; /**< Function pointer to print the data. */
+    data_is_equal_t data_is_equal; /**< Function pointer to compare the data. */
+    data_hash_t data_hash; /**< Function pointer to hash the data, NULL if
+                                the graph wasn't indexed. */
+    hash_table_t *index; /**< Index from the data to its slot in data, NULL
+                              if the graph wasn't indexed. */
+    unsigned int *original_ids; /**< Number each vertex had when the graph
+                                     was frozen, NULL if it wasn't
+                                     reordered since. */
+    char *mapping; /**< The file the arrays point into, NULL if they were
+                        allocated. */
+    size_t mapping_size; /**< Size of the mapping. */
+};
+
+boolean build_csr_index (csr_graph_t *, data_hash_t);
+boolean build_csr_in_edges (csr_graph_t *);
+
+#endif /* CSR_PRIVATE_H */
@@ -0,0 +1,368 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file csr_reorder.c
+ * @author Ashutosh Grewal
+ * @date 03/25/17
+ *
+ * @brief This file implements renumbering the vertices of a CSR snapshot to
+ *        improve the locality of the searches over it.
+ *
+ * @details
+ * A search touches the offsets, the levels or the marks of a vertex's
+ * adjacent vertices right after the vertex itself, so the closer the numbers
+ * of adjacent vertices are, the more of those touches land on cache lines
+ * and pages already in use. Renumbering builds a new snapshot with the
+ * vertices in the chosen order and the neighbors of every vertex sorted by
+ * their new numbers, so a walk over them moves forward through memory. The
+ * snapshot remembers the number every vertex had when the graph was frozen.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "public.h"
+#include "csr.h"
+#include "csr_private.h"
+
+/**
+ * @brief Compare two numbers for qsort.
+ *
+ * @param[in] a First number.
+ * @param[in] b Second number.
+ *
+ * @return Less than, equal to or greater than 0 as a is less than, equal to or
+ *         greater than b.
+ */
+static int compare_numbers (const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *) a, y = *(const unsigned int *) b;
+    
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Compare two sort keys for qsort.
+ *
+ * @param[in] a First key.
+ * @param[in] b Second key.
+ *
+ * @return Less than, equal to or greater than 0 as a is less than, equal to or
+ *         greater than b.
+ */
+static int compare_keys (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Return the degree of a vertex.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return Number of adjacent vertices.
+ */
+static inline unsigned int degree (csr_graph_t *csr, unsigned int vertex)
+{
+    return csr->offsets[vertex + 1] - csr->offsets[vertex];
+}
+
+/**
+ * @brief Sort vertices by a key, breaking ties by their number.
+ *
+ * @details
+ * The key goes in the high half of a 64 bit number and the vertex in the low
+ * half, so sorting the numbers sorts by both.
+ *
+ * @param[in, out] vertices The vertices.
+ * @param[in] count Number of vertices.
+ * @param[in, out] keys Room for count keys.
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] descending TRUE to sort by degree, most first, FALSE to sort by
+ *                       degree, least first.
+ */
+static void sort_by_degree (unsigned int *vertices, unsigned int count,
+                            uint64_t *keys, csr_graph_t *csr, boolean descending)
+{
+    unsigned int key;
+    
+    for (unsigned int i = 0; i < count; i++) {
+        key = degree(csr, vertices[i]);
+        if (descending) {
+            key = UINT_MAX - key;
+        }
+        keys[i] = ((uint64_t) key << 32) | vertices[i];
+    }
+    qsort(keys, count, sizeof(uint64_t), compare_keys);
+    for (unsigned int i = 0; i < count; i++) {
+        vertices[i] = (unsigned int) keys[i];
+    }
+}
+
+/**
+ * @brief Order the vertices breadth first, starting each part of the graph
+ *        from the first vertex in starts not reached yet.
+ *
+ * @details
+ * For the Cuthill-McKee order, the vertices reached from each vertex are
+ * taken by increasing degree.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] starts All the vertices, in the order to start a part from.
+ * @param[in] by_degree TRUE to take the vertices reached by increasing degree.
+ * @param[out] order The vertices in breadth first order.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean order_breadth_first (csr_graph_t *csr, const unsigned int *starts,
+                                    boolean by_degree, unsigned int *order)
+{
+    unsigned char *reached;
+    uint64_t *keys = NULL;
+    unsigned int count = 0, first, adj_vertex;
+    
+    reached = (unsigned char *) calloc (csr->num_vertices + 1, 1);
+    if (by_degree) {
+        keys = (uint64_t *) malloc (sizeof(uint64_t) * (csr->num_vertices + 1));
+    }
+    if (reached == NULL || (by_degree && keys == NULL)) {
+        free(reached);
+        free(keys);
+        
+        return FALSE;
+    }
+    
+    /*
+     * The order doubles up as the queue.
+     */
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        if (reached[starts[i]]) {
+            continue;
+        }
+        reached[starts[i]] = 1;
+        order[count++] = starts[i];
+        for (unsigned int head = count - 1; head < count; head++) {
+            first = count;
+            for (unsigned int j = csr->offsets[order[head]];
+                 j < csr->offsets[order[head] + 1]; j++) {
+                adj_vertex = csr->neighbors[j];
+                if (!reached[adj_vertex]) {
+                    reached[adj_vertex] = 1;
+                    order[count++] = adj_vertex;
+                }
+            }
+            if (by_degree) {
+                sort_by_degree(order + first, count - first, keys, csr, FALSE);
+            }
+        }
+    }
+    free(reached);
+    free(keys);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Find the order of the vertices.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] method How to order them.
+ * @param[out] order The vertices in their new order.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean find_order (csr_graph_t *csr, csr_order_t method,
+                           unsigned int *order)
+{
+    unsigned int *starts, swap;
+    uint64_t *keys;
+    boolean found;
+    
+    starts = (unsigned int *) malloc (sizeof(unsigned int) * (csr->num_vertices + 1));
+    keys = (uint64_t *) malloc (sizeof(uint64_t) * (csr->num_vertices + 1));
+    if (starts == NULL || keys == NULL) {
+        free(starts);
+        free(keys);
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < csr->num_vertices; i++) {
+        starts[i] = i;
+    }
+    switch (method) {
+    case CSR_ORDER_DEGREE:
+        memcpy(order, starts, sizeof(unsigned int) * csr->num_vertices);
+        sort_by_degree(order, csr->num_vertices, keys, csr, TRUE);
+        found = TRUE;
+        break;
+    
+    case CSR_ORDER_RCM:
+        
+        /*
+         * Starting each part from a vertex of least degree tends to start it
+         * near its edge, which keeps the levels narrow.
+         */
+        sort_by_degree(starts, csr->num_vertices, keys, csr, FALSE);
+        found = order_breadth_first(csr, starts, TRUE, order);
+        for (unsigned int i = 0; found && i < csr->num_vertices / 2; i++) {
+            swap = order[i];
+            order[i] = order[csr->num_vertices - 1 - i];
+            order[csr->num_vertices - 1 - i] = swap;
+        }
+        break;
+    
+    default:
+        found = order_breadth_first(csr, starts, FALSE, order);
+        break;
+    }
+    free(starts);
+    free(keys);
+    
+    return found;
+}
+
+/**
+ * @brief Build a snapshot with the vertices of another one renumbered.
+ *
+ * @details
+ * order[i] is the number in csr of the vertex numbered i in the new snapshot,
+ * every vertex of csr appearing exactly once. The data of the vertices is
+ * shared with csr, which must outlive the new snapshot if it was loaded from
+ * a file, as the data is in its mapping.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] order The number in csr of every vertex of the new snapshot.
+ *
+ * @return Pointer to the new CSR snapshot if successful, NULL if order isn't
+ *         a permutation of the vertices or memory allocation failed.
+ */
+csr_graph_t *csr_permute (csr_graph_t *csr, const unsigned int *order)
+{
+    csr_graph_t *permuted;
+    unsigned int *position = NULL, num_vertices, num_entries, old, first;
+    
+    num_vertices = csr->num_vertices;
+    permuted = (csr_graph_t *) calloc (1, sizeof(csr_graph_t));
+    position = (unsigned int *) malloc (sizeof(unsigned int) * (num_vertices + 1));
+    if (permuted == NULL || position == NULL) {
+        goto fail;
+    }
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        position[i] = UINT_MAX;
+    }
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        if (order[i] >= num_vertices || position[order[i]] != UINT_MAX) {
+            goto fail;
+        }
+        position[order[i]] = i;
+    }
+    
+    num_entries = csr->offsets[num_vertices];
+    permuted->num_vertices = num_vertices;
+    permuted->directed = csr->directed;
+    permuted->print_data = csr->print_data;
+    permuted->data_is_equal = csr->data_is_equal;
+    permuted->offsets = (unsigned int *) malloc (sizeof(unsigned int) * (num_vertices + 1));
+    permuted->neighbors = (unsigned int *) malloc (sizeof(unsigned int) * (num_entries + 1));
+    permuted->data = (void **) malloc (sizeof(void *) * (num_vertices + 1));
+    permuted->original_ids = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                      (num_vertices + 1));
+    if (permuted->offsets == NULL || permuted->neighbors == NULL ||
+        permuted->data == NULL || permuted->original_ids == NULL) {
+        goto fail;
+    }
+    num_entries = 0;
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        old = order[i];
+        permuted->offsets[i] = num_entries;
+        permuted->data[i] = csr->data[old];
+        permuted->original_ids[i] = csr_original_id(csr, old);
+        first = num_entries;
+        for (unsigned int j = csr->offsets[old]; j < csr->offsets[old + 1]; j++) {
+            permuted->neighbors[num_entries++] = position[csr->neighbors[j]];
+        }
+        qsort(permuted->neighbors + first, num_entries - first, sizeof(unsigned int),
+              compare_numbers);
+    }
+    permuted->offsets[num_vertices] = num_entries;
+    if (csr->in_offsets && !build_csr_in_edges(permuted)) {
+        goto fail;
+    }
+    if (csr->index && !build_csr_index(permuted, csr->data_hash)) {
+        goto fail;
+    }
+    free(position);
+    
+    return permuted;
+
+fail:
+    free(position);
+    destroy_csr_graph(permuted);
+    
+    return NULL;
+}
+
+/**
+ * @brief Build a snapshot with the vertices of another one renumbered to
+ *        improve the locality of the searches over it.
+ *
+ * @details
+ * The breadth first order numbers the vertices of each level together, the
+ * reverse Cuthill-McKee order also keeps the numbers of adjacent vertices
+ * close, which suits walks that spread out, and the degree order packs the
+ * busiest vertices, the ones most searches touch, into the fewest pages. In
+ * a directed snapshot the orders follow the edges out of each vertex. The
+ * new snapshot is built as csr_permute builds it.
+ *
+ * Vertex 0 of the new snapshot is whichever vertex the order put first, not
+ * the graph's vertex. csr_find and the searches and traversals of the whole
+ * snapshot don't depend on it, while the searches from a source should be
+ * given its new number, which csr_find tells.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] method How to order the vertices.
+ *
+ * @return Pointer to the new CSR snapshot if successful, NULL if memory
+ *         allocation failed.
+ */
+csr_graph_t *csr_reorder (csr_graph_t *csr, csr_order_t method)
+{
+    csr_graph_t *reordered = NULL;
+    unsigned int *order;
+    
+    order = (unsigned int *) malloc (sizeof(unsigned int) * (csr->num_vertices + 1));
+    if (order == NULL) {
+        
+        return NULL;
+    }
+    if (find_order(csr, method, order)) {
+        reordered = csr_permute(csr, order);
+    }
+    free(order);
+    
+    return reordered;
+}
+
+/**
+ * @brief Return the number a vertex had when the graph was frozen.
+ *
+ * @details
+ * The original numbers of a reordered snapshot are saved along with it, so
+ * a snapshot loaded from a file remembers them too.
+ *
+ * @param[in] csr Pointer to the CSR snapshot.
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return The original number of the vertex.
+ */
+unsigned int csr_original_id (csr_graph_t *csr, unsigned int vertex)
+{
+    if (csr->original_ids == NULL) {
+        
+        return vertex;
+    }
+    
+    return csr->original_ids[vertex];
+}
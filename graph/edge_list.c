@@ -0,0 +1,622 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file edge_list.c
+ * @author Ashutosh Grewal
+ * @date 03/18/17.
+ *
+ * @brief This file implements loading the edges of a graph from an edge list
+ *        file.
+ *
+ * @details
+ * Loading is a pipeline of two threads handing chunks of edges to each other.
+ * A parse thread reads the file a block at a time and turns it into chunks
+ * of vertex id pairs. The calling thread takes each chunk, resolves the ids
+ * to the data of their vertices, adds the vertices it hasn't seen before and
+ * then the edges, each chunk being one batch for the graph. There are only
+ * two chunks, one being filled while the other is added, so the memory taken
+ * on top of the graph is bounded by the chunk size however big the file is.
+ * The ids seen so far are kept in a hash table of their own, so the user's
+ * function to make the data of a vertex is only called once per id.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "csr.h"
+#include "edge_list.h"
+#include "hash_table.h"
+
+/**
+ * Number of edges in a chunk if the caller doesn't say.
+ */
+#define EDGE_LIST_CHUNK 65536
+
+/**
+ * Number of bytes the parse thread reads at a time, also the longest line a
+ * text file may have.
+ */
+#define EDGE_LIST_BLOCK 65536
+
+/**
+ * @brief A chunk of edges parsed from the file.
+ */
+typedef struct edge_chunk_s {
+    unsigned long *ids; /**< The ids of the two ends of each edge. */
+    float *weights; /**< Weight of each edge, 1 if the file has none. */
+    unsigned int count; /**< Number of edges in the chunk. */
+    boolean weighted; /**< TRUE if any of the edges had a weight. */
+} edge_chunk_t;
+
+/**
+ * @brief The state of a load, shared by its two threads.
+ */
+typedef struct edge_load_s {
+    FILE *file; /**< The edge list. */
+    edge_list_format_t format; /**< How the edges are written in the file. */
+    unsigned int chunk_size; /**< Number of edges a chunk has room for. */
+    edge_chunk_t chunks[2]; /**< The chunks, handed round in turn. */
+    unsigned int filled; /**< Number of chunks parsed and not yet added. */
+    boolean finished; /**< TRUE once the parse thread is done. */
+    boolean failed; /**< TRUE if the file couldn't be read or parsed. */
+    boolean stop; /**< TRUE if the parse thread should give up. */
+    pthread_mutex_t lock; /**< Protects filled and the flags. */
+    pthread_cond_t changed; /**< Signalled when any of them changes. */
+} edge_load_t;
+
+/**
+ * @brief Hand a chunk the parse thread has filled to the calling thread and
+ *        wait for the next chunk to be free.
+ *
+ * @param[in, out] load The load.
+ * @param[in, out] chunk Number of the chunk, moved on to the next one.
+ *
+ * @return TRUE if the parse thread should carry on, FALSE otherwise.
+ */
+static boolean hand_over_chunk (edge_load_t *load, unsigned int *chunk)
+{
+    boolean carry_on;
+    
+    pthread_mutex_lock(&load->lock);
+    load->filled++;
+    pthread_cond_signal(&load->changed);
+    while (load->filled == 2 && !load->stop) {
+        pthread_cond_wait(&load->changed, &load->lock);
+    }
+    carry_on = !load->stop;
+    pthread_mutex_unlock(&load->lock);
+    *chunk ^= 1;
+    load->chunks[*chunk].count = 0;
+    load->chunks[*chunk].weighted = FALSE;
+    
+    return carry_on;
+}
+
+/**
+ * @brief Add an edge to the chunk being filled, handing it over once full.
+ *
+ * @param[in, out] load The load.
+ * @param[in, out] chunk Number of the chunk being filled.
+ * @param[in] from Id of the first end.
+ * @param[in] to Id of the second end.
+ * @param[in] weight Weight of the edge.
+ * @param[in] weighted TRUE if the weight came from the file.
+ *
+ * @return TRUE if the parse thread should carry on, FALSE otherwise.
+ */
+static boolean add_to_chunk (edge_load_t *load, unsigned int *chunk,
+                             unsigned long from, unsigned long to, float weight,
+                             boolean weighted)
+{
+    edge_chunk_t *current = &load->chunks[*chunk];
+    
+    current->ids[2 * current->count] = from;
+    current->ids[2 * current->count + 1] = to;
+    current->weights[current->count] = weight;
+    current->weighted |= weighted;
+    if (++current->count < load->chunk_size) {
+        
+        return TRUE;
+    }
+    
+    return hand_over_chunk(load, chunk);
+}
+
+/**
+ * @brief Parse a line of a text edge list.
+ *
+ * @param[in] line The line, terminated by a 0.
+ * @param[out] from Id of the first end.
+ * @param[out] to Id of the second end.
+ * @param[out] weight Weight of the edge.
+ * @param[out] weighted TRUE if the line has a weight.
+ *
+ * @return 1 if the line has an edge, 0 if it's blank or a comment, -1 if it
+ *         can't be parsed.
+ */
+static int parse_line (char *line, unsigned long *from, unsigned long *to,
+                       float *weight, boolean *weighted)
+{
+    char *end;
+    
+    line += strspn(line, " \t\r");
+    if (*line == '\0' || *line == '#' || *line == '%') {
+        
+        return 0;
+    }
+    *from = strtoul(line, &end, 10);
+    if (end == line) {
+        
+        return -1;
+    }
+    line = end;
+    *to = strtoul(line, &end, 10);
+    if (end == line) {
+        
+        return -1;
+    }
+    line = end + strspn(end, " \t\r");
+    *weight = 1;
+    *weighted = FALSE;
+    if (*line != '\0') {
+        *weight = strtof(line, &end);
+        if (end == line) {
+            
+            return -1;
+        }
+        *weighted = TRUE;
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief Parse a text edge list.
+ *
+ * @details
+ * A line cut in two by the end of a block is moved to the start of the
+ * buffer, and the rest of it read in after it.
+ *
+ * @param[in, out] load The load.
+ * @param[in, out] chunk Number of the chunk being filled.
+ *
+ * @return TRUE if the whole file was parsed, FALSE otherwise.
+ */
+static boolean parse_text (edge_load_t *load, unsigned int *chunk)
+{
+    char *buffer, *line, *newline;
+    size_t length = 0, got;
+    unsigned long from, to;
+    float weight;
+    boolean weighted, at_end = FALSE, parsed = FALSE;
+    int result;
+    
+    buffer = (char *) malloc (EDGE_LIST_BLOCK + 1);
+    if (buffer == NULL) {
+        
+        return FALSE;
+    }
+    while (!at_end) {
+        got = fread(buffer + length, 1, EDGE_LIST_BLOCK - length, load->file);
+        length += got;
+        at_end = (length < EDGE_LIST_BLOCK);
+        if (at_end && ferror(load->file)) {
+            goto done;
+        }
+        buffer[length] = '\0';
+        line = buffer;
+        for (;;) {
+            newline = memchr(line, '\n', length - (size_t) (line - buffer));
+            if (newline == NULL) {
+                if (!at_end) {
+                    break;
+                }
+                newline = buffer + length;
+            }
+            *newline = '\0';
+            result = parse_line(line, &from, &to, &weight, &weighted);
+            if (result < 0) {
+                goto done;
+            }
+            if (result > 0 && !add_to_chunk(load, chunk, from, to, weight, weighted)) {
+                goto done;
+            }
+            if (newline == buffer + length) {
+                break;
+            }
+            line = newline + 1;
+        }
+        if (at_end) {
+            break;
+        }
+        
+        /*
+         * A line that doesn't fit in the buffer can't be parsed.
+         */
+        if (line == buffer) {
+            goto done;
+        }
+        length -= (size_t) (line - buffer);
+        memmove(buffer, line, length);
+    }
+    parsed = TRUE;
+
+done:
+    free(buffer);
+    
+    return parsed;
+}
+
+/**
+ * @brief Parse a binary edge list.
+ *
+ * @param[in, out] load The load.
+ * @param[in, out] chunk Number of the chunk being filled.
+ *
+ * @return TRUE if the whole file was parsed, FALSE otherwise.
+ */
+static boolean parse_binary (edge_load_t *load, unsigned int *chunk)
+{
+    uint32_t *buffer;
+    size_t got;
+    boolean parsed = FALSE;
+    
+    buffer = (uint32_t *) malloc (EDGE_LIST_BLOCK);
+    if (buffer == NULL) {
+        
+        return FALSE;
+    }
+    for (;;) {
+        got = fread(buffer, sizeof(uint32_t), EDGE_LIST_BLOCK / sizeof(uint32_t),
+                    load->file);
+        
+        /*
+         * The file must end on a whole edge.
+         */
+        if (got % 2 != 0) {
+            goto done;
+        }
+        for (size_t i = 0; i < got; i += 2) {
+            if (!add_to_chunk(load, chunk, buffer[i], buffer[i + 1], 1, FALSE)) {
+                goto done;
+            }
+        }
+        if (got < EDGE_LIST_BLOCK / sizeof(uint32_t)) {
+            break;
+        }
+    }
+    parsed = !ferror(load->file);
+
+done:
+    free(buffer);
+    
+    return parsed;
+}
+
+/**
+ * @brief Body of the parse thread.
+ *
+ * @param[in] arg The load.
+ *
+ * @return NULL.
+ */
+static void *parse_thread (void *arg)
+{
+    edge_load_t *load = (edge_load_t *) arg;
+    unsigned int chunk = 0;
+    boolean parsed;
+    
+    if (load->format == EDGE_LIST_BINARY) {
+        parsed = parse_binary(load, &chunk);
+    } else {
+        parsed = parse_text(load, &chunk);
+    }
+    
+    /*
+     * Hand over what's left of the last chunk along with the news that there
+     * are no more.
+     */
+    pthread_mutex_lock(&load->lock);
+    if (parsed && load->chunks[chunk].count > 0) {
+        load->filled++;
+    }
+    load->failed = !parsed && !load->stop;
+    load->finished = TRUE;
+    pthread_cond_signal(&load->changed);
+    pthread_mutex_unlock(&load->lock);
+    
+    return NULL;
+}
+
+/**
+ * @brief Hash a vertex id.
+ *
+ * @param[in] key The id.
+ *
+ * @return The hash.
+ */
+static unsigned long hash_id (void *key)
+{
+    unsigned long hash = (unsigned long) (uintptr_t) key;
+    
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdUL;
+    hash ^= hash >> 33;
+    
+    return hash;
+}
+
+/**
+ * @brief Compare two vertex ids.
+ *
+ * @param[in] key1 First id.
+ * @param[in] key2 Second id.
+ *
+ * @return TRUE if they are the same, FALSE otherwise.
+ */
+static boolean id_is_equal (void *key1, void *key2)
+{
+    return key1 == key2;
+}
+
+/**
+ * @brief What the calling thread needs to add a chunk to the graph.
+ */
+typedef struct edge_resolver_s {
+    graph_t *graph; /**< The graph being loaded. */
+    hash_table_t *ids; /**< Data of every id seen so far. */
+    vertex_data_t vertex_data; /**< Makes the data of a new id. */
+    void *arg; /**< Opaque argument passed to vertex_data. */
+    void **new_data; /**< Data of the vertices new to the graph. */
+    unsigned int num_new; /**< Number of them. */
+    void **from_data; /**< Data of the first end of each edge. */
+    void **to_data; /**< Data of the second end of each edge. */
+    float *weights; /**< Weight of each edge. */
+} edge_resolver_t;
+
+/**
+ * @brief Find the data of the vertex with this id, making it if the id is new.
+ *
+ * @param[in, out] resolver The resolver.
+ * @param[in] id The id.
+ *
+ * @return The data, NULL if the user's function failed to make it or memory
+ *         allocation failed.
+ */
+static void *resolve_id (edge_resolver_t *resolver, unsigned long id)
+{
+    void *key = (void *) (uintptr_t) id, *data;
+    
+    data = lookup_in_hash_table(resolver->ids, key);
+    if (data != NULL) {
+        
+        return data;
+    }
+    data = resolver->vertex_data(id, resolver->arg);
+    if (data == NULL || !insert_to_hash_table(resolver->ids, key, data)) {
+        
+        return NULL;
+    }
+    
+    /*
+     * The id may name a vertex the graph had before the load started, which
+     * find_in_graph looks up in the index or the registry, so it's found even
+     * if nothing connects it to the graph's vertex. Taking it for a new one
+     * would make adding the chunk's vertices fail on the duplicate.
+     */
+    if (find_in_graph(resolver->graph, data) == NULL) {
+        resolver->new_data[resolver->num_new++] = data;
+    }
+    
+    return data;
+}
+
+/**
+ * @brief Add a chunk of edges, and the vertices new to the graph, to the
+ *        graph.
+ *
+ * @details
+ * A vertex can't have an edge to itself, so such edges are dropped.
+ *
+ * @param[in, out] resolver The resolver.
+ * @param[in] chunk The chunk.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean add_chunk (edge_resolver_t *resolver, edge_chunk_t *chunk)
+{
+    unsigned long from, to;
+    unsigned int num_edges = 0;
+    
+    resolver->num_new = 0;
+    for (unsigned int i = 0; i < chunk->count; i++) {
+        from = chunk->ids[2 * i];
+        to = chunk->ids[2 * i + 1];
+        if (from == to) {
+            continue;
+        }
+        resolver->from_data[num_edges] = resolve_id(resolver, from);
+        resolver->to_data[num_edges] = resolve_id(resolver, to);
+        if (resolver->from_data[num_edges] == NULL || resolver->to_data[num_edges] == NULL) {
+            
+            return FALSE;
+        }
+        resolver->weights[num_edges] = chunk->weights[i];
+        num_edges++;
+    }
+    if (resolver->num_new > 0 &&
+        !add_vertices_batch(resolver->graph, resolver->new_data, resolver->num_new)) {
+        
+        return FALSE;
+    }
+    
+    return num_edges == 0 ||
+           add_weighted_edges_batch(resolver->graph, resolver->from_data,
+                                    resolver->to_data,
+                                    chunk->weighted ? resolver->weights : NULL,
+                                    num_edges);
+}
+
+/**
+ * @brief Load the edges of an edge list file into the graph.
+ *
+ * @details
+ * Every id in the file names a vertex, whose data the vertex_data function
+ * makes the first time the id comes up. If the graph already has a vertex
+ * with that data, the edges are added to it. The data must not be NULL and
+ * the graph should be indexed, or telling whether each new id's vertex is
+ * already in the graph scans the whole registry. The edges go from the first
+ * id to the second one in a directed graph, and the edges of a vertex to
+ * itself are dropped. Should the load fail part of the way through, the
+ * chunks added by then stay in the graph.
+ *
+ * @note
+ * Every edge in the file is added, without looking for it in the graph
+ * first. An undirected graph loaded from a list naming each edge in both
+ * directions, as many lists of undirected graphs do, gets two parallel edges
+ * for each, so such a list should name every edge once.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] path Path of the edge list file.
+ * @param[in] format How the edges are written in the file.
+ * @param[in] chunk_size Number of edges to add to the graph at a time, 0 for
+ *                       the default.
+ * @param[in] vertex_data Function making the data of the vertex with an id.
+ * @param[in] arg Opaque argument passed to vertex_data.
+ *
+ * @return TRUE if all the edges are loaded, FALSE if the file can't be read
+ *         or parsed, vertex_data failed, or memory allocation failed.
+ */
+boolean graph_load_edge_list (graph_t *graph, const char *path,
+                              edge_list_format_t format, unsigned int chunk_size,
+                              vertex_data_t vertex_data, void *arg)
+{
+    edge_load_t load;
+    edge_resolver_t resolver;
+    pthread_t parser;
+    boolean started = FALSE, loaded = FALSE, more;
+    unsigned int chunk = 0;
+    
+    memset(&load, 0, sizeof(edge_load_t));
+    memset(&resolver, 0, sizeof(edge_resolver_t));
+    load.format = format;
+    load.chunk_size = chunk_size ? chunk_size : EDGE_LIST_CHUNK;
+    resolver.graph = graph;
+    resolver.vertex_data = vertex_data;
+    resolver.arg = arg;
+    resolver.ids = create_hash_table(hash_id, id_is_equal);
+    resolver.new_data = (void **) malloc (sizeof(void *) * 2 * load.chunk_size);
+    resolver.from_data = (void **) malloc (sizeof(void *) * load.chunk_size);
+    resolver.to_data = (void **) malloc (sizeof(void *) * load.chunk_size);
+    resolver.weights = (float *) malloc (sizeof(float) * load.chunk_size);
+    for (unsigned int i = 0; i < 2; i++) {
+        load.chunks[i].ids = (unsigned long *) malloc (sizeof(unsigned long) *
+                                                       2 * load.chunk_size);
+        load.chunks[i].weights = (float *) malloc (sizeof(float) * load.chunk_size);
+        if (load.chunks[i].ids == NULL || load.chunks[i].weights == NULL) {
+            goto done;
+        }
+    }
+    if (resolver.ids == NULL || resolver.new_data == NULL || resolver.from_data == NULL ||
+        resolver.to_data == NULL || resolver.weights == NULL) {
+        goto done;
+    }
+    load.file = fopen(path, format == EDGE_LIST_BINARY ? "rb" : "r");
+    if (load.file == NULL) {
+        goto done;
+    }
+    if (pthread_mutex_init(&load.lock, NULL) != 0) {
+        goto done;
+    }
+    if (pthread_cond_init(&load.changed, NULL) != 0) {
+        pthread_mutex_destroy(&load.lock);
+        goto done;
+    }
+    started = (pthread_create(&parser, NULL, parse_thread, &load) == 0);
+    loaded = started;
+    
+    /*
+     * Take the chunks in the order the parse thread fills them. If adding
+     * one fails, tell the parse thread to stop and let it finish.
+     */
+    while (started) {
+        pthread_mutex_lock(&load.lock);
+        while (load.filled == 0 && !load.finished) {
+            pthread_cond_wait(&load.changed, &load.lock);
+        }
+        more = (load.filled > 0 && !load.stop);
+        pthread_mutex_unlock(&load.lock);
+        if (!more) {
+            break;
+        }
+        if (!add_chunk(&resolver, &load.chunks[chunk])) {
+            loaded = FALSE;
+            pthread_mutex_lock(&load.lock);
+            load.stop = TRUE;
+            pthread_cond_signal(&load.changed);
+            pthread_mutex_unlock(&load.lock);
+            break;
+        }
+        chunk ^= 1;
+        pthread_mutex_lock(&load.lock);
+        load.filled--;
+        pthread_cond_signal(&load.changed);
+        pthread_mutex_unlock(&load.lock);
+    }
+    if (started) {
+        pthread_join(parser, NULL);
+        loaded = loaded && !load.failed;
+    }
+    pthread_cond_destroy(&load.changed);
+    pthread_mutex_destroy(&load.lock);
+
+done:
+    if (load.file != NULL) {
+        fclose(load.file);
+    }
+    for (unsigned int i = 0; i < 2; i++) {
+        free(load.chunks[i].ids);
+        free(load.chunks[i].weights);
+    }
+    destroy_hash_table(resolver.ids);
+    free(resolver.new_data);
+    free(resolver.from_data);
+    free(resolver.to_data);
+    free(resolver.weights);
+    
+    return loaded;
+}
+
+/**
+ * @brief Load the edges of an edge list file into the graph and freeze it.
+ *
+ * @details
+ * The graph stays as loaded, the caller may destroy it once it only needs
+ * the snapshot.
+ *
+ * @see graph_load_edge_list
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] path Path of the edge list file.
+ * @param[in] format How the edges are written in the file.
+ * @param[in] chunk_size Number of edges to add to the graph at a time, 0 for
+ *                       the default.
+ * @param[in] vertex_data Function making the data of the vertex with an id.
+ * @param[in] arg Opaque argument passed to vertex_data.
+ *
+ * @return Pointer to the CSR snapshot if successful, NULL otherwise.
+ */
+csr_graph_t *graph_load_edge_list_to_csr (graph_t *graph, const char *path,
+                                          edge_list_format_t format,
+                                          unsigned int chunk_size,
+                                          vertex_data_t vertex_data, void *arg)
+{
+    if (!graph_load_edge_list(graph, path, format, chunk_size, vertex_data, arg)) {
+        
+        return NULL;
+    }
+    
+    return graph_freeze(graph);
+}
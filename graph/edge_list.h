@@ -0,0 +1,36 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file edge_list.h
+ * @author Ashutosh Grewal
+ * @date 03/18/17.
+ *
+ * @brief Header file containing APIs to load the edges of a graph from an
+ *        edge list file.
+ */
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include "public.h"
+#include "graph.h"
+#include "csr.h"
+
+/**
+ * @brief How the edges are written in the file.
+ */
+typedef enum edge_list_format_e {
+    EDGE_LIST_TEXT, /**< A line for every edge, the ids of its two ends and
+                         optionally its weight separated by blanks. Lines
+                         starting with '#' or '%' are comments. */
+    EDGE_LIST_BINARY /**< Two 32 bit ids for every edge, in the byte order of
+                          the machine. */
+} edge_list_format_t;
+
+typedef void *(*vertex_data_t) (unsigned long, void *);
+
+boolean graph_load_edge_list (graph_t *, const char *, edge_list_format_t,
+                              unsigned int, vertex_data_t, void *);
+csr_graph_t *graph_load_edge_list_to_csr (graph_t *, const char *,
+                                          edge_list_format_t, unsigned int,
+                                          vertex_data_t, void *);
+
+#endif /* EDGE_LIST_H */
@@ -3,545 +3,2078 @@
  * @file graph.c
  * @author Ashutosh Grewal
  * @date 12/23/16
- * 
+ *
  * @brief This file implements the graph data structure.
  *
  * @details
- * A graph is set of vertices and edges. Each vertex is connected to a set
- * of other vertices through edges. This implementation stores data at each
+ * A graph is set of vertices and edges. Each vertex is connected to a set of
+ * other vertices through edges. This implementation stores data at each
  * vertex (another implementation might also have data assosciate with each
  * edge). The data stored is opaque allowing the user to store anything. The
- * adjacent vertices of each vertex are stored as an adjacency list (using 
- * the list implementation). The bread first and depth first traversal functions
- * use the queue and stack implentations respectively.
+ * adjacent vertices of each vertex are stored in an adjacency array, which
+ * also remembers where each edge is found in the other vertex's array so that
+ * deleting a vertex takes time proportional to its own degree. The bread
+ * first and depth first traversal functions use the queue and stack
+ * implentations respectively.
+ *
+ * If the user provides a function to hash the opaque data, the graph also
+ * keeps an index (using the hash table implementation) from the data to its
+ * vertex so that finding a vertex doesn't need a traversal. A graph created
+ * with a key type instead of the user's functions is always indexed.
+ *
+ * The vertices and the adjacency arrays are allocated through a pluggable
+ * allocator. By default every graph gets its own slab pool, which packs these
+ * small objects together and lets destroy_graph free them all at once, or
+ * graph_clear forget them while keeping the memory for the vertices added
+ * next.
+ *
+ * The searches and traversals keep their visited marks and frontier in a
+ * traversal context, never in the graph itself. The _with_context variants
+ * take the caller's context, so any number of threads can run them at once,
+ * each with its own context. The variants without a context share one owned
+ * by the graph and take turns using it. All of them hold the graph's lock for
+ * reading, while adding or deleting vertices holds it for writing, so the
+ * graph can be changed by one thread while others read it. They are all
+ * built on one walk that hands every vertex reached to a visitor, which the
+ * graph_bfs_visit and graph_dfs_visit APIs expose to the user.
+ * Readers that shouldn't wait for a batch of changes at all walk a version of
+ * the graph published with graph_snapshot_publish instead, so the graph marks
+ * the vertices it changes for the next version to copy.
+ *
+ * Every vertex is also kept in a dense registry, its id being its position
+ * there. Walking all the vertices, be they connected or not, is a loop over
+ * the registry instead of a traversal.
+ *
+ * A graph is undirected unless it's created directed. The edges of a directed
+ * graph are only kept by the vertex they go out of, and optionally by the one
+ * they go into as well, and the traversals and searches only follow them in
+ * their direction. The edges of a new vertex go out of it, so few edges, if
+ * any, go out of the graph's vertex, the first one added. The searches and
+ * traversals of a directed graph start from the graph's vertex and, once
+ * they run out of vertices to reach from there, carry on from the first
+ * vertex in the registry they haven't visited.
  *
  * @bug
- * If a vertex's only adjacent vertex in the graph is deleted, this vertex will
- * get leaked.
+ * If a vertex's only adjacent vertex in an undirected graph is deleted, the
+ * traversals can't reach this vertex any more. It is still part of the graph
+ * though, and gets freed along with it or by delete_unreachable_from_graph.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "public.h"
 #include "graph.h"
-#include "list.h"
+#include "adjacency.h"
 #include "queue.h"
 #include "stack.h"
+#include "hash_table.h"
+#include "traversal.h"
+#include "graph_private.h"
+#include "traversal_private.h"
+#include "allocator.h"
+#include "stats.h"
+#include "connectivity.h"
+#include "keys.h"
+#include "snapshot_private.h"
 
 /**
- * @brief The data structure that represents the vertex in the graph.
+ * @brief Create and initialize a graph, the common part of the create APIs.
  *
- * @details
- * The adjacent vertices to a vertex are stored as list.
- */
-struct vertex_s {
-    node_t *adjacent_vertex_list; /**< Head of the list of adjacent vertices.*/
-    void *data; /**< The data stored at the vertex.*/
-    boolean visited; /**< Boolean to help identify nodes already visited during
-                          a traversal. */
-};
-
-/**
- * @brief Create and initialize the graph data structure.
+ * @param[in] print_data Function to print the opaque data.
+ * @param[in] data_is_equal Function to compare the opaque data.
+ * @param[in] data_hash Function to hash the opaque data, NULL if the graph
+ *                      should not be indexed.
+ * @param[in] mode Whether the edges have a direction.
+ * @param[in] keys What the opaque data is.
  *
  * @return Pointer to the memory containing the struct if successful,
  *         NULL otherwise.
  */
-graph_t *create_graph (print_data_t print_data, data_is_equal_t data_is_equal)
+static graph_t *create_typed_graph (print_data_t print_data,
+                                    data_is_equal_t data_is_equal,
+                                    data_hash_t data_hash, graph_mode_t mode,
+                                    graph_key_t keys)
 {
     graph_t *new_graph;
     
-    new_graph = (graph_t *) malloc (sizeof(graph_t));
-    
-    if (new_graph != NULL) {
-        new_graph->vertex = NULL;
-        new_graph->print_data = print_data;
-        new_graph->data_is_equal = data_is_equal;
-    }
-    
-    return new_graph;
-}
-
-/**
- * @brief Make both the vertices adjacent to each other by adding them to
- *        each other's adjacency lists.
- *
- * @param[in, out] vertex1 First vertex.
- * @param[in, out] vertex2 Second vertex.
- */
-static void make_vertices_adjacent (vertex_t *vertex1, vertex_t *vertex2)
-{
-    add_to_list(&vertex1->adjacent_vertex_list, vertex2);
-    add_to_list(&vertex2->adjacent_vertex_list, vertex1);
-}
-
-/**
- * @brief Add a vertex to the graph.
- *
- * @details.
- * Adding a new vertex involves finding all the adjacent vertices using the adjacent
- * vertices data provided and settign up the assosciation.
- *
- * @param[in, out] graph Pointer to the graph data structure.
- * @param[in] data Information the new vertex will store.
- * @param[in] adj_vertex_data An array of opaque data identifying the adjacent vertices
- *                            to this new vertex.
- * @param[in] num_of_adj_vertices The number of adjacent vertices this new
- *                                vertex has.
- * 
- * @return TRUE if vertex is successfully added, FALSE otherwise.
- */
-boolean add_vertex_to_graph (graph_t *graph, void *data, void **adj_vertex_data,
-                             unsigned int num_of_adj_vertices)
-{
-    vertex_t *vertex = NULL, *lookup_vertex;
-    vertex_t **adjacent_vertices = NULL;
-    
-    adjacent_vertices = (vertex_t **) malloc (sizeof(vertex_t *) * num_of_adj_vertices);
-    
-    /*
-     * Let us make sure, this data doesn't exist in the graph already.
-     */
-    lookup_vertex = breadth_first_search(graph, data);
-    if (lookup_vertex != NULL) {
-        goto fail;
+    new_graph = (graph_t *) calloc (1, sizeof(graph_t));
+    if (new_graph == NULL) {
+        
+        return NULL;
     }
-    
-    /*
-     * Find all the adjacent vertices using the data provided.
-     */
-    for (int i = 0; i < num_of_adj_vertices; i++) {
-        lookup_vertex = breadth_first_search(graph, adj_vertex_data[i]);
-        if (lookup_vertex == NULL) {
+    new_graph->print_data = print_data;
+    new_graph->data_is_equal = data_is_equal;
+    new_graph->data_hash = data_hash;
+    new_graph->mode = mode;
+    new_graph->keys = keys;
+    if (data_hash != NULL) {
+        new_graph->index = create_hash_table(data_hash,
+                                             keys == GRAPH_KEY_INTEGER ?
+                                             NULL : data_is_equal);
+        if (new_graph->index == NULL) {
             goto fail;
         }
-        adjacent_vertices[i] = lookup_vertex;
     }
-    
-    vertex = (vertex_t *) malloc (sizeof(vertex_t));
-    if (vertex == NULL) {
+    new_graph->ctx = create_traversal_context();
+    if (new_graph->ctx == NULL) {
         goto fail;
     }
-    memset(vertex, 0, sizeof(vertex_t));
-    vertex->data = data;
-     
-    for (int i = 0; i < num_of_adj_vertices; i++) {
-        make_vertices_adjacent(adjacent_vertices[i], vertex);
+    if (!init_slab_allocator(&new_graph->allocator)) {
+        goto fail;
     }
-    if (graph->vertex == NULL) {
-        graph->vertex = vertex;
+    new_graph->owns_allocator = TRUE;
+    if (pthread_rwlock_init(&new_graph->lock, NULL) != 0) {
+        goto fail;
     }
-    if (adjacent_vertices) {
-        free(adjacent_vertices);
+    if (pthread_mutex_init(&new_graph->ctx_lock, NULL) != 0) {
+        pthread_rwlock_destroy(&new_graph->lock);
+        goto fail;
     }
     
-    return TRUE;
-    
+    return new_graph;
+
 fail:
-    if (vertex) {
-        free(vertex);
-    }
-    if (adjacent_vertices) {
-        free(adjacent_vertices);
-    }
+    destroy_traversal_context(new_graph->ctx);
+    destroy_hash_table(new_graph->index);
+    free(new_graph);
     
-    return FALSE;
+    return NULL;
 }
 
 /**
- * @brief Has this vertex been visited before?
+ * @brief Create and initialize the graph data structure.
  *
- * @param[in] vertex The vertex under consideration.
+ * @param[in] print_data Function to print the opaque data.
+ * @param[in] data_is_equal Function to compare the opaque data.
  *
- * @return TRUE if we've visited this vertex before, FALSE otherwise.
+ * @return Pointer to the memory containing the struct if successful,
+ *         NULL otherwise.
  */
-static boolean is_visited (vertex_t *vertex)
+graph_t *create_graph (print_data_t print_data, data_is_equal_t data_is_equal)
 {
-    if (vertex) {
-        return vertex->visited;
-    } else {
-        return FALSE;
-    }
+    return create_graph_with_hash(print_data, data_is_equal, NULL);
 }
 
 /**
- * @brief Mark this vertex as visited.
+ * @brief Create and initialize the graph data structure along with an index
+ *        from the opaque data to the vertex storing it.
+ *
+ * @details
+ * The index makes finding a vertex by its data an expected constant time
+ * operation instead of a traversal. The hash function must return the same
+ * value for data that data_is_equal considers equal.
+ *
+ * @param[in] print_data Function to print the opaque data.
+ * @param[in] data_is_equal Function to compare the opaque data.
+ * @param[in] data_hash Function to hash the opaque data, NULL if the graph
+ *                      should not be indexed.
  *
- * @param[in] vertex The vertex we're asked to mark.
+ * @return Pointer to the memory containing the struct if successful,
+ *         NULL otherwise.
  */
-static void mark_visited (vertex_t *vertex)
+graph_t *create_graph_with_hash (print_data_t print_data,
+                                 data_is_equal_t data_is_equal,
+                                 data_hash_t data_hash)
 {
-    if (vertex) {
-        vertex->visited = TRUE;
-    }
+    return create_graph_with_mode(print_data, data_is_equal, data_hash,
+                                  GRAPH_UNDIRECTED);
 }
 
 /**
- * @brief Mark this vertex as not visited.
+ * @brief Create and initialize a graph whose edges may have a direction.
  *
- * @param[in] vertex The vertex we're asked to mark.
+ * @details
+ * An edge of a directed graph goes from the vertex being added to each of its
+ * adjacent vertices, or from the first to the second end given to the batch
+ * APIs. Keeping only the edges out of each vertex takes half the memory and
+ * time to add an edge that an undirected graph does, but then deleting a
+ * vertex has to go through the edges of every vertex to find the ones into
+ * it. GRAPH_DIRECTED_IN_EDGES keeps the edges into each vertex too, which
+ * makes deleting a vertex take time proportional to its own edges again and
+ * lets the reverse searches follow the edges backwards.
+ *
+ * @see create_graph_with_hash
+ *
+ * @param[in] print_data Function to print the opaque data.
+ * @param[in] data_is_equal Function to compare the opaque data.
+ * @param[in] data_hash Function to hash the opaque data, NULL if the graph
+ *                      should not be indexed.
+ * @param[in] mode Whether the edges have a direction.
+ *
+ * @return Pointer to the memory containing the struct if successful,
+ *         NULL otherwise.
  */
-static void mark_not_visited (vertex_t *vertex)
+graph_t *create_graph_with_mode (print_data_t print_data,
+                                 data_is_equal_t data_is_equal,
+                                 data_hash_t data_hash, graph_mode_t mode)
 {
-    if (vertex) {
-        vertex->visited = FALSE;
-    }
+    return create_typed_graph(print_data, data_is_equal, data_hash, mode,
+                              GRAPH_KEY_OPAQUE);
 }
 
 /**
- * @brief Traverse the graph data structure in a breadth first fashion.
+ * @brief Create and initialize an indexed graph whose data is a key of a type
+ *        the graph knows how to compare and hash itself.
  *
  * @details
- * We traverse the graph starting from a node. This kind of traversal mandates
- * that we visit all adjacent vertices of a node before visiting any adjacent
- * vertices of the adjacent vertices. We carefully avoid re-visting already
- * visited nodes. We do so by pushing not yet visited adjacent vertices of the
- * node to a queue. We pop an element from the queue and repeat this process.
+ * An integer key is compared inline as a pointer, in the index as well, and a
+ * string key is hashed and compared once to find its vertex in the index.
+ * The searches then look for that vertex instead of calling back to compare
+ * every vertex they reach with the data, which for strings would mean going
+ * through the characters at every vertex.
  *
- * @note
- * We can also remove the visited mark from vertices after a search or traversal
- * by keeping pointers to all the visited nodes during the first pass. This
- * would have been a linear time complexity solution but would need us to
- * allocate pointers worth the # of vertices in the graph (linear space
- * complexity). The current solution requires no extra space.
+ * @see create_graph_with_mode
  *
- * @param[in] graph Pointer to the graph data structure.
+ * @param[in] print_data Function to print the opaque data.
+ * @param[in] keys GRAPH_KEY_INTEGER or GRAPH_KEY_STRING.
+ * @param[in] mode Whether the edges have a direction.
+ *
+ * @return Pointer to the memory containing the struct if successful,
+ *         NULL otherwise or if keys is GRAPH_KEY_OPAQUE.
  */
-void breadth_first_traversal (graph_t *graph)
+graph_t *create_graph_with_keys (print_data_t print_data, graph_key_t keys,
+                                 graph_mode_t mode)
 {
-    vertex_t *vertex, *adj_vertex;
-    queue_t *queue;
-    node_t *node;
-    
-    vertex = graph->vertex;
-    queue = create_queue();
-    
-    while (vertex) {
-        mark_visited(vertex);
-        graph->print_data(vertex->data);
+    switch (keys) {
+    case GRAPH_KEY_INTEGER:
         
-        /*
-         * Add non visited adjacent vertices of this vertex to the queue.
-         */
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (!is_visited(adj_vertex)) {
-                mark_visited(adj_vertex);
-                push_to_queue(queue, adj_vertex);
-            }
-        }
-        vertex = pop_from_queue(queue);
-    }
-    
-    /*
-     * Unmark all the vertices, to enable next search/traversal.
-     */
-    destroy_queue(queue);
-    queue = create_queue();
-    vertex = graph->vertex;
-    while (vertex) {
-        mark_not_visited(vertex);
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (is_visited(adj_vertex)) {
-                mark_not_visited(adj_vertex);
-                push_to_queue(queue, adj_vertex);
-            }
-        }
-        vertex = pop_from_queue(queue);
+        return create_typed_graph(print_data, integer_key_is_equal,
+                                  hash_integer_key, mode, keys);
+    case GRAPH_KEY_STRING:
+        
+        return create_typed_graph(print_data, string_key_is_equal,
+                                  hash_string_key, mode, keys);
+    default:
+        
+        return NULL;
     }
-    destroy_queue(queue);
 }
 
 /**
- * @brief Find a node with the given data in the graph traversing in a breadth
- *        first fashion.
+ * @brief Plug in the allocator the graph should use for its vertices and
+ *        their adjacency arrays.
  *
- * @see breadth_first_traversal
+ * @details
+ * This can only be done while the graph is empty. The allocator is copied,
+ * the pool it points to must outlive the graph. If the allocator can release
+ * its pool, destroy_graph will do that instead of freeing the vertices one
+ * by one.
  *
- * @param[in] graph Pointer to the graph data structure.
- * @param[in] data Opaque data for which we need to search.
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] allocator The allocator, NULL to go back to malloc and free.
  *
- * @return Pointer to vertex containing the opaque data in the graph if one exists,
- *         NULL otherwise.
+ * @return TRUE if successful, FALSE if the graph isn't empty.
  */
-vertex_t *breadth_first_search (graph_t *graph, void *data)
+boolean graph_set_allocator (graph_t *graph, allocator_t *allocator)
 {
-    vertex_t *vertex, *lookedup_vertex, *adj_vertex;
-    queue_t *queue;
-    node_t *node;
-    
-    vertex = graph->vertex;
-    queue = create_queue();
-    
-    while (vertex) {
-        mark_visited(vertex);
-        if (graph->data_is_equal(data, vertex->data)) {
-            break;
-        }
-            
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (!is_visited(adj_vertex)) {
-                mark_visited(adj_vertex);
-                push_to_queue(queue, adj_vertex);
-            }
-        }
-        vertex = pop_from_queue(queue);
-    }
-    lookedup_vertex = vertex;
+    boolean empty;
     
-    /*
-     * Unmark all the vertices that we marked to enable next search/traversal.
-     */
-    destroy_queue(queue);
-    queue = create_queue();
-    vertex = graph->vertex;
-    while (vertex) {
-        mark_not_visited(vertex);
-        if (graph->data_is_equal(data, vertex->data)) {
-            break;
+    pthread_rwlock_wrlock(&graph->lock);
+    empty = (graph->num_vertices == 0);
+    if (empty) {
+        if (graph->owns_allocator) {
+            destroy_slab_allocator(&graph->allocator);
+            graph->owns_allocator = FALSE;
         }
-        
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (is_visited(adj_vertex)) {
-                mark_not_visited(adj_vertex);
-                push_to_queue(queue, adj_vertex);
-            }
+        memset(&graph->allocator, 0, sizeof(allocator_t));
+        if (allocator != NULL) {
+            graph->allocator = *allocator;
         }
-        vertex = pop_from_queue(queue);
     }
-    destroy_queue(queue);
+    pthread_rwlock_unlock(&graph->lock);
     
-    return lookedup_vertex;
+    return empty;
 }
 
 /**
- * @brief Traverse the graph data structure in a depth first fashion.
- *
- * @details
- * We traverse the graph starting from a node. This kind of traversal mandates
- * that we visit adjacent vertices of a node's immediate adjacent vertices before
- * visiting the adjacent vertices of a node. We carefully avoid re-visiting 
- * already visited vertices. We do so by pushing not yet visited adjacent
- * vertices of the node to a stack. We pop an element from the stack and repeat
- * this process.
+ * @brief Return the allocator of the graph.
  *
  * @param[in] graph Pointer to the graph data structure.
+ *
+ * @return The allocator, NULL if the graph uses malloc and free.
  */
-void depth_first_traversal (graph_t *graph)
+static allocator_t *get_allocator (graph_t *graph)
 {
-    vertex_t *vertex, *adj_vertex;
-    stack_type *stack;
-    node_t *node;
-    
-    vertex = graph->vertex;
-    stack = create_stack();
-    
-    while (vertex) {
-        mark_visited(vertex);
-        graph->print_data(vertex->data);
-            
-        /*
-         * Add non visited adjacent vertices of this vertex to the queue.
-         */
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (!is_visited(adj_vertex)) {
-                mark_visited(adj_vertex);
-                push_to_stack(stack, adj_vertex);
-            }
-        }
-        vertex = pop_from_stack(stack);
+    if (graph->allocator.allocate == NULL) {
+        
+        return NULL;
     }
     
-    /*
-     * Unmark all the vertices, to enable next search/traversal.
-     */
-    destroy_stack(stack);
-    stack = create_stack();
-    vertex = graph->vertex;
-    while (vertex) {
-        mark_not_visited(vertex);
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (is_visited(adj_vertex)) {
-                mark_not_visited(adj_vertex);
-                push_to_stack(stack, adj_vertex);
-            }
-        }
-        vertex = pop_from_stack(stack);
-    }
-    destroy_stack(stack);
+    return &graph->allocator;
 }
 
 /**
- * @brief Find a node with the given data in the graph traversing in a depth
- *        first fashion.
+ * @brief Return the size of a vertex of the graph.
  *
- * @see depth_first_traversal
+ * @details
+ * Only the vertices of a graph that keeps the edges into them have room for
+ * the in adjacency.
  *
  * @param[in] graph Pointer to the graph data structure.
- * @param[in] data Opaque data for which we need to search.
  *
- * @return Pointer to vertex containing the opaque data in the graph if one exists,
- *         NULL otherwise.
+ * @return Size of a vertex.
  */
-vertex_t *depth_first_search (graph_t *graph, void *data)
+static size_t vertex_size (graph_t *graph)
 {
-    vertex_t *vertex, *lookedup_vertex, *adj_vertex;
-    stack_type *stack;
-    node_t *node;
-    
-    vertex = graph->vertex;
-    stack = create_stack();
-    
-    while (vertex) {
-        mark_visited(vertex);
-        if (graph->data_is_equal(data, vertex->data)) {
-            break;
-        }
+    if (graph->mode == GRAPH_DIRECTED_IN_EDGES) {
         
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (!is_visited(adj_vertex)) {
-                mark_visited(adj_vertex);
-                push_to_stack(stack, adj_vertex);
-            }
-        }
-        vertex = pop_from_stack(stack);
+        return sizeof(vertex_t) + sizeof(adjacency_t);
     }
-    lookedup_vertex = vertex;
     
-    /*
-     * Unmark all the vertices that we marked to enable next search/traversal.
-     */
-    destroy_stack(stack);
-    stack = create_stack();
-    vertex = graph->vertex;
-    while (vertex) {
-        mark_not_visited(vertex);
-        if (graph->data_is_equal(data, vertex->data)) {
-            break;
-        }
+    return sizeof(vertex_t);
+}
+
+/**
+ * @brief Return the bucket of the degree histogram a degree falls in.
+ *
+ * @param[in] degree The degree.
+ *
+ * @return The bucket.
+ */
+static inline unsigned int degree_bucket (unsigned int degree)
+{
+    if (degree == 0) {
         
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (is_visited(adj_vertex)) {
-                mark_not_visited(adj_vertex);
-                push_to_stack(stack, adj_vertex);
-            }
-        }
-        vertex = pop_from_stack(stack);
+        return 0;
     }
-    destroy_stack(stack);
     
-    return lookedup_vertex;
+    return sizeof(unsigned int) * 8 - __builtin_clz(degree);
 }
 
 /**
- * @brief Delete a passed in vertex from the graph.
+ * @brief Move a vertex to the bucket of its new degree in the histogram.
  *
- * @param[in,out] graph Pointer to the graph data structure.
- * @param[in] vertex Vertex we need to delete.
- *
- * @return TRUE if successfully deleted the specified vertex, FALSE otherwise.
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] old_degree Degree the vertex had.
+ * @param[in] new_degree Degree the vertex has now.
  */
-static boolean delete_vertex_from_graph (graph_t *graph, vertex_t *vertex)
+static void move_degree (graph_t *graph, unsigned int old_degree,
+                         unsigned int new_degree)
 {
-    vertex_t *adj_vertex;
-    node_t *node;
+    graph->degree_counts[degree_bucket(old_degree)]--;
+    graph->degree_counts[degree_bucket(new_degree)]++;
+}
 
-    if (vertex == NULL) {
+/**
+ * @brief Make an edge between two vertices of the graph.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in, out] from Vertex the edge goes out of, if it has a direction.
+ * @param[in, out] to Vertex the edge goes into, a different vertex than from.
+ * @param[in] weight Weight of the edge.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean link_edge (graph_t *graph, vertex_t *from, vertex_t *to,
+                          float weight)
+{
+    if (graph->mode == GRAPH_UNDIRECTED) {
+        if (!link_vertices(from, to, weight, get_allocator(graph))) {
+            
+            return FALSE;
+        }
+        move_degree(graph, get_adjacent_count(to) - 1, get_adjacent_count(to));
+    } else if (!link_directed(from, to, weight,
+                              graph->mode == GRAPH_DIRECTED_IN_EDGES,
+                              get_allocator(graph))) {
         
         return FALSE;
     }
-    
-    for (node=vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-        adj_vertex = get_data_from_node(node);
-        assert(delete_from_list(&adj_vertex->adjacent_vertex_list, vertex));
-        assert(delete_from_list(&vertex->adjacent_vertex_list, adj_vertex));
+    move_degree(graph, get_adjacent_count(from) - 1, get_adjacent_count(from));
+    graph->num_edges++;
+    join_components(graph, from, to);
+    mark_snapshot_vertex(graph, from);
+    if (graph->mode == GRAPH_UNDIRECTED) {
+        mark_snapshot_vertex(graph, to);
     }
     
-    assert(vertex->adjacent_vertex_list == NULL);
-    free(vertex);
-    
     return TRUE;
 }
 
 /**
- * @brief Delete a vertex - containing the specified data- from the graph.
+ * @brief Remove all the edges going out of a vertex, or all its edges if the
+ *        graph is undirected.
  *
  * @details
- * Deleting a vertex involves deleting this node from the adjacent list of
- * all the vertices that are adjacent.
- * 
- * @param[in,out] graph Pointer to the graph data structure.
- * @param[in] data Information the vertex we need to delete contains.
+ * Unlinking the edges from the end of the arrays doesn't move any of the
+ * others, and the mirrors take us straight to the other halves.
  *
- * @return TRUE if found and deleted a vertex containing the specifed data,
- * False otherwise.
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in, out] vertex The vertex.
  */
-boolean delete_from_graph (graph_t *graph, void *data)
+static void unlink_out_edges (graph_t *graph, vertex_t *vertex)
 {
-    vertex_t *vertex;
+    vertex_t *other;
     
-    vertex = breadth_first_search(graph, data);
-    return delete_vertex_from_graph(graph, vertex);
+    mark_snapshot_vertex(graph, vertex);
+    while (get_adjacent_count(vertex) > 0) {
+        if (graph->mode == GRAPH_UNDIRECTED) {
+            other = get_adjacent_vertex(vertex, 0);
+            mark_snapshot_vertex(graph, other);
+            unlink_adjacent_vertex(vertex, 0);
+            move_degree(graph, get_adjacent_count(other) + 1, get_adjacent_count(other));
+        } else {
+            unlink_out_vertex(vertex, 0, graph->mode == GRAPH_DIRECTED_IN_EDGES);
+        }
+        move_degree(graph, get_adjacent_count(vertex) + 1, get_adjacent_count(vertex));
+        graph->num_edges--;
+    }
 }
 
 /**
- * @brief Destory the graph, deleting all the vertexes and related assosciations
- * in the process.
+ * @brief Remove all the edges going into a vertex of a directed graph.
  *
  * @details
- * This is simply implemented as a DFS traversal in which we store each visited
- * vertex to a stack. ONce the traversal is complete, we delete all the vertices
- * stored in the stack.
- * 
- * @param[in,out] graph Pointer to the graph.
+ * Without the in adjacency, the edges into the vertex can only be found by
+ * looking at the edges of every vertex in the registry. Unlinking one moves
+ * the most recently linked edge into its place, so those are looked at from
+ * the oldest one on.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in, out] vertex The vertex.
  */
-void destroy_graph (graph_t *graph)
+static void unlink_in_edges (graph_t *graph, vertex_t *vertex)
 {
-    vertex_t *vertex, *adj_vertex;
-    stack_type *traversal_stack, *stack_with_all_vertices;
-    node_t *node;
+    vertex_t *other;
     
-    vertex = graph->vertex;
-    traversal_stack = create_stack();
-    stack_with_all_vertices = create_stack();
-    if (vertex) {
-        push_to_stack(stack_with_all_vertices, vertex);
-    }
-    
-    while (vertex) {
-        mark_visited(vertex);
-        
-        /*
-         * Add non visited adjacent vertices of this vertex to the queue.
-         */
-        for (node = vertex->adjacent_vertex_list; node; node = get_next_node(node)) {
-            adj_vertex = get_data_from_node(node);
-            if (!is_visited(adj_vertex)) {
-                mark_visited(adj_vertex);
-                push_to_stack(traversal_stack, adj_vertex);
-                push_to_stack(stack_with_all_vertices, adj_vertex);
+    if (graph->mode == GRAPH_DIRECTED_IN_EDGES) {
+        while (get_in_count(vertex) > 0) {
+            other = get_in_vertex(vertex, 0);
+            mark_snapshot_vertex(graph, other);
+            unlink_in_vertex(vertex, 0);
+            move_degree(graph, get_adjacent_count(other) + 1, get_adjacent_count(other));
+            graph->num_edges--;
+        }
+    } else if (graph->mode == GRAPH_DIRECTED) {
+        for (unsigned int i = 0; i < graph->num_vertices; i++) {
+            other = graph->vertices[i];
+            for (unsigned int j = get_adjacent_count(other); j > 0; j--) {
+                if (get_adjacent_vertex(other, j - 1) == vertex) {
+                    mark_snapshot_vertex(graph, other);
+                    unlink_out_vertex(other, j - 1, FALSE);
+                    move_degree(graph, get_adjacent_count(other) + 1,
+                                get_adjacent_count(other));
+                    graph->num_edges--;
+                }
             }
         }
-        vertex = pop_from_stack(traversal_stack);
     }
-    destroy_stack(traversal_stack);
+}
+
+/**
+ * @brief Free a vertex along with its adjacency arrays, which must not have
+ *        any edges left unless the whole graph is going away.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in, out] vertex The vertex.
+ */
+static void free_vertex (graph_t *graph, vertex_t *vertex)
+{
+    destroy_adjacency(vertex, get_allocator(graph));
+    if (graph->mode == GRAPH_DIRECTED_IN_EDGES) {
+        destroy_in_adjacency(vertex, get_allocator(graph));
+    }
+    free_memory(get_allocator(graph), vertex, vertex_size(graph));
+}
+
+/**
+ * @brief Make room in the registry for more vertices.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] extra Number of vertices about to be added.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean reserve_registry (graph_t *graph, unsigned int extra)
+{
+    vertex_t **vertices;
+    unsigned int capacity;
+    
+    if (graph->num_vertices + extra <= graph->vertices_capacity) {
+        
+        return TRUE;
+    }
+    capacity = graph->vertices_capacity ? graph->vertices_capacity : 16;
+    while (capacity < graph->num_vertices + extra) {
+        capacity *= 2;
+    }
+    vertices = (vertex_t **) realloc (graph->vertices, sizeof(vertex_t *) * capacity);
+    if (vertices == NULL) {
+        
+        return FALSE;
+    }
+    graph->vertices = vertices;
+    if (!reserve_components(graph, capacity)) {
+        
+        return FALSE;
+    }
+    graph->vertices_capacity = capacity;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Add a new vertex to the registry of all the vertices, its id being
+ *        its position in the registry.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in, out] vertex The new vertex.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean add_to_registry (graph_t *graph, vertex_t *vertex)
+{
+    if (!reserve_registry(graph, 1)) {
+        
+        return FALSE;
+    }
+    vertex->id = graph->num_vertices;
+    graph->vertices[graph->num_vertices++] = vertex;
+    graph->degree_counts[0]++;
+    add_component(graph, vertex);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Remove a vertex from the registry. The last vertex of the registry
+ *        takes its place, keeping the registry dense.
+ *
+ * @details
+ * The vertex must have no edges left by the time the caller is done with it,
+ * as it leaves the degree histogram from the bucket of the vertices without
+ * edges.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex The vertex being deleted.
+ */
+static void remove_from_registry (graph_t *graph, vertex_t *vertex)
+{
+    vertex_t *last;
+    
+    last = graph->vertices[--graph->num_vertices];
+    graph->vertices[vertex->id] = last;
+    last->id = vertex->id;
+    graph->degree_counts[0]--;
+    mark_snapshot_moved(graph, last);
+}
+
+/**
+ * @brief Return the number of vertices in the graph.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ *
+ * @return Number of vertices.
+ */
+unsigned int get_graph_vertex_count (graph_t *graph)
+{
+    return graph->num_vertices;
+}
+
+/**
+ * @brief Return the number of edges in the graph.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ *
+ * @return Number of edges.
+ */
+unsigned long get_graph_edge_count (graph_t *graph)
+{
+    return graph->num_edges;
+}
+
+/**
+ * @brief Return the degree of a vertex, the number of edges going out of it
+ *        in a directed graph.
+ *
+ * @param[in] vertex The vertex.
+ *
+ * @return The degree, 0 if the passed in vertex is NULL.
+ */
+unsigned int get_vertex_degree (vertex_t *vertex)
+{
+    if (vertex == NULL) {
+        
+        return 0;
+    }
+    
+    return get_adjacent_count(vertex);
+}
+
+/**
+ * @brief Return the histogram of the degrees of the vertices.
+ *
+ * @details
+ * The histogram is kept up to date as edges are added and vertices deleted,
+ * so this takes constant time. Bucket i counts the vertices with a degree from
+ * 2^(i - 1) to 2^i - 1, bucket 0 the ones without edges. The degrees of a
+ * directed graph are the numbers of edges going out of the vertices.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[out] buckets Array of GRAPH_DEGREE_BUCKETS counts.
+ */
+void graph_degree_histogram (graph_t *graph, unsigned long *buckets)
+{
+    pthread_rwlock_rdlock(&graph->lock);
+    memcpy(buckets, graph->degree_counts, sizeof(graph->degree_counts));
+    pthread_rwlock_unlock(&graph->lock);
+}
+
+/**
+ * @brief Return a vertex of the graph by its position in the registry.
+ *
+ * @details
+ * Positions go from 0 to the number of vertices - 1, so every vertex of the
+ * graph, connected or not, can be reached by a simple loop. Deleting a vertex
+ * moves the last vertex into its position.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] position Position of the vertex.
+ *
+ * @return The vertex, NULL if there is no such position.
+ */
+vertex_t *get_graph_vertex (graph_t *graph, unsigned int position)
+{
+    if (position >= graph->num_vertices) {
+        
+        return NULL;
+    }
+    
+    return graph->vertices[position];
+}
+
+/**
+ * @brief Return the opaque data stored at a vertex.
+ *
+ * @param[in] vertex The vertex.
+ *
+ * @return The vertex's data or NULL if the passed in vertex is NULL.
+ */
+void *get_data_from_vertex (vertex_t *vertex)
+{
+    if (vertex) {
+        return vertex->data;
+    } else {
+        return NULL;
+    }
+}
+
+/**
+ * @brief Return the adjacent vertices of a vertex as one array.
+ *
+ * @details
+ * The adjacent vertices are kept contiguous, so a loop over them needs no
+ * call per vertex. They come least recently linked first, the reverse of the
+ * order the searches and traversals take them in. In a directed graph they
+ * are the vertices the edges out of the vertex go to. The array stays valid
+ * until the graph is next changed.
+ *
+ * @param[in] vertex The vertex.
+ * @param[out] begin The adjacent vertices, NULL if there are none.
+ * @param[out] count Number of adjacent vertices.
+ *
+ * @return TRUE if successful, FALSE if the passed in vertex is NULL.
+ */
+boolean graph_neighbors (vertex_t *vertex, vertex_t *const **begin,
+                         unsigned int *count)
+{
+    if (vertex == NULL) {
+        
+        return FALSE;
+    }
+    *begin = vertex->adjacency.count ? vertex->adjacency.vertices : NULL;
+    *count = vertex->adjacency.count;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Return the weights of the edges to the adjacent vertices of a vertex.
+ *
+ * @details
+ * The weights line up with the vertices graph_neighbors returns, and stay
+ * valid as long as they do.
+ *
+ * @param[in] vertex The vertex.
+ *
+ * @return The weights, NULL if the vertex is NULL or has no adjacent
+ *         vertices.
+ */
+const float *graph_neighbor_weights (vertex_t *vertex)
+{
+    if (vertex == NULL || vertex->adjacency.count == 0) {
+        
+        return NULL;
+    }
+    
+    return vertex->adjacency.weights;
+}
+
+/**
+ * @brief Return the vertices with an edge into a vertex as one array.
+ *
+ * @details
+ * In an undirected graph these are the adjacent vertices, as graph_neighbors
+ * returns them. In a directed graph only GRAPH_DIRECTED_IN_EDGES keeps them.
+ * They come least recently linked first and stay valid until the graph is
+ * next changed.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] vertex The vertex.
+ * @param[out] begin The vertices, NULL if there are none.
+ * @param[out] count Number of vertices.
+ *
+ * @return TRUE if successful, FALSE if the passed in vertex is NULL or the
+ *         graph doesn't keep the edges into its vertices.
+ */
+boolean graph_in_neighbors (graph_t *graph, vertex_t *vertex,
+                            vertex_t *const **begin, unsigned int *count)
+{
+    if (graph->mode == GRAPH_UNDIRECTED) {
+        
+        return graph_neighbors(vertex, begin, count);
+    }
+    if (vertex == NULL || graph->mode != GRAPH_DIRECTED_IN_EDGES) {
+        
+        return FALSE;
+    }
+    *begin = vertex->in_adjacency->count ? vertex->in_adjacency->vertices : NULL;
+    *count = vertex->in_adjacency->count;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Mark a vertex the walk starts from as visited.
+ *
+ * @param[in, out] ctx The traversal context.
+ * @param[in] vertex The vertex.
+ */
+static void mark_walk_root (traversal_ctx_t *ctx, vertex_t *vertex)
+{
+    context_mark_visited(ctx, vertex->id);
+    ctx->depths[vertex->id] = 0;
+    ctx->parents[vertex->id] = NULL;
+}
+
+/**
+ * @brief Walk the graph starting from a vertex, calling the visitor on every
+ *        vertex reached. The caller must hold the graph's lock.
+ *
+ * @details
+ * This is the one loop behind all the searches and traversals. A vertex is
+ * marked as visited, along with its depth and parent, when it joins the
+ * frontier and handed to the visitor when it leaves it. The frontier is the
+ * context's queue for a breadth first walk and its stack for a depth first
+ * one, so neither allocates once the context has grown to fit the graph.
+ *
+ * A walk over the whole graph starts again, once the frontier runs out, from
+ * the first vertex in the registry not visited yet, which the visitor is
+ * handed with a depth of 0 and no parent.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ * @param[in] start Vertex to start from, NULL if the graph is empty.
+ * @param[in] depth_first TRUE to walk depth first, FALSE for breadth first.
+ * @param[in] whole_graph TRUE to go on until every vertex is visited, FALSE to
+ *                        stop at the vertices reachable from the start.
+ * @param[in] visitor Function called on every vertex reached.
+ * @param[in] arg Opaque argument passed to the visitor.
+ *
+ * @return The vertex at which the visitor stopped the walk, NULL if it
+ *         didn't.
+ */
+static vertex_t *walk_graph (graph_t *graph, traversal_ctx_t *ctx,
+                             vertex_t *start, boolean depth_first,
+                             boolean whole_graph, vertex_visitor_t visitor,
+                             void *arg)
+{
+    vertex_t *vertex, *adj_vertex;
+    unsigned int depth, next_root = 0;
+    visit_t action;
+    GRAPH_STATS_COUNTER(vertices_visited);
+    GRAPH_STATS_COUNTER(edges_visited);
+    
+    if (!begin_context_traversal(ctx, graph->num_vertices)) {
+        
+        return NULL;
+    }
+    vertex = start;
+    if (vertex) {
+        mark_walk_root(ctx, vertex);
+    }
+    
+    while (vertex) {
+        depth = ctx->depths[vertex->id];
+        action = visitor(vertex, ctx->parents[vertex->id], depth, arg);
+        GRAPH_STATS_COUNT(vertices_visited, 1);
+        if (action == VISIT_STOP) {
+            break;
+        }
+        
+        /*
+         * Add non visited adjacent vertices of this vertex to the frontier,
+         * unless the visitor wants to skip what lies beyond it.
+         */
+        if (action == VISIT_CONTINUE) {
+            GRAPH_STATS_COUNT(edges_visited, get_adjacent_count(vertex));
+            for (unsigned int i = 0; i < get_adjacent_count(vertex); i++) {
+                adj_vertex = get_adjacent_vertex(vertex, i);
+                if (!context_is_visited(ctx, adj_vertex->id)) {
+                    context_mark_visited(ctx, adj_vertex->id);
+                    ctx->depths[adj_vertex->id] = depth + 1;
+                    ctx->parents[adj_vertex->id] = vertex;
+                    if (depth_first) {
+                        push_to_stack(ctx->stack, adj_vertex);
+                    } else {
+                        push_to_queue(ctx->queue, adj_vertex);
+                    }
+                }
+            }
+        }
+        if (depth_first) {
+            vertex = pop_from_stack(ctx->stack);
+        } else {
+            vertex = pop_from_queue(ctx->queue);
+        }
+        if (vertex == NULL && whole_graph) {
+            while (next_root < graph->num_vertices &&
+                   context_is_visited(ctx, next_root)) {
+                next_root++;
+            }
+            if (next_root < graph->num_vertices) {
+                vertex = graph->vertices[next_root];
+                mark_walk_root(ctx, vertex);
+            }
+        }
+    }
+    GRAPH_STATS_ADD(graph, walks, 1);
+    GRAPH_STATS_ADD(graph, vertices_visited, vertices_visited);
+    GRAPH_STATS_ADD(graph, edges_visited, edges_visited);
+    GRAPH_STATS_RAISE(graph, queue_high_water, get_queue_high_water(ctx->queue));
+    GRAPH_STATS_RAISE(graph, stack_high_water, get_stack_high_water(ctx->stack));
+    
+    return vertex;
+}
+
+/**
+ * @brief What a search is looking for.
+ */
+typedef struct search_s {
+    graph_t *graph; /**< The graph being searched. */
+    void *data; /**< Opaque data for which we need to search. */
+    vertex_t *target; /**< The vertex containing the data, found in the
+                           index before the walk, NULL if not indexed. */
+} search_t;
+
+/**
+ * @brief Visitor that stops the walk at the vertex containing the data.
+ *
+ * @param[in] vertex The vertex reached.
+ * @param[in] parent The vertex it was reached from.
+ * @param[in] depth Number of edges between the start and the vertex.
+ * @param[in] arg The search.
+ *
+ * @return VISIT_STOP if the vertex contains the data, VISIT_CONTINUE otherwise.
+ */
+static visit_t match_data (vertex_t *vertex, vertex_t *parent,
+                           unsigned int depth, void *arg)
+{
+    search_t *search = (search_t *) arg;
+    
+    if (search->graph->data_is_equal(search->data, vertex->data)) {
+        
+        return VISIT_STOP;
+    }
+    
+    return VISIT_CONTINUE;
+}
+
+/**
+ * @brief Visitor that stops the walk at the vertex the index found the data
+ *        in, without comparing any data.
+ *
+ * @param[in] vertex The vertex reached.
+ * @param[in] parent The vertex it was reached from.
+ * @param[in] depth Number of edges between the start and the vertex.
+ * @param[in] arg The search.
+ *
+ * @return VISIT_STOP if the vertex is the target, VISIT_CONTINUE otherwise.
+ */
+static visit_t match_target (vertex_t *vertex, vertex_t *parent,
+                             unsigned int depth, void *arg)
+{
+    return vertex == ((search_t *) arg)->target ? VISIT_STOP : VISIT_CONTINUE;
+}
+
+/**
+ * @brief Tell whether the searches and traversals walk the whole graph or
+ *        only what the graph's vertex reaches.
+ *
+ * @details
+ * Little, if anything, can be reached from the graph's vertex of a directed
+ * graph, so its searches and traversals go on from the vertices not reached
+ * yet. Those of an undirected graph stay in the component of its vertex.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ *
+ * @return TRUE for a directed graph, FALSE otherwise.
+ */
+static boolean walks_whole_graph (graph_t *graph)
+{
+    return graph->mode != GRAPH_UNDIRECTED;
+}
+
+/**
+ * @brief Search the graph for the vertex containing the data, the caller must
+ *        hold the graph's lock.
+ *
+ * @details
+ * An indexed graph finds the vertex in the index and only walks to tell
+ * whether it can be reached, so the data is compared once instead of at every
+ * vertex, and not at all if it isn't in the graph.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ * @param[in] depth_first TRUE to search depth first, FALSE for breadth first.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+static vertex_t *search_graph (graph_t *graph, traversal_ctx_t *ctx,
+                               boolean depth_first, void *data)
+{
+    search_t search = { graph, data, NULL };
+    
+    if (graph->index == NULL) {
+        
+        return walk_graph(graph, ctx, graph->vertex, depth_first,
+                          walks_whole_graph(graph), match_data, &search);
+    }
+    search.target = lookup_in_hash_table(graph->index, data);
+    if (search.target == NULL) {
+        
+        return NULL;
+    }
+    
+    return walk_graph(graph, ctx, graph->vertex, depth_first,
+                      walks_whole_graph(graph), match_target, &search);
+}
+
+/**
+ * @brief Visitor that prints the data of every vertex.
+ *
+ * @param[in] vertex The vertex reached.
+ * @param[in] parent The vertex it was reached from.
+ * @param[in] depth Number of edges between the start and the vertex.
+ * @param[in] arg The graph.
+ *
+ * @return VISIT_CONTINUE.
+ */
+static visit_t print_vertex (vertex_t *vertex, vertex_t *parent,
+                             unsigned int depth, void *arg)
+{
+    ((graph_t *) arg)->print_data(vertex->data);
+    
+    return VISIT_CONTINUE;
+}
+
+/**
+ * @brief Breadth first search using the given context, the caller must hold
+ *        the graph's lock.
+ *
+ * @see breadth_first_search
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+static vertex_t *search_breadth_first (graph_t *graph, traversal_ctx_t *ctx,
+                                       void *data)
+{
+    return search_graph(graph, ctx, FALSE, data);
+}
+
+/**
+ * @brief Find the vertex containing the given data, the caller must hold the
+ *        graph's lock.
+ *
+ * @details
+ * Without an index this scans the registry, which also finds the vertices
+ * that aren't connected to the graph's vertex. That matters when adding
+ * vertices without any adjacent vertices, as the batch APIs do.
+ *
+ * @see find_in_graph
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+static vertex_t *find_vertex (graph_t *graph, void *data)
+{
+    GRAPH_STATS_ADD(graph, lookups, 1);
+    if (graph->index != NULL) {
+        
+        return lookup_in_hash_table(graph->index, data);
+    }
+    for (unsigned int i = 0; i < graph->num_vertices; i++) {
+        if (graph->data_is_equal(data, graph->vertices[i]->data)) {
+            GRAPH_STATS_ADD(graph, lookup_comparisons, i + 1);
+            
+            return graph->vertices[i];
+        }
+    }
+    GRAPH_STATS_ADD(graph, lookup_comparisons, graph->num_vertices);
+    
+    return NULL;
+}
+
+/**
+ * @brief Find the vertex containing the given data in the graph.
+ *
+ * @details
+ * This uses the index if the graph has one and falls back to a scan of the
+ * registry otherwise, so vertices that can't be reached from the graph's
+ * vertex are found too.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+vertex_t *find_in_graph (graph_t *graph, void *data)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    vertex = find_vertex(graph, data);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_FIND, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Add a vertex to the graph.
+ *
+ * @details.
+ * Adding a new vertex involves finding all the adjacent vertices using the adjacent
+ * vertices data provided and settign up the assosciation.
+ *
+ * In a directed graph the edges go from the new vertex to the adjacent
+ * vertices.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] data Information the new vertex will store.
+ * @param[in] adj_vertex_data An array of opaque data identifying the adjacent vertices
+ *                            to this new vertex.
+ * @param[in] num_of_adj_vertices The number of adjacent vertices this new
+ *                                vertex has.
+ *
+ * @return TRUE if vertex is successfully added, FALSE otherwise.
+ */
+boolean add_vertex_to_graph (graph_t *graph, void *data, void **adj_vertex_data,
+                             unsigned int num_of_adj_vertices)
+{
+    return add_weighted_vertex_to_graph(graph, data, adj_vertex_data, NULL,
+                                        num_of_adj_vertices);
+}
+
+/**
+ * @brief Is this a weight an edge can have?
+ *
+ * @param[in] weight The weight.
+ *
+ * @return TRUE if the weight is neither negative nor NaN, FALSE otherwise.
+ */
+static boolean weight_is_valid (float weight)
+{
+    return weight >= 0;
+}
+
+/**
+ * @brief Add a vertex to the graph along with the weights of its edges.
+ *
+ * @see add_vertex_to_graph
+ *
+ * @details
+ * The shortest path searches need the weights to not be negative.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] data Information the new vertex will store.
+ * @param[in] adj_vertex_data An array of opaque data identifying the adjacent vertices
+ *                            to this new vertex.
+ * @param[in] weights An array of the weights of the edges to the adjacent
+ *                    vertices, NULL to give all of them a weight of 1.
+ * @param[in] num_of_adj_vertices The number of adjacent vertices this new
+ *                                vertex has.
+ *
+ * @return TRUE if vertex is successfully added, FALSE otherwise.
+ */
+boolean add_weighted_vertex_to_graph (graph_t *graph, void *data,
+                                      void **adj_vertex_data, float *weights,
+                                      unsigned int num_of_adj_vertices)
+{
+    vertex_t *vertex = NULL, *lookup_vertex;
+    vertex_t **adjacent_vertices = NULL;
+    unsigned int num_linked = 0;
+    GRAPH_STATS_TIMER(timer);
+    
+    for (unsigned int i = 0; weights && i < num_of_adj_vertices; i++) {
+        if (!weight_is_valid(weights[i])) {
+            
+            return FALSE;
+        }
+    }
+    adjacent_vertices = (vertex_t **) malloc (sizeof(vertex_t *) * num_of_adj_vertices);
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_wrlock(&graph->lock);
+    
+    /*
+     * Let us make sure, this data doesn't exist in the graph already.
+     */
+    lookup_vertex = find_vertex(graph, data);
+    if (lookup_vertex != NULL) {
+        goto fail;
+    }
+    
+    /*
+     * Find all the adjacent vertices using the data provided.
+     */
+    for (int i = 0; i < num_of_adj_vertices; i++) {
+        lookup_vertex = find_vertex(graph, adj_vertex_data[i]);
+        if (lookup_vertex == NULL) {
+            goto fail;
+        }
+        adjacent_vertices[i] = lookup_vertex;
+    }
+    
+    vertex = (vertex_t *) allocate_memory (get_allocator(graph), vertex_size(graph));
+    if (vertex == NULL) {
+        goto fail;
+    }
+    memset(vertex, 0, vertex_size(graph));
+    vertex->data = data;
+    if (!add_to_registry(graph, vertex)) {
+        goto fail;
+    }
+    if (graph->index != NULL && !insert_to_hash_table(graph->index, data, vertex)) {
+        goto unregister;
+    }
+    
+    if (!reserve_adjacency(vertex, num_of_adj_vertices, get_allocator(graph))) {
+        goto unindex;
+    }
+    for (int i = 0; i < num_of_adj_vertices; i++) {
+        if (!link_edge(graph, vertex, adjacent_vertices[i], weights ? weights[i] : 1)) {
+            goto unlink;
+        }
+    }
+    if (graph->vertex == NULL) {
+        graph->vertex = vertex;
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_ADD_VERTEX, timer);
+    if (adjacent_vertices) {
+        free(adjacent_vertices);
+    }
+    
+    return TRUE;
+
+unlink:
+    
+    /*
+     * Nothing has an edge into the new vertex of a directed graph yet.
+     */
+    num_linked = get_adjacent_count(vertex);
+    unlink_out_edges(graph, vertex);
+unindex:
+    if (graph->index != NULL) {
+        delete_from_hash_table(graph->index, data);
+    }
+unregister:
+    remove_from_registry(graph, vertex);
+    split_components(graph, num_linked);
+fail:
+    if (vertex) {
+        free_vertex(graph, vertex);
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_ADD_VERTEX, timer);
+    if (adjacent_vertices) {
+        free(adjacent_vertices);
+    }
+    
+    return FALSE;
+}
+
+/**
+ * @brief Breadth first traversal using the given context, the caller must
+ *        hold the graph's lock.
+ *
+ * @see breadth_first_traversal
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ */
+static void traverse_breadth_first (graph_t *graph, traversal_ctx_t *ctx)
+{
+    walk_graph(graph, ctx, graph->vertex, FALSE, walks_whole_graph(graph),
+               print_vertex, graph);
+}
+
+/**
+ * @brief Depth first search using the given context, the caller must hold
+ *        the graph's lock.
+ *
+ * @see depth_first_search
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+static vertex_t *search_depth_first (graph_t *graph, traversal_ctx_t *ctx,
+                                     void *data)
+{
+    return search_graph(graph, ctx, TRUE, data);
+}
+
+/**
+ * @brief Depth first traversal using the given context, the caller must hold
+ *        the graph's lock.
+ *
+ * @see depth_first_traversal
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ */
+static void traverse_depth_first (graph_t *graph, traversal_ctx_t *ctx)
+{
+    walk_graph(graph, ctx, graph->vertex, TRUE, walks_whole_graph(graph),
+               print_vertex, graph);
+}
+
+/**
+ * @brief Traverse the graph data structure in a breadth first fashion.
+ *
+ * @details
+ * We traverse the graph starting from a node. This kind of traversal mandates
+ * that we visit all adjacent vertices of a node before visiting any adjacent
+ * vertices of the adjacent vertices. We carefully avoid re-visting already
+ * visited nodes. We do so by pushing not yet visited adjacent vertices of the
+ * node to a queue. We pop an element from the queue and repeat this process.
+ * In a directed graph, when the queue runs out, we start again from a vertex
+ * not visited yet, until every vertex has been visited.
+ *
+ * @note
+ * The visited marks left behind are made stale by the next traversal moving
+ * the context to a new epoch, so there's no need to unmark the vertices.
+ * This uses the graph's own context, use breadth_first_traversal_with_context
+ * to traverse the graph from many threads at once.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ */
+void breadth_first_traversal (graph_t *graph)
+{
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    traverse_breadth_first(graph, graph->ctx);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+}
+
+/**
+ * @brief Traverse the graph data structure in a breadth first fashion using
+ *        the caller's traversal context.
+ *
+ * @see breadth_first_traversal
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ */
+void breadth_first_traversal_with_context (graph_t *graph, traversal_ctx_t *ctx)
+{
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    traverse_breadth_first(graph, ctx);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+}
+
+/**
+ * @brief Find a node with the given data in the graph traversing in a breadth
+ *        first fashion.
+ *
+ * @see breadth_first_traversal
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+vertex_t *breadth_first_search (graph_t *graph, void *data)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    vertex = search_breadth_first(graph, graph->ctx, data);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_SEARCH, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Find a node with the given data in the graph traversing in a breadth
+ *        first fashion using the caller's traversal context.
+ *
+ * @see breadth_first_search
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+vertex_t *breadth_first_search_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                             void *data)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    vertex = search_breadth_first(graph, ctx, data);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_SEARCH, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Traverse the graph data structure in a depth first fashion.
+ *
+ * @details
+ * We traverse the graph starting from a node. This kind of traversal mandates
+ * that we visit adjacent vertices of a node's immediate adjacent vertices before
+ * visiting the adjacent vertices of a node. We carefully avoid re-visiting
+ * already visited vertices. We do so by pushing not yet visited adjacent
+ * vertices of the node to a stack. We pop an element from the stack and repeat
+ * this process. In a directed graph, when the stack runs out, we start again
+ * from a vertex not visited yet, until every vertex has been visited.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ */
+void depth_first_traversal (graph_t *graph)
+{
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    traverse_depth_first(graph, graph->ctx);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+}
+
+/**
+ * @brief Traverse the graph data structure in a depth first fashion using the
+ *        caller's traversal context.
+ *
+ * @see depth_first_traversal
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ */
+void depth_first_traversal_with_context (graph_t *graph, traversal_ctx_t *ctx)
+{
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    traverse_depth_first(graph, ctx);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+}
+
+/**
+ * @brief Find a node with the given data in the graph traversing in a depth
+ *        first fashion.
+ *
+ * @see depth_first_traversal
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+vertex_t *depth_first_search (graph_t *graph, void *data)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    vertex = search_depth_first(graph, graph->ctx, data);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_SEARCH, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Find a node with the given data in the graph traversing in a depth
+ *        first fashion using the caller's traversal context.
+ *
+ * @see depth_first_search
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] data Opaque data for which we need to search.
+ *
+ * @return Pointer to vertex containing the opaque data in the graph if one exists,
+ *         NULL otherwise.
+ */
+vertex_t *depth_first_search_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                           void *data)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    vertex = search_depth_first(graph, ctx, data);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_SEARCH, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Walk the graph in a breadth first fashion, calling the visitor on
+ *        every vertex reached.
+ *
+ * @details
+ * The visitor is told the vertex, the vertex it was reached from (NULL for
+ * the start) and its depth, the number of edges between it and the start.
+ * It returns VISIT_CONTINUE to carry on, VISIT_SKIP to not go beyond this
+ * vertex or VISIT_STOP to end the walk. The graph is locked for reading
+ * while we walk it, so the visitor must not change the graph.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] start Vertex to start from, NULL to start from the graph's
+ *                  vertex.
+ * @param[in] visitor Function called on every vertex reached.
+ * @param[in] arg Opaque argument passed to the visitor.
+ *
+ * @return The vertex at which the visitor stopped the walk, NULL if it
+ *         didn't.
+ */
+vertex_t *graph_bfs_visit (graph_t *graph, vertex_t *start,
+                           vertex_visitor_t visitor, void *arg)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    vertex = walk_graph(graph, graph->ctx, start ? start : graph->vertex,
+                        FALSE, FALSE, visitor, arg);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Walk the graph in a breadth first fashion using the caller's
+ *        traversal context.
+ *
+ * @see graph_bfs_visit
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] start Vertex to start from, NULL to start from the graph's
+ *                  vertex.
+ * @param[in] visitor Function called on every vertex reached.
+ * @param[in] arg Opaque argument passed to the visitor.
+ *
+ * @return The vertex at which the visitor stopped the walk, NULL if it
+ *         didn't.
+ */
+vertex_t *graph_bfs_visit_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                        vertex_t *start, vertex_visitor_t visitor,
+                                        void *arg)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    vertex = walk_graph(graph, ctx, start ? start : graph->vertex, FALSE,
+                        FALSE, visitor, arg);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Walk the graph in a depth first fashion, calling the visitor on
+ *        every vertex reached.
+ *
+ * @see graph_bfs_visit
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] start Vertex to start from, NULL to start from the graph's
+ *                  vertex.
+ * @param[in] visitor Function called on every vertex reached.
+ * @param[in] arg Opaque argument passed to the visitor.
+ *
+ * @return The vertex at which the visitor stopped the walk, NULL if it
+ *         didn't.
+ */
+vertex_t *graph_dfs_visit (graph_t *graph, vertex_t *start,
+                           vertex_visitor_t visitor, void *arg)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&graph->ctx_lock);
+    vertex = walk_graph(graph, graph->ctx, start ? start : graph->vertex,
+                        TRUE, FALSE, visitor, arg);
+    pthread_mutex_unlock(&graph->ctx_lock);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Walk the graph in a depth first fashion using the caller's
+ *        traversal context.
+ *
+ * @see graph_bfs_visit
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] start Vertex to start from, NULL to start from the graph's
+ *                  vertex.
+ * @param[in] visitor Function called on every vertex reached.
+ * @param[in] arg Opaque argument passed to the visitor.
+ *
+ * @return The vertex at which the visitor stopped the walk, NULL if it
+ *         didn't.
+ */
+vertex_t *graph_dfs_visit_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                        vertex_t *start, vertex_visitor_t visitor,
+                                        void *arg)
+{
+    vertex_t *vertex;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    vertex = walk_graph(graph, ctx, start ? start : graph->vertex, TRUE,
+                        FALSE, visitor, arg);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_TRAVERSAL, timer);
+    
+    return vertex;
+}
+
+/**
+ * @brief Delete a passed in vertex from the graph.
+ *
+ * @param[in,out] graph Pointer to the graph data structure.
+ * @param[in] vertex Vertex we need to delete.
+ *
+ * @return TRUE if successfully deleted the specified vertex, FALSE otherwise.
+ */
+static boolean delete_vertex_from_graph (graph_t *graph, vertex_t *vertex)
+{
+    unsigned long num_edges;
+    
+    if (vertex == NULL) {
+        
+        return FALSE;
+    }
+    
+    num_edges = graph->num_edges;
+    remove_from_registry(graph, vertex);
+    
+    /*
+     * Don't leave the graph pointing to a vertex we're about to free. An
+     * adjacent vertex keeps the traversals in the same part of the graph.
+     */
+    if (graph->vertex == vertex) {
+        if (get_adjacent_count(vertex) > 0) {
+            graph->vertex = get_adjacent_vertex(vertex, 0);
+        } else {
+            graph->vertex = get_graph_vertex(graph, 0);
+        }
+    }
+    
+    unlink_out_edges(graph, vertex);
+    unlink_in_edges(graph, vertex);
+    split_components(graph, num_edges - graph->num_edges);
+    if (graph->index != NULL) {
+        delete_from_hash_table(graph->index, vertex->data);
+    }
+    
+    free_vertex(graph, vertex);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Delete a vertex - containing the specified data- from the graph.
+ *
+ * @details
+ * Deleting a vertex involves deleting this vertex from the adjacency of
+ * all the vertices that are adjacent.
+ *
+ * @param[in,out] graph Pointer to the graph data structure.
+ * @param[in] data Information the vertex we need to delete contains.
+ *
+ * @return TRUE if found and deleted a vertex containing the specifed data,
+ * False otherwise.
+ */
+boolean delete_from_graph (graph_t *graph, void *data)
+{
+    vertex_t *vertex;
+    boolean deleted;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_wrlock(&graph->lock);
+    vertex = find_vertex(graph, data);
+    deleted = delete_vertex_from_graph(graph, vertex);
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_DELETE, timer);
+    
+    return deleted;
+}
+
+/**
+ * @brief Delete all the vertices that can't be reached from the graph's
+ *        vertex, ignoring the direction of the edges.
+ *
+ * @details
+ * These are the vertices left behind when every path between them and the
+ * graph's vertex is deleted, the ones outside its connected component. In a
+ * directed graph that is its weakly connected component, so the vertices
+ * whose edges only lead into it are kept. The vertices in the component are
+ * marked in the graph's context before anything is deleted, and the registry
+ * has all the others. Going through the registry from its end means the
+ * vertex moved into a deleted vertex's place has already been looked at.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ *
+ * @return Number of vertices deleted.
+ */
+unsigned int delete_unreachable_from_graph (graph_t *graph)
+{
+    vertex_t *vertex;
+    unsigned int root, deleted = 0;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_wrlock(&graph->lock);
+    if (graph->vertex == NULL ||
+        !begin_context_traversal(graph->ctx, graph->num_vertices)) {
+        goto done;
+    }
+    root = get_component_root(graph, graph->vertex);
+    for (unsigned int i = 0; i < graph->num_vertices; i++) {
+        if (get_component_root(graph, graph->vertices[i]) == root) {
+            context_mark_visited(graph->ctx, i);
+        }
+    }
+    for (unsigned int i = graph->num_vertices; i > 0; i--) {
+        vertex = graph->vertices[i - 1];
+        if (!context_is_visited(graph->ctx, i - 1)) {
+            delete_vertex_from_graph(graph, vertex);
+            deleted++;
+        }
+    }
+
+done:
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_DELETE, timer);
+    
+    return deleted;
+}
+
+/**
+ * @brief Add many vertices without any adjacent vertices to the graph.
+ *
+ * @details
+ * The lock is taken once and the registry and index are sized for the whole
+ * batch upfront, so none of them grows while we add the vertices. Either all
+ * the vertices are added or none of them is. Use add_edges_batch to connect
+ * them afterwards. Without an index, checking for duplicates scans the graph
+ * for every vertex, so bulk loads should use an indexed graph.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] data Array of the information each new vertex will store.
+ * @param[in] num_of_vertices Number of vertices in the array.
+ *
+ * @return TRUE if all the vertices are added, FALSE if any of the data is
+ *         already in the graph or repeated in the batch, or memory allocation
+ *         failed.
+ */
+boolean add_vertices_batch (graph_t *graph, void **data,
+                            unsigned int num_of_vertices)
+{
+    vertex_t *vertex;
+    unsigned int added;
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_wrlock(&graph->lock);
+    if (!reserve_registry(graph, num_of_vertices) ||
+        (graph->index != NULL && !reserve_hash_table(graph->index, num_of_vertices))) {
+        goto fail;
+    }
+    
+    for (added = 0; added < num_of_vertices; added++) {
+        if (graph->index == NULL && find_vertex(graph, data[added]) != NULL) {
+            goto rollback;
+        }
+        vertex = (vertex_t *) allocate_memory (get_allocator(graph), vertex_size(graph));
+        if (vertex == NULL) {
+            goto rollback;
+        }
+        memset(vertex, 0, vertex_size(graph));
+        vertex->data = data[added];
+        vertex->id = graph->num_vertices;
+        graph->vertices[graph->num_vertices++] = vertex;
+        graph->degree_counts[0]++;
+        add_component(graph, vertex);
+        if (graph->index != NULL &&
+            !insert_to_hash_table(graph->index, data[added], vertex)) {
+            remove_from_registry(graph, vertex);
+            split_components(graph, 0);
+            free_vertex(graph, vertex);
+            goto rollback;
+        }
+    }
+    if (graph->vertex == NULL && graph->num_vertices > 0) {
+        graph->vertex = graph->vertices[0];
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_ADD_VERTICES_BATCH, timer);
+    
+    return TRUE;
+
+rollback:
+    
+    /*
+     * The vertices of this batch are the last ones in the registry.
+     */
+    for (; added > 0; added--) {
+        delete_vertex_from_graph(graph, graph->vertices[graph->num_vertices - 1]);
+    }
+fail:
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_ADD_VERTICES_BATCH, timer);
+    
+    return FALSE;
+}
+
+/**
+ * @brief Add many edges between the vertices of the graph.
+ *
+ * @details
+ * Every end of every edge is looked up first, then the adjacency of each
+ * vertex is grown once to fit all its new edges, and only then are the edges
+ * linked. Either all the edges are added or none of them is. In a directed
+ * graph each edge goes from its first end to its second. With an index, the
+ * time this takes depends on the size of the batch and not of the graph, so
+ * a graph can be fed in many small batches.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] from_data Array of the data of one end of each edge.
+ * @param[in] to_data Array of the data of the other end of each edge.
+ * @param[in] num_of_edges Number of edges in the arrays.
+ *
+ * @return TRUE if all the edges are added, FALSE if any end isn't in the
+ *         graph, an edge connects a vertex to itself, or memory allocation
+ *         failed.
+ */
+boolean add_edges_batch (graph_t *graph, void **from_data, void **to_data,
+                         unsigned int num_of_edges)
+{
+    return add_weighted_edges_batch(graph, from_data, to_data, NULL, num_of_edges);
+}
+
+/**
+ * @brief Make room for the new edges of the vertices at one end of a batch of
+ *        edges, the caller must hold the graph's lock for writing.
+ *
+ * @details
+ * The graph's context counts the new edges of each vertex in its depths, a
+ * vertex's count starting when it's first marked, so the batch doesn't need
+ * an array as big as the registry. Once a vertex has its room, its count goes
+ * back to 0 so the next of its edges doesn't reserve it again.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] ends The ends of the edges, two for each edge.
+ * @param[in] first Position of the first end to make room at.
+ * @param[in] step Distance between the ends to make room at.
+ * @param[in] num_ends Number of ends to make room at.
+ * @param[in] in_edges TRUE to make room in the in adjacency.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean reserve_batch_ends (graph_t *graph, vertex_t **ends,
+                                   unsigned int first, unsigned int step,
+                                   unsigned int num_ends, boolean in_edges)
+{
+    traversal_ctx_t *ctx = graph->ctx;
+    vertex_t *vertex;
+    boolean reserved;
+    
+    if (!begin_context_traversal(ctx, graph->num_vertices)) {
+        
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < num_ends; i++) {
+        vertex = ends[first + i * step];
+        if (!context_is_visited(ctx, vertex->id)) {
+            context_mark_visited(ctx, vertex->id);
+            ctx->depths[vertex->id] = 0;
+        }
+        ctx->depths[vertex->id]++;
+    }
+    for (unsigned int i = 0; i < num_ends; i++) {
+        vertex = ends[first + i * step];
+        if (ctx->depths[vertex->id] == 0) {
+            continue;
+        }
+        if (in_edges) {
+            reserved = reserve_in_adjacency(vertex, ctx->depths[vertex->id],
+                                            get_allocator(graph));
+        } else {
+            reserved = reserve_adjacency(vertex, ctx->depths[vertex->id],
+                                         get_allocator(graph));
+        }
+        if (!reserved) {
+            
+            return FALSE;
+        }
+        ctx->depths[vertex->id] = 0;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Add many edges between the vertices of the graph along with their
+ *        weights.
+ *
+ * @see add_edges_batch
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] from_data Array of the data of one end of each edge.
+ * @param[in] to_data Array of the data of the other end of each edge.
+ * @param[in] weights Array of the weight of each edge, NULL to give all of
+ *                    them a weight of 1.
+ * @param[in] num_of_edges Number of edges in the arrays.
+ *
+ * @return TRUE if all the edges are added, FALSE if any end isn't in the
+ *         graph, an edge connects a vertex to itself, a weight is negative,
+ *         or memory allocation failed.
+ */
+boolean add_weighted_edges_batch (graph_t *graph, void **from_data,
+                                  void **to_data, float *weights,
+                                  unsigned int num_of_edges)
+{
+    vertex_t **ends = NULL;
+    boolean added = FALSE;
+    GRAPH_STATS_TIMER(timer);
+    
+    for (unsigned int i = 0; weights && i < num_of_edges; i++) {
+        if (!weight_is_valid(weights[i])) {
+            
+            return FALSE;
+        }
+    }
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_wrlock(&graph->lock);
+    ends = (vertex_t **) malloc (sizeof(vertex_t *) * (2 * num_of_edges + 1));
+    if (ends == NULL) {
+        goto done;
+    }
+    
+    /*
+     * Resolve every end. Feeds tend to list the edges of a vertex together,
+     * so a run of edges from the same data only looks it up once.
+     */
+    for (unsigned int i = 0; i < num_of_edges; i++) {
+        if (i > 0 && from_data[i] == from_data[i - 1]) {
+            ends[2 * i] = ends[2 * (i - 1)];
+        } else {
+            ends[2 * i] = find_vertex(graph, from_data[i]);
+        }
+        ends[2 * i + 1] = find_vertex(graph, to_data[i]);
+        if (ends[2 * i] == NULL || ends[2 * i + 1] == NULL ||
+            ends[2 * i] == ends[2 * i + 1]) {
+            goto done;
+        }
+    }
+    
+    /*
+     * Both ends of an undirected edge keep it in their adjacency, the first
+     * end of a directed edge keeps it in its adjacency and the second end in
+     * its in adjacency, if any.
+     */
+    if (graph->mode == GRAPH_UNDIRECTED) {
+        if (!reserve_batch_ends(graph, ends, 0, 1, 2 * num_of_edges, FALSE)) {
+            goto done;
+        }
+    } else {
+        if (!reserve_batch_ends(graph, ends, 0, 2, num_of_edges, FALSE) ||
+            (graph->mode == GRAPH_DIRECTED_IN_EDGES &&
+             !reserve_batch_ends(graph, ends, 1, 2, num_of_edges, TRUE))) {
+            goto done;
+        }
+    }
     
     /*
-     * Delete all the vertices in the graph.
+     * With the room made, linking can't fail.
      */
-    vertex = pop_from_stack(stack_with_all_vertices);
-    for (; vertex; vertex = pop_from_stack(stack_with_all_vertices)) {
-        delete_vertex_from_graph(graph, vertex);
+    for (unsigned int i = 0; i < num_of_edges; i++) {
+        link_edge(graph, ends[2 * i], ends[2 * i + 1], weights ? weights[i] : 1);
+    }
+    added = TRUE;
+
+done:
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_ADD_EDGES_BATCH, timer);
+    free(ends);
+    
+    return added;
+}
+
+/**
+ * @brief Remove all the vertices and edges from the graph, keeping it ready
+ *        for the next ones.
+ *
+ * @details
+ * This is the quick way of rebuilding a graph from scratch. Like
+ * destroy_graph, it neither walks the graph nor unlinks the edges. The
+ * graph's own slab pool forgets the vertices and adjacency arrays all at once
+ * but keeps its chunks, and the registry, the index and the connected
+ * components keep their room, so adding as many vertices again allocates
+ * next to nothing. With an allocator plugged in by the user, the vertices
+ * are freed one by one. The versions already published stay readable, and
+ * the data stored in the vertices is owned by the user and is not freed.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ */
+void graph_clear (graph_t *graph)
+{
+    GRAPH_STATS_TIMER(timer);
+    
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_wrlock(&graph->lock);
+    if (graph->owns_allocator) {
+        reset_slab_allocator(&graph->allocator);
+    } else {
+        for (unsigned int i = 0; i < graph->num_vertices; i++) {
+            free_vertex(graph, graph->vertices[i]);
+        }
+    }
+    graph->vertex = NULL;
+    graph->num_vertices = 0;
+    graph->num_edges = 0;
+    memset(graph->degree_counts, 0, sizeof(graph->degree_counts));
+    clear_hash_table(graph->index);
+    graph->num_components = 0;
+    graph->components_stale = FALSE;
+    graph->component_count_stale = FALSE;
+    if (graph->snapshots) {
+        graph->snapshots->all_dirty = TRUE;
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_DELETE, timer);
+}
+
+/**
+ * @brief Destory the graph, deleting all the vertexes and related assosciations
+ * in the process.
+ *
+ * @details
+ * If the allocator can release everything allocated from it at once, the
+ * vertices and the adjacency arrays go away with it. Otherwise we go through
+ * the registry freeing each vertex, which needs no traversal and reaches the
+ * vertices not connected to the rest of the graph as well. As all of them go,
+ * there's no need to unlink their edges first. No other thread may be using
+ * the graph.
+ *
+ * @param[in,out] graph Pointer to the graph.
+ */
+void destroy_graph (graph_t *graph)
+{
+    if (graph->allocator.release != NULL) {
+        graph->allocator.release(graph->allocator.pool);
+    } else {
+        for (unsigned int i = 0; i < graph->num_vertices; i++) {
+            free_vertex(graph, graph->vertices[i]);
+        }
+    }
+    if (graph->owns_allocator) {
+        destroy_slab_allocator(&graph->allocator);
     }
+    destroy_traversal_context(graph->ctx);
+    destroy_hash_table(graph->index);
+    destroy_components(graph);
+    destroy_snapshots(graph);
+    free(graph->vertices);
+    pthread_mutex_destroy(&graph->ctx_lock);
+    pthread_rwlock_destroy(&graph->lock);
     free(graph);
-    destroy_stack(stack_with_all_vertices);
 }
@@ -11,9 +11,114 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include <pthread.h>
+#include "public.h"
+#include "hash_table.h"
+#include "traversal.h"
+#include "allocator.h"
+
 typedef struct vertex_s vertex_t;
+typedef struct snapshot_state_s snapshot_state_t;
 typedef void (*print_data_t) (void *);
 typedef boolean (*data_is_equal_t) (void *, void *);
+typedef unsigned long (*data_hash_t) (void *);
+
+/**
+ * @brief What a visitor wants the walk to do after visiting a vertex.
+ */
+typedef enum visit_e {
+    VISIT_CONTINUE, /**< Carry on, including past this vertex. */
+    VISIT_SKIP, /**< Carry on, but not past this vertex. */
+    VISIT_STOP /**< End the walk at this vertex. */
+} visit_t;
+
+typedef visit_t (*vertex_visitor_t) (vertex_t *, vertex_t *, unsigned int, void *);
+
+/**
+ * @brief Whether the edges of a graph have a direction.
+ */
+typedef enum graph_mode_e {
+    GRAPH_UNDIRECTED, /**< Every edge goes both ways. */
+    GRAPH_DIRECTED, /**< Every edge goes one way, only the edges out of each
+                         vertex are kept. */
+    GRAPH_DIRECTED_IN_EDGES /**< Every edge goes one way, the edges into each
+                                 vertex are kept as well. */
+} graph_mode_t;
+
+/**
+ * @brief What the opaque data of the vertices is.
+ */
+typedef enum graph_key_e {
+    GRAPH_KEY_OPAQUE, /**< Anything, compared and hashed by the user's
+                           functions. */
+    GRAPH_KEY_INTEGER, /**< An integer cast to a pointer, equal to another
+                            only if it's the same integer. */
+    GRAPH_KEY_STRING /**< A NUL terminated string, equal to another with the
+                          same characters. The strings aren't copied or
+                          interned, the index stands in for an intern table:
+                          it hashes a string once to find its vertex, only
+                          comparing the characters of strings with the same
+                          hash, and the walks then compare vertices by
+                          pointer. */
+} graph_key_t;
+
+/**
+ * @brief Number of buckets in the degree histogram. Bucket 0 counts the
+ *        vertices without edges and bucket i the ones with a degree from
+ *        2^(i - 1) to 2^i - 1.
+ */
+#define GRAPH_DEGREE_BUCKETS 33
+
+/**
+ * @brief The API calls the stats are kept for.
+ */
+typedef enum graph_op_e {
+    GRAPH_OP_ADD_VERTEX, /**< add_vertex_to_graph and
+                              add_weighted_vertex_to_graph. */
+    GRAPH_OP_ADD_VERTICES_BATCH, /**< add_vertices_batch. */
+    GRAPH_OP_ADD_EDGES_BATCH, /**< add_edges_batch and
+                                   add_weighted_edges_batch. */
+    GRAPH_OP_DELETE, /**< delete_from_graph, delete_unreachable_from_graph
+                          and graph_clear. */
+    GRAPH_OP_FIND, /**< find_in_graph. */
+    GRAPH_OP_SEARCH, /**< The breadth and depth first searches. */
+    GRAPH_OP_TRAVERSAL, /**< The breadth and depth first traversals and
+                             visits. */
+    GRAPH_OP_PATH, /**< The shortest path and bidirectional searches. */
+    GRAPH_NUM_OPS /**< Number of API calls the stats are kept for. */
+} graph_op_t;
+
+/**
+ * @brief The stats of one kind of API call.
+ */
+typedef struct graph_op_stats_s {
+    unsigned long calls; /**< Number of calls. */
+    unsigned long long nanoseconds; /**< Time spent in them, waiting for the
+                                         graph's lock included. */
+    unsigned long allocations; /**< Number of allocations they made through
+                                    the graph's allocator. */
+    unsigned long long bytes; /**< Bytes those allocations asked for. */
+} graph_op_stats_t;
+
+/**
+ * @brief The stats a graph keeps when built with GRAPH_ENABLE_STATS.
+ */
+typedef struct graph_stats_s {
+    graph_op_stats_t ops[GRAPH_NUM_OPS]; /**< Stats of every kind of API
+                                              call. */
+    unsigned long walks; /**< Number of searches and traversals walked. */
+    unsigned long long vertices_visited; /**< Vertices they visited. */
+    unsigned long long edges_visited; /**< Edges they went through. */
+    unsigned long lookups; /**< Times the vertex of some data was looked up
+                                by find_in_graph or while changing the
+                                graph. */
+    unsigned long long lookup_comparisons; /**< Data compared by the lookups
+                                                done without an index. */
+    unsigned long queue_high_water; /**< Most vertices in the frontier of a
+                                         breadth first walk. */
+    unsigned long stack_high_water; /**< Most vertices in the frontier of a
+                                         depth first walk. */
+} graph_stats_t;
 
 /**
  * @brief The graph data structure.
@@ -24,15 +129,95 @@ typedef struct graph_s {
                                   opaque data in the vertices. */
     data_is_equal_t data_is_equal; /**< Function pointer to compare the user
                                         stored opaque data in the vertices. */
+    data_hash_t data_hash; /**< Function pointer to hash the user stored
+                                opaque data in the vertices, NULL if the
+                                graph isn't indexed. */
+    hash_table_t *index; /**< Index from the opaque data to its vertex, NULL
+                              if the graph isn't indexed. */
+    graph_key_t keys; /**< What the opaque data is. */
+    traversal_ctx_t *ctx; /**< Traversal context used by the searches and
+                               traversals that don't bring their own. */
+    pthread_mutex_t ctx_lock; /**< Serializes the users of ctx. */
+    pthread_rwlock_t lock; /**< Held for reading by searches and traversals,
+                                for writing by changes to the graph. */
+    vertex_t **vertices; /**< Registry of all the vertices, indexed by the
+                              vertex id. */
+    unsigned int num_vertices; /**< Number of vertices in the registry. */
+    unsigned int vertices_capacity; /**< Room in the registry. */
+    allocator_t allocator; /**< Allocator for the vertices and their
+                                adjacency arrays. */
+    boolean owns_allocator; /**< TRUE if allocator is the graph's own slab
+                                 allocator, FALSE if the user plugged it in. */
+    graph_mode_t mode; /**< Whether the edges have a direction. */
+    unsigned long num_edges; /**< Number of edges. */
+    unsigned long degree_counts[GRAPH_DEGREE_BUCKETS]; /**< Number of vertices
+                                                            with a degree in
+                                                            each bucket. */
+    unsigned int *component_parents; /**< Union-find forest of the connected
+                                          components, indexed by the vertex
+                                          id. */
+    unsigned char *component_ranks; /**< Rank of every tree root of the
+                                         forest. */
+    unsigned int components_capacity; /**< Number of vertex ids the forest has
+                                           room for. */
+    unsigned int num_components; /**< Number of connected components. */
+    boolean components_stale; /**< TRUE if a delete left the forest behind the
+                                   edges. */
+    boolean component_count_stale; /**< TRUE if a delete may have split a
+                                        component, leaving num_components
+                                        behind. */
+    snapshot_state_t *snapshots; /**< The published versions of the graph,
+                                      NULL till the first one is. */
+    graph_stats_t stats; /**< What the graph's API calls have done, left
+                              zeroed unless built with GRAPH_ENABLE_STATS
+                              so the layout doesn't depend on it. */
 } graph_t;
 
 graph_t *create_graph (print_data_t, data_is_equal_t);
+graph_t *create_graph_with_hash (print_data_t, data_is_equal_t, data_hash_t);
+graph_t *create_graph_with_mode (print_data_t, data_is_equal_t, data_hash_t,
+                                 graph_mode_t);
+graph_t *create_graph_with_keys (print_data_t, graph_key_t, graph_mode_t);
+boolean graph_set_allocator (graph_t *, allocator_t *);
 boolean add_vertex_to_graph (graph_t *, void *, void *[], unsigned int);
+boolean add_weighted_vertex_to_graph (graph_t *, void *, void *[], float *,
+                                      unsigned int);
+boolean add_vertices_batch (graph_t *, void *[], unsigned int);
+boolean add_edges_batch (graph_t *, void *[], void *[], unsigned int);
+boolean add_weighted_edges_batch (graph_t *, void *[], void *[], float *,
+                                  unsigned int);
 boolean delete_from_graph (graph_t *, void *);
+unsigned int delete_unreachable_from_graph (graph_t *);
 vertex_t *breadth_first_search (graph_t *, void *);
+vertex_t *breadth_first_search_with_context (graph_t *, traversal_ctx_t *, void *);
 vertex_t *depth_first_search (graph_t *, void *);
-void bread_first_traversal (graph_t *);
+vertex_t *depth_first_search_with_context (graph_t *, traversal_ctx_t *, void *);
+vertex_t *find_in_graph (graph_t *, void *);
+void breadth_first_traversal (graph_t *);
+void breadth_first_traversal_with_context (graph_t *, traversal_ctx_t *);
 void depth_first_traversal (graph_t *);
+void depth_first_traversal_with_context (graph_t *, traversal_ctx_t *);
+vertex_t *graph_bfs_visit (graph_t *, vertex_t *, vertex_visitor_t, void *);
+vertex_t *graph_bfs_visit_with_context (graph_t *, traversal_ctx_t *, vertex_t *,
+                                        vertex_visitor_t, void *);
+vertex_t *graph_dfs_visit (graph_t *, vertex_t *, vertex_visitor_t, void *);
+vertex_t *graph_dfs_visit_with_context (graph_t *, traversal_ctx_t *, vertex_t *,
+                                        vertex_visitor_t, void *);
+unsigned int get_graph_vertex_count (graph_t *);
+unsigned long get_graph_edge_count (graph_t *);
+unsigned int get_vertex_degree (vertex_t *);
+void graph_degree_histogram (graph_t *, unsigned long *);
+unsigned int get_graph_component_count (graph_t *);
+boolean vertices_are_connected (graph_t *, vertex_t *, vertex_t *);
+vertex_t *get_graph_vertex (graph_t *, unsigned int);
+void *get_data_from_vertex (vertex_t *);
+boolean graph_neighbors (vertex_t *, vertex_t *const **, unsigned int *);
+const float *graph_neighbor_weights (vertex_t *);
+boolean graph_in_neighbors (graph_t *, vertex_t *, vertex_t *const **,
+                            unsigned int *);
+boolean graph_get_stats (graph_t *, graph_stats_t *);
+void graph_reset_stats (graph_t *);
+void graph_clear (graph_t *);
 void destroy_graph (graph_t *);
 
 #endif /* GRAPH_H */
@@ -0,0 +1,70 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file graph_private.h
+ * @date 01/21/17
+ * @author Ashutosh Grewal
+ *
+ * @brief Private definition of structures shared by the graph and the
+ *        representations built from it. This separate header file is made as
+ *        we do not want these definitions made visible to the rest of the
+ *        system.
+ */
+#ifndef GRAPH_PRIVATE_H
+#define GRAPH_PRIVATE_H
+
+#include "public.h"
+
+/**
+ * @brief Number of adjacent vertices a vertex has room for without
+ *        allocating the arrays of its adjacency.
+ */
+#define ADJACENCY_INLINE_SLOTS 4
+
+/**
+ * @brief The adjacent vertices of a vertex.
+ *
+ * @details
+ * The arrays of a vertex's adjacency point at the vertex's inline slots up to
+ * ADJACENCY_INLINE_SLOTS adjacent vertices. Past that, and always for an in
+ * adjacency, they are carved out of one block, in the order they appear here.
+ */
+typedef struct adjacency_s {
+    struct vertex_s **vertices; /**< The adjacent vertices. */
+    float *weights; /**< Weight of the edge to each adjacent vertex. */
+    unsigned int *mirrors; /**< Slot of this vertex in the adjacency of each
+                                adjacent vertex. */
+    unsigned int count; /**< Number of adjacent vertices. */
+    unsigned int capacity; /**< Room in the arrays. */
+} adjacency_t;
+
+/**
+ * @brief Room in a vertex for the arrays of its first few adjacent vertices.
+ */
+typedef struct adjacency_slots_s {
+    struct vertex_s *vertices[ADJACENCY_INLINE_SLOTS]; /**< Inline slots. */
+    float weights[ADJACENCY_INLINE_SLOTS]; /**< Inline slots. */
+    unsigned int mirrors[ADJACENCY_INLINE_SLOTS]; /**< Inline slots. */
+} adjacency_slots_t;
+
+/**
+ * @brief The data structure that represents the vertex in the graph.
+ *
+ * @details
+ * The adjacent vertices to a vertex are stored as an array, along with where
+ * to find the other half of each edge so that an edge can be removed in
+ * constant time. In a directed graph the array holds the vertices the edges
+ * out of this vertex go to. Only the vertices of a graph that keeps the edges
+ * into each vertex as well are allocated with room for in_adjacency, which
+ * has no inline slots of its own.
+ */
+struct vertex_s {
+    adjacency_t adjacency; /**< The adjacent vertices. */
+    void *data; /**< The data stored at the vertex.*/
+    unsigned int id; /**< Position of the vertex in the graph's registry, also
+                          used to index the visited marks. */
+    adjacency_slots_t slots; /**< Inline slots of adjacency. */
+    adjacency_t in_adjacency[]; /**< The vertices with an edge into this
+                                     vertex, if the graph keeps them. */
+};
+
+#endif /* GRAPH_PRIVATE_H */
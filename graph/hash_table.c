@@ -0,0 +1,344 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file hash_table.c
+ * @author Ashutosh Grewal
+ * @date 01/14/17.
+ *
+ * @brief This file implements the hash table data structure.
+ *
+ * @details
+ * The hash table maps an opaque key to an opaque value. The user supplies a
+ * function to hash the key and a function to compare two keys, so any kind of
+ * information can be used as a key (just like the graph uses opaque data).
+ * This is implemented as an open addressing table using linear probing. The
+ * number of slots is always a power of two and the table is grown when it
+ * becomes three quarters full. Each slot also remembers the hash of its key so
+ * that growing the table and rejecting mismatches don't need to call the user
+ * functions.
+ * Deletion shifts the following entries of the probe sequence back instead of
+ * leaving tombstones, so lookups never slow down after many deletions.
+ *
+ * @bug Values must not be NULL as a NULL value marks an empty slot.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "public.h"
+#include "hash_table.h"
+
+#define HASH_TABLE_MIN_SLOTS 16
+
+/**
+ * @brief A slot in the hash table.
+ */
+typedef struct hash_slot_s {
+    void *key; /**< The user created opaque key. */
+    void *value; /**< The user created opaque value, NULL if slot is empty. */
+    unsigned long hash; /**< Hash of the key, cached. */
+} hash_slot_t;
+
+/**
+ * @brief The hash table data structure.
+ */
+struct hash_table_s {
+    hash_slot_t *slots; /**< Array of slots. */
+    unsigned int num_slots; /**< Number of slots, always a power of two. */
+    unsigned int count; /**< Number of slots in use. */
+    hash_key_t hash_key; /**< Function pointer to hash a key. */
+    key_is_equal_t key_is_equal; /**< Function pointer to compare two keys. */
+};
+
+/**
+ * @brief Create and initialize the hash table data structure.
+ *
+ * @param[in] hash_key Function to hash the opaque keys.
+ * @param[in] key_is_equal Function to compare two opaque keys, NULL if keys
+ *                         are only equal when they are the same pointer.
+ *
+ * @return Pointer to the hash table data structure if successful, NULL if
+ *         memory allocation failed.
+ */
+hash_table_t *create_hash_table (hash_key_t hash_key, key_is_equal_t key_is_equal)
+{
+    hash_table_t *table;
+    
+    table = (hash_table_t *) malloc (sizeof(hash_table_t));
+    if (table == NULL) {
+        
+        return NULL;
+    }
+    table->slots = (hash_slot_t *) calloc (HASH_TABLE_MIN_SLOTS, sizeof(hash_slot_t));
+    if (table->slots == NULL) {
+        free(table);
+        
+        return NULL;
+    }
+    table->num_slots = HASH_TABLE_MIN_SLOTS;
+    table->count = 0;
+    table->hash_key = hash_key;
+    table->key_is_equal = key_is_equal;
+    
+    return table;
+}
+
+/**
+ * @brief Find the slot holding the key or the empty slot where it would go.
+ *
+ * @param[in] table The hash table data structure.
+ * @param[in] key The opaque key we're looking for.
+ * @param[in] hash Hash of the key.
+ *
+ * @return Index of the slot.
+ */
+static unsigned int find_slot (hash_table_t *table, void *key, unsigned long hash)
+{
+    unsigned int mask, index;
+    hash_slot_t *slot;
+    
+    mask = table->num_slots - 1;
+    for (index = hash & mask; ; index = (index + 1) & mask) {
+        slot = &table->slots[index];
+        if (slot->value == NULL) {
+            break;
+        }
+        if (slot->hash == hash &&
+            (key == slot->key ||
+             (table->key_is_equal && table->key_is_equal(key, slot->key)))) {
+            break;
+        }
+    }
+    
+    return index;
+}
+
+/**
+ * @brief Grow the table to the given number of slots and re-insert all the
+ *        entries.
+ *
+ * @param[in, out] table The hash table data structure.
+ * @param[in] num_slots The new number of slots, a power of two larger than
+ *                      the current one.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean grow_hash_table (hash_table_t *table, unsigned int num_slots)
+{
+    hash_slot_t *old_slots, *slot;
+    unsigned int old_num_slots, mask, index;
+    
+    old_slots = table->slots;
+    old_num_slots = table->num_slots;
+    table->slots = (hash_slot_t *) calloc (num_slots, sizeof(hash_slot_t));
+    if (table->slots == NULL) {
+        table->slots = old_slots;
+        
+        return FALSE;
+    }
+    table->num_slots = num_slots;
+    mask = table->num_slots - 1;
+    
+    /*
+     * Keys are already known to be unique, so we only need to find a free
+     * slot for each one.
+     */
+    for (unsigned int i = 0; i < old_num_slots; i++) {
+        slot = &old_slots[i];
+        if (slot->value == NULL) {
+            continue;
+        }
+        for (index = slot->hash & mask; table->slots[index].value;
+             index = (index + 1) & mask);
+        table->slots[index] = *slot;
+    }
+    free(old_slots);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Make room for more entries, so that inserting them doesn't grow the
+ *        table again and again.
+ *
+ * @param[in, out] table The hash table data structure.
+ * @param[in] extra Number of entries about to be inserted.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean reserve_hash_table (hash_table_t *table, unsigned int extra)
+{
+    unsigned long needed;
+    unsigned int num_slots;
+    
+    if (table == NULL) {
+        
+        return FALSE;
+    }
+    needed = (unsigned long) table->count + extra;
+    num_slots = table->num_slots;
+    while (needed * 4 > (unsigned long) num_slots * 3) {
+        num_slots *= 2;
+    }
+    if (num_slots == table->num_slots) {
+        
+        return TRUE;
+    }
+    
+    return grow_hash_table(table, num_slots);
+}
+
+/**
+ * @brief Insert a key and its value to the hash table.
+ *
+ * @param[in, out] table The hash table data structure.
+ * @param[in] key The opaque key.
+ * @param[in] value The opaque value stored against the key, must not be NULL.
+ *
+ * @return TRUE if successful, FALSE if the key already exists or memory
+ *         allocation failed.
+ */
+boolean insert_to_hash_table (hash_table_t *table, void *key, void *value)
+{
+    unsigned long hash;
+    unsigned int index;
+    
+    if (table == NULL || value == NULL) {
+        
+        return FALSE;
+    }
+    if ((table->count + 1) * 4 > table->num_slots * 3) {
+        if (!grow_hash_table(table, table->num_slots * 2)) {
+            
+            return FALSE;
+        }
+    }
+    hash = table->hash_key(key);
+    index = find_slot(table, key, hash);
+    if (table->slots[index].value != NULL) {
+        
+        return FALSE;
+    }
+    table->slots[index].key = key;
+    table->slots[index].value = value;
+    table->slots[index].hash = hash;
+    table->count++;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Lookup the value stored against a key.
+ *
+ * @param[in] table The hash table data structure.
+ * @param[in] key The opaque key we're looking for.
+ *
+ * @return The opaque value if the key exists, NULL otherwise.
+ */
+void *lookup_in_hash_table (hash_table_t *table, void *key)
+{
+    if (table == NULL) {
+        
+        return NULL;
+    }
+    
+    return table->slots[find_slot(table, key, table->hash_key(key))].value;
+}
+
+/**
+ * @brief Delete a key from the hash table.
+ *
+ * @details
+ * Once the slot is emptied, the entries following it in the probe sequence
+ * are moved back if the empty slot lies between their home slot and where
+ * they currently are.
+ *
+ * @param[in, out] table The hash table data structure.
+ * @param[in] key The opaque key we're asked to delete.
+ *
+ * @return The opaque value stored against the key if it existed, NULL
+ *         otherwise.
+ */
+void *delete_from_hash_table (hash_table_t *table, void *key)
+{
+    unsigned int mask, empty, index, home;
+    void *value;
+    
+    if (table == NULL) {
+        
+        return NULL;
+    }
+    empty = find_slot(table, key, table->hash_key(key));
+    value = table->slots[empty].value;
+    if (value == NULL) {
+        
+        return NULL;
+    }
+    
+    mask = table->num_slots - 1;
+    for (index = (empty + 1) & mask; table->slots[index].value;
+         index = (index + 1) & mask) {
+        home = table->slots[index].hash & mask;
+        
+        /*
+         * Leave the entry alone if its home slot is cyclically in
+         * (empty, index].
+         */
+        if (((index - home) & mask) < ((index - empty) & mask)) {
+            continue;
+        }
+        table->slots[empty] = table->slots[index];
+        empty = index;
+    }
+    memset(&table->slots[empty], 0, sizeof(hash_slot_t));
+    table->count--;
+    
+    return value;
+}
+
+/**
+ * @brief Return the number of keys stored in the hash table.
+ *
+ * @param[in] table The hash table data structure.
+ *
+ * @return Number of keys.
+ */
+unsigned int get_hash_table_count (hash_table_t *table)
+{
+    if (table == NULL) {
+        
+        return 0;
+    }
+    
+    return table->count;
+}
+
+/**
+ * @brief Remove all the keys from the hash table, keeping its slots for the
+ *        keys inserted next. The keys and values are owned by the user and
+ *        are not freed.
+ *
+ * @param[in, out] table Pointer to the hash table data structure.
+ */
+void clear_hash_table (hash_table_t *table)
+{
+    if (table == NULL) {
+        
+        return;
+    }
+    memset(table->slots, 0, sizeof(hash_slot_t) * table->num_slots);
+    table->count = 0;
+}
+
+/**
+ * @brief Destroy the hash table data structure. The keys and values are owned
+ *        by the user and are not freed.
+ *
+ * @param[in, out] table Pointer to the hash table data structure.
+ */
+void destroy_hash_table (hash_table_t *table)
+{
+    if (table == NULL) {
+        
+        return;
+    }
+    free(table->slots);
+    free(table);
+}
@@ -0,0 +1,30 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file hash_table.h
+ * @author Ashutosh Grewal
+ * @date 01/14/17.
+ *
+ * @brief This header file contains APIs to use the hash table data structure
+ *        and some public structure declarations (the definitions of these
+ *        structures is not visible to the rest of the system to prevent
+ *        them from manipulating without using APIs).
+ */
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include "public.h"
+
+typedef struct hash_table_s hash_table_t;
+typedef unsigned long (*hash_key_t) (void *);
+typedef boolean (*key_is_equal_t) (void *, void *);
+
+hash_table_t *create_hash_table (hash_key_t, key_is_equal_t);
+boolean reserve_hash_table (hash_table_t *, unsigned int);
+boolean insert_to_hash_table (hash_table_t *, void *, void *);
+void *lookup_in_hash_table (hash_table_t *, void *);
+void *delete_from_hash_table (hash_table_t *, void *);
+unsigned int get_hash_table_count (hash_table_t *);
+void clear_hash_table (hash_table_t *);
+void destroy_hash_table (hash_table_t *);
+
+#endif /* HASH_TABLE_H */
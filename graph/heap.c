@@ -0,0 +1,303 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file heap.c
+ * @author Ashutosh Grewal
+ * @date 02/25/17.
+ *
+ * @brief This file implements the indexed heap data structure.
+ *
+ * @details
+ * The heap is a min heap of items, small integers such as vertex ids, each
+ * with a key. It is a 4-ary heap kept in an array: the children of the entry
+ * at position i are at 4i + 1 to 4i + 4. Four children per entry make the
+ * heap half as deep as a binary one, which makes lowering the key of an
+ * item, the common case in a shortest path search, cheaper. The heap also
+ * remembers the position of every item, so an item already in the heap can
+ * have its key lowered in place instead of being pushed again. Positions
+ * are only trusted if the entry they point at holds the item, so an emptied
+ * heap can be used again without clearing them.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "public.h"
+#include "heap.h"
+
+#define HEAP_ARITY 4
+#define HEAP_DEFAULT_CAPACITY 64
+
+/**
+ * @brief An entry of the heap.
+ */
+typedef struct heap_entry_s {
+    double key; /**< Key the heap is ordered by. */
+    unsigned int item; /**< The item. */
+} heap_entry_t;
+
+/**
+ * @brief The heap data structure.
+ */
+struct heap_s {
+    heap_entry_t *entries; /**< The entries, the smallest key first. */
+    unsigned int count; /**< Number of entries in the heap. */
+    unsigned int capacity; /**< Number of entries there's room for. */
+    unsigned int *positions; /**< Position of each item in entries. */
+    unsigned int num_items; /**< Number of items positions has room for. */
+};
+
+/**
+ * @brief Create and initialize the heap data structure.
+ *
+ * @return Pointer to the heap data structure if successful, NULL if memory
+ *         allocation failed.
+ */
+heap_t *create_heap (void)
+{
+    heap_t *heap;
+    
+    heap = (heap_t *) calloc (1, sizeof(heap_t));
+    if (heap == NULL) {
+        
+        return NULL;
+    }
+    heap->entries = (heap_entry_t *) malloc (sizeof(heap_entry_t) * HEAP_DEFAULT_CAPACITY);
+    if (heap->entries == NULL) {
+        free(heap);
+        
+        return NULL;
+    }
+    heap->capacity = HEAP_DEFAULT_CAPACITY;
+    
+    return heap;
+}
+
+/**
+ * @brief Make room for the items from 0 to num_items - 1.
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[in] num_items Number of items the heap might hold.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean reserve_heap (heap_t *heap, unsigned int num_items)
+{
+    unsigned int *positions;
+    
+    if (num_items <= heap->num_items) {
+        
+        return TRUE;
+    }
+    positions = (unsigned int *) realloc (heap->positions, sizeof(unsigned int) * num_items);
+    if (positions == NULL) {
+        
+        return FALSE;
+    }
+    memset(positions + heap->num_items, 0,
+           sizeof(unsigned int) * (num_items - heap->num_items));
+    heap->positions = positions;
+    heap->num_items = num_items;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Is this item in the heap?
+ *
+ * @param[in] heap The heap data structure.
+ * @param[in] item The item, less than what the heap was reserved for.
+ *
+ * @return TRUE if the item is in the heap, FALSE otherwise.
+ */
+boolean is_in_heap (heap_t *heap, unsigned int item)
+{
+    unsigned int position;
+    
+    position = heap->positions[item];
+    
+    return position < heap->count && heap->entries[position].item == item;
+}
+
+/**
+ * @brief Put an entry at a position and remember where its item went.
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[in] position Position of the entry.
+ * @param[in] entry The entry.
+ */
+static inline void place_entry (heap_t *heap, unsigned int position,
+                                heap_entry_t entry)
+{
+    heap->entries[position] = entry;
+    heap->positions[entry.item] = position;
+}
+
+/**
+ * @brief Move an entry up till its parent has a smaller key.
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[in] position Position of the entry.
+ */
+static void sift_up (heap_t *heap, unsigned int position)
+{
+    heap_entry_t entry;
+    unsigned int parent;
+    
+    entry = heap->entries[position];
+    while (position > 0) {
+        parent = (position - 1) / HEAP_ARITY;
+        if (heap->entries[parent].key <= entry.key) {
+            break;
+        }
+        place_entry(heap, position, heap->entries[parent]);
+        position = parent;
+    }
+    place_entry(heap, position, entry);
+}
+
+/**
+ * @brief Move an entry down till its children have larger keys.
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[in] position Position of the entry.
+ */
+static void sift_down (heap_t *heap, unsigned int position)
+{
+    heap_entry_t entry;
+    unsigned int child, smallest, last;
+    
+    entry = heap->entries[position];
+    for (;;) {
+        child = position * HEAP_ARITY + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        last = child + HEAP_ARITY;
+        if (last > heap->count) {
+            last = heap->count;
+        }
+        smallest = child;
+        for (child++; child < last; child++) {
+            if (heap->entries[child].key < heap->entries[smallest].key) {
+                smallest = child;
+            }
+        }
+        if (entry.key <= heap->entries[smallest].key) {
+            break;
+        }
+        place_entry(heap, position, heap->entries[smallest]);
+        position = smallest;
+    }
+    place_entry(heap, position, entry);
+}
+
+/**
+ * @brief Push an item that isn't in the heap yet to the heap.
+ *
+ * @see decrease_heap_key
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[in] item The item, less than what the heap was reserved for.
+ * @param[in] key The key of the item.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean push_to_heap (heap_t *heap, unsigned int item, double key)
+{
+    heap_entry_t *entries;
+    
+    if (heap->count == heap->capacity) {
+        entries = (heap_entry_t *) realloc (heap->entries,
+                                            sizeof(heap_entry_t) * heap->capacity * 2);
+        if (entries == NULL) {
+            
+            return FALSE;
+        }
+        heap->entries = entries;
+        heap->capacity *= 2;
+    }
+    heap->entries[heap->count].key = key;
+    heap->entries[heap->count].item = item;
+    sift_up(heap, heap->count++);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Lower the key of an item already in the heap.
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[in] item The item, in the heap.
+ * @param[in] key The new key of the item.
+ *
+ * @return TRUE if the key was lowered, FALSE if the item already has a key no
+ *         larger than this one.
+ */
+boolean decrease_heap_key (heap_t *heap, unsigned int item, double key)
+{
+    unsigned int position;
+    
+    position = heap->positions[item];
+    if (heap->entries[position].key <= key) {
+        
+        return FALSE;
+    }
+    heap->entries[position].key = key;
+    sift_up(heap, position);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Pop the item with the smallest key from the heap.
+ *
+ * @param[in, out] heap The heap data structure.
+ * @param[out] item The item.
+ * @param[out] key The key of the item.
+ *
+ * @return TRUE if an item was popped, FALSE if the heap is empty.
+ */
+boolean pop_from_heap (heap_t *heap, unsigned int *item, double *key)
+{
+    if (heap->count == 0) {
+        
+        return FALSE;
+    }
+    *item = heap->entries[0].item;
+    *key = heap->entries[0].key;
+    
+    /*
+     * Move the item out of the way first, so a stale position can't find it.
+     */
+    heap->positions[*item] = heap->count;
+    if (--heap->count > 0) {
+        heap->entries[0] = heap->entries[heap->count];
+        sift_down(heap, 0);
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Empty the heap, keeping the room it has grown to.
+ *
+ * @param[in, out] heap The heap data structure.
+ */
+void reset_heap (heap_t *heap)
+{
+    heap->count = 0;
+}
+
+/**
+ * @brief Destroy the heap data structure.
+ *
+ * @param[in, out] heap Pointer to the heap data structure.
+ */
+void destroy_heap (heap_t *heap)
+{
+    if (heap == NULL) {
+        
+        return;
+    }
+    free(heap->entries);
+    free(heap->positions);
+    free(heap);
+}
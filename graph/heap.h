@@ -0,0 +1,28 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file heap.h
+ * @author Ashutosh Grewal
+ * @date 02/25/17.
+ *
+ * @brief This header file contains APIs to use the indexed heap data
+ *        structure and some public structure declarations (the definitions
+ *        of these structures is not visible to the rest of the system to
+ *        prevent them from manipulating without using APIs).
+ */
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "public.h"
+
+typedef struct heap_s heap_t;
+
+heap_t *create_heap (void);
+boolean reserve_heap (heap_t *, unsigned int);
+boolean push_to_heap (heap_t *, unsigned int, double);
+boolean decrease_heap_key (heap_t *, unsigned int, double);
+boolean pop_from_heap (heap_t *, unsigned int *, double *);
+boolean is_in_heap (heap_t *, unsigned int);
+void reset_heap (heap_t *);
+void destroy_heap (heap_t *);
+
+#endif /* HEAP_H */
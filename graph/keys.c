@@ -0,0 +1,89 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file keys.c
+ * @author Ashutosh Grewal
+ * @date 04/03/17
+ *
+ * @brief This file implements comparing and hashing the key types a graph can
+ *        be created with.
+ *
+ * @details
+ * The graph itself doesn't call these on its fast paths, it compares integer
+ * keys as pointers inline and resolves a string once through its index,
+ * which keeps the hash of every key and so only compares the characters of
+ * strings that share a hash. String keys aren't interned, the index already
+ * turns each string into the one vertex holding it. These functions are
+ * kept as the data_is_equal and data_hash of the graph so that everything
+ * built from it, such as its CSR snapshots, still works on the opaque data.
+ */
+#include <stdint.h>
+#include <string.h>
+#include "public.h"
+#include "keys.h"
+
+/**
+ * @brief Determine if two integer keys are the same.
+ *
+ * @param[in] data1 First key.
+ * @param[in] data2 Second key.
+ *
+ * @return TRUE if they are the same, FALSE otherwise.
+ */
+boolean integer_key_is_equal (void *data1, void *data2)
+{
+    return data1 == data2;
+}
+
+/**
+ * @brief Hash an integer key.
+ *
+ * @details
+ * Keys are often small consecutive numbers, so they are mixed for the low bits
+ * the hash table uses to depend on all of them.
+ *
+ * @param[in] data The key.
+ *
+ * @return Hash of the key.
+ */
+unsigned long hash_integer_key (void *data)
+{
+    uint64_t hash = (uintptr_t) data;
+    
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    
+    return (unsigned long) hash;
+}
+
+/**
+ * @brief Determine if two string keys are the same.
+ *
+ * @param[in] data1 First key.
+ * @param[in] data2 Second key.
+ *
+ * @return TRUE if they are the same, FALSE otherwise.
+ */
+boolean string_key_is_equal (void *data1, void *data2)
+{
+    return data1 == data2 || strcmp((char *) data1, (char *) data2) == 0;
+}
+
+/**
+ * @brief Hash a string key, using FNV-1a.
+ *
+ * @param[in] data The key.
+ *
+ * @return Hash of the key.
+ */
+unsigned long hash_string_key (void *data)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    
+    for (unsigned char *c = (unsigned char *) data; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    
+    return (unsigned long) hash;
+}
@@ -0,0 +1,20 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file keys.h
+ * @author Ashutosh Grewal
+ * @date 04/03/17.
+ *
+ * @brief This header file contains the functions the graphs created with a key
+ *        type compare and hash the data of their vertices with.
+ */
+#ifndef KEYS_H
+#define KEYS_H
+
+#include "public.h"
+
+boolean integer_key_is_equal (void *, void *);
+unsigned long hash_integer_key (void *);
+boolean string_key_is_equal (void *, void *);
+unsigned long hash_string_key (void *);
+
+#endif /* KEYS_H */
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include "public.h"
 #include "graph.h"
+#include "allocator.h"
 
 /**
  * @brief Print the opaque data knowing that it stores strings.
@@ -55,11 +56,64 @@ boolean string_is_same (void *data1, void *data2)
     return TRUE;
 }
 
+/**
+ * @brief Hash the opaque data knowing that it stores strings.
+ *
+ * @param[in] data The opaque data we need to hash.
+ *
+ * @return Hash of the string.
+ */
+unsigned long hash_string (void *data)
+{
+    unsigned char *string;
+    unsigned long hash;
+    
+    hash = 5381;
+    for (string = (unsigned char *)data; *string; string++) {
+        hash = hash * 33 + *string;
+    }
+    
+    return hash;
+}
+
+/**
+ * @brief Allocate memory unless the pool, the number of allocations left,
+ *        has run out.
+ *
+ * @param[in, out] pool Number of allocations left.
+ * @param[in] size Size of the memory to allocate.
+ *
+ * @return Pointer to the memory, NULL once the pool has run out.
+ */
+void *allocate_limited (void *pool, size_t size)
+{
+    unsigned int *allocations_left = (unsigned int *)pool;
+    
+    if (*allocations_left == 0) {
+        return NULL;
+    }
+    (*allocations_left)--;
+    
+    return malloc(size);
+}
+
+/**
+ * @brief Free memory allocated by allocate_limited.
+ *
+ * @param[in] pool Number of allocations left.
+ * @param[in] memory The memory to free.
+ * @param[in] size Size it was allocated with.
+ */
+void deallocate_limited (void *pool, void *memory, size_t size)
+{
+    free(memory);
+}
+
 int main(int argc, const char * argv[]) {
     graph_t *graph;
     int adjacent_cities;
     
-    graph = create_graph (print_string, string_is_same);
+    graph = create_graph_with_hash (print_string, string_is_same, hash_string);
     
     char cities[][15] = {"Palo Alto", "Mountain View", "Sunnyvale", "San Jose", "Los Angeles"};
     
@@ -71,7 +125,7 @@ int main(int argc, const char * argv[]) {
     printf("\n");
     
     void **opaque_data;
-
+    
     adjacent_cities = 1;
     opaque_data = (void **)malloc (sizeof(void *) * adjacent_cities);
     opaque_data[0] = cities[0];
@@ -139,6 +193,36 @@ int main(int argc, const char * argv[]) {
     depth_first_traversal(graph);
     printf("\n");*/
     
+    destroy_graph(graph);
+    
+    /*
+     * Adding a vertex fails when the allocator runs out, and must leave the
+     * graph as it was. Only the vertex itself can be allocated, not the
+     * array for its five adjacent vertices.
+     */
+    unsigned int allocations_left = 20;
+    allocator_t limited = { allocate_limited, deallocate_limited, NULL, &allocations_left };
+    char new_city[] = "San Francisco";
+    
+    graph = create_graph_with_hash (print_string, string_is_same, hash_string);
+    graph_set_allocator(graph, &limited);
+    opaque_data = (void **)malloc (sizeof(void *) * 5);
+    add_vertex_to_graph(graph, cities[0], NULL, 0);
+    for (int i = 1; i < 5; i++) {
+        opaque_data[0] = cities[i - 1];
+        add_vertex_to_graph(graph, cities[i], opaque_data, 1);
+    }
+    for (int i = 0; i < 5; i++) {
+        opaque_data[i] = cities[i];
+    }
+    allocations_left = 1;
+    printf("add %s: %s\n", new_city,
+           add_vertex_to_graph(graph, new_city, opaque_data, 5) ? "added" : "failed");
+    printf("find %s: %s\n", new_city,
+           find_in_graph(graph, new_city) ? "found" : "not found");
+    free(opaque_data);
+    breadth_first_traversal(graph);
+    printf("\n");
     destroy_graph(graph);
     return 0;
 }
@@ -0,0 +1,76 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file partition.h
+ * @author Ashutosh Grewal
+ * @date 04/09/17.
+ *
+ * @brief Header file containing APIs to split a CSR snapshot into shards
+ *        that can be kept and searched apart from each other.
+ */
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "public.h"
+#include "graph.h"
+#include "csr.h"
+
+/**
+ * @brief How to pick the shard that owns each vertex.
+ */
+typedef enum partition_method_e {
+    PARTITION_HASH, /**< By a hash of the vertex's number, which is quick and
+                         balanced but cuts most edges. */
+    PARTITION_GREEDY /**< One pass over the vertices, putting each in the
+                          shard most of its adjacent vertices already are in,
+                          unless it's getting full. */
+} partition_method_t;
+
+typedef struct graph_partition_s graph_partition_t;
+typedef struct graph_shard_s graph_shard_t;
+
+/**
+ * @brief Called by a transport with vertices sent to a shard.
+ *
+ * @details
+ * The arguments are the numbers of the vertices in the shard they were sent
+ * to, how many there are and the argument given to receive.
+ */
+typedef void (*shard_deliver_t) (const unsigned int *, unsigned int, void *);
+
+/**
+ * @brief Moves batches of vertices between shards during a search.
+ *
+ * @details
+ * send is given the shard sending the batch, the shard it goes to, the
+ * numbers of the vertices in the shard they go to and how many there are.
+ * The vertices must be copied, as the array is reused once send returns.
+ * receive is given a shard and must call deliver, with the argument it was
+ * given, for every batch sent to that shard since it was last called. Both
+ * return FALSE if the batches couldn't be moved, which ends the search.
+ */
+typedef struct shard_transport_s {
+    boolean (*send) (void *, unsigned int, unsigned int, const unsigned int *,
+                     unsigned int);
+    boolean (*receive) (void *, unsigned int, shard_deliver_t, void *);
+    void *arg; /**< Passed to send and receive. */
+} shard_transport_t;
+
+graph_partition_t *csr_partition (csr_graph_t *, unsigned int, partition_method_t);
+unsigned int partition_num_shards (graph_partition_t *);
+unsigned long partition_edge_cut (graph_partition_t *);
+boolean partition_owner (graph_partition_t *, unsigned int, unsigned int *,
+                         unsigned int *);
+graph_shard_t *partition_get_shard (graph_partition_t *, unsigned int);
+unsigned int shard_num_vertices (graph_shard_t *);
+unsigned int shard_num_ghosts (graph_shard_t *);
+unsigned int shard_global_id (graph_shard_t *, unsigned int);
+void *shard_get_data (graph_shard_t *, unsigned int);
+boolean shard_neighbors (graph_shard_t *, unsigned int, const unsigned int **,
+                         unsigned int *);
+boolean shard_ghost_owner (graph_shard_t *, unsigned int, unsigned int *,
+                           unsigned int *);
+boolean partition_breadth_first_search (graph_partition_t *, unsigned int,
+                                        shard_transport_t *, unsigned int *);
+void destroy_graph_partition (graph_partition_t *);
+
+#endif /* PARTITION_H */
@@ -0,0 +1,342 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file partition_bfs.c
+ * @author Ashutosh Grewal
+ * @date 04/09/17
+ *
+ * @brief This file implements a breadth first search over the shards of a
+ *        partitioned snapshot that only talk to each other through a
+ *        transport.
+ *
+ * @details
+ * The search goes level by level. In every level, each shard takes the
+ * vertices it owns in the frontier and gives their unvisited adjacent
+ * vertices the next level. An adjacent vertex that is a ghost belongs to
+ * another shard, so its number there is put in a batch for that shard
+ * instead, and the batches are handed to the transport as they fill up. Once
+ * every shard has gone over its frontier, each one receives the batches sent
+ * to it and adds the vertices it hadn't visited to its next frontier. The
+ * search ends when no shard has a frontier left.
+ *
+ * A shard sends every ghost at most once, as the first level it's reached at
+ * is the lowest one. The shards are stepped through in this process, but each
+ * one reads only its own state and what the transport gives it, so a
+ * transport that moves the batches between machines lets the shards live on
+ * them. Without a transport, the batches are queued in memory.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "public.h"
+#include "csr.h"
+#include "partition.h"
+#include "partition_private.h"
+
+/**
+ * Number of vertices a shard puts in a batch for another shard before it
+ * sends it.
+ */
+#define PARTITION_BATCH 1024
+
+/**
+ * @brief The search's state for one shard.
+ */
+typedef struct shard_search_s {
+    graph_shard_t *shard; /**< The shard. */
+    unsigned int *levels; /**< Level of each vertex the shard owns. */
+    unsigned int *frontier; /**< Vertices at the current level. */
+    unsigned int *next; /**< Vertices at the next level. */
+    unsigned int frontier_size; /**< Number of vertices in frontier. */
+    unsigned int next_size; /**< Number of vertices in next. */
+    unsigned int next_level; /**< Level the vertices added to next get. */
+    unsigned char *sent; /**< Whether each ghost was sent to its owner. */
+} shard_search_t;
+
+/**
+ * @brief The batches being filled for the other shards.
+ */
+typedef struct shard_batches_s {
+    unsigned int *vertices; /**< Room for PARTITION_BATCH vertices per shard. */
+    unsigned int *counts; /**< Number of vertices in each shard's batch. */
+} shard_batches_t;
+
+/**
+ * @brief Vertices queued in memory for one shard.
+ */
+typedef struct shard_queue_s {
+    unsigned int *vertices; /**< The vertices. */
+    unsigned int count; /**< Number of vertices. */
+    unsigned int capacity; /**< Room in vertices. */
+} shard_queue_t;
+
+/**
+ * @brief Queue a batch for a shard in memory.
+ *
+ * @param[in, out] arg The queues of the shards.
+ * @param[in] from Shard sending the batch.
+ * @param[in] to Shard the batch goes to.
+ * @param[in] vertices Numbers of the vertices in that shard.
+ * @param[in] count Number of vertices.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean queue_batch (void *arg, unsigned int from, unsigned int to,
+                            const unsigned int *vertices, unsigned int count)
+{
+    shard_queue_t *queue = (shard_queue_t *) arg + to;
+    unsigned int *grown, capacity;
+    
+    if (queue->count + count > queue->capacity) {
+        capacity = queue->capacity ? queue->capacity : PARTITION_BATCH;
+        while (capacity < queue->count + count) {
+            capacity *= 2;
+        }
+        grown = (unsigned int *) realloc (queue->vertices,
+                                          sizeof(unsigned int) * capacity);
+        if (grown == NULL) {
+            
+            return FALSE;
+        }
+        queue->vertices = grown;
+        queue->capacity = capacity;
+    }
+    memcpy(queue->vertices + queue->count, vertices, sizeof(unsigned int) * count);
+    queue->count += count;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Deliver everything queued in memory for a shard.
+ *
+ * @param[in, out] arg The queues of the shards.
+ * @param[in] to The shard.
+ * @param[in] deliver Function to deliver the vertices with.
+ * @param[in] deliver_arg Argument to deliver.
+ *
+ * @return TRUE.
+ */
+static boolean dequeue_batches (void *arg, unsigned int to, shard_deliver_t deliver,
+                                void *deliver_arg)
+{
+    shard_queue_t *queue = (shard_queue_t *) arg + to;
+    
+    if (queue->count) {
+        deliver(queue->vertices, queue->count, deliver_arg);
+        queue->count = 0;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Give the vertices sent to a shard the next level, if they don't
+ *        have a level yet.
+ *
+ * @param[in] vertices Numbers of the vertices in the shard.
+ * @param[in] count Number of vertices.
+ * @param[in, out] arg The search's state for the shard.
+ */
+static void visit_sent (const unsigned int *vertices, unsigned int count, void *arg)
+{
+    shard_search_t *search = (shard_search_t *) arg;
+    
+    for (unsigned int i = 0; i < count; i++) {
+        if (vertices[i] < search->shard->num_vertices &&
+            search->levels[vertices[i]] == CSR_UNREACHED) {
+            search->levels[vertices[i]] = search->next_level;
+            search->next[search->next_size++] = vertices[i];
+        }
+    }
+}
+
+/**
+ * @brief Go over a shard's frontier, filling the batches for the other
+ *        shards with the ghosts reached.
+ *
+ * @param[in, out] search The search's state for the shard.
+ * @param[in, out] batches The batches for the other shards, all empty.
+ * @param[in] num_shards Number of shards.
+ * @param[in] transport The transport to send the batches with.
+ *
+ * @return TRUE if successful, FALSE if the transport failed.
+ */
+static boolean expand_shard (shard_search_t *search, shard_batches_t *batches,
+                             unsigned int num_shards, shard_transport_t *transport)
+{
+    graph_shard_t *shard = search->shard;
+    unsigned int vertex, adj_vertex, ghost, owner, *batch;
+    
+    for (unsigned int i = 0; i < search->frontier_size; i++) {
+        vertex = search->frontier[i];
+        for (unsigned int j = shard->offsets[vertex]; j < shard->offsets[vertex + 1]; j++) {
+            adj_vertex = shard->neighbors[j];
+            if (adj_vertex < shard->num_vertices) {
+                if (search->levels[adj_vertex] == CSR_UNREACHED) {
+                    search->levels[adj_vertex] = search->next_level;
+                    search->next[search->next_size++] = adj_vertex;
+                }
+                continue;
+            }
+            ghost = adj_vertex - shard->num_vertices;
+            if (search->sent[ghost]) {
+                continue;
+            }
+            search->sent[ghost] = TRUE;
+            owner = shard->owners[ghost];
+            batch = batches->vertices + (size_t) owner * PARTITION_BATCH;
+            batch[batches->counts[owner]++] = shard->remote_ids[ghost];
+            if (batches->counts[owner] == PARTITION_BATCH) {
+                if (!transport->send(transport->arg, shard->id, owner, batch,
+                                     PARTITION_BATCH)) {
+                    
+                    return FALSE;
+                }
+                batches->counts[owner] = 0;
+            }
+        }
+    }
+    for (owner = 0; owner < num_shards; owner++) {
+        if (batches->counts[owner] == 0) {
+            continue;
+        }
+        if (!transport->send(transport->arg, shard->id, owner,
+                             batches->vertices + (size_t) owner * PARTITION_BATCH,
+                             batches->counts[owner])) {
+            
+            return FALSE;
+        }
+        batches->counts[owner] = 0;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Search the shards of a partition in a breadth first fashion.
+ *
+ * @details
+ * Every vertex gets its level, the number of edges between it and the
+ * source, or CSR_UNREACHED if it can't be reached, the same levels a search
+ * of the snapshot would give. Without a transport, the shards send each
+ * other their batches through queues in memory.
+ *
+ * @param[in] partition Pointer to the partition.
+ * @param[in] source Number of the vertex to start from in the snapshot.
+ * @param[in] transport The transport for the batches, NULL to keep them in
+ *                      memory.
+ * @param[out] levels Array with an entry for each vertex of the snapshot.
+ *
+ * @return TRUE if successful, FALSE if the source isn't in the snapshot, we
+ *         ran out of memory or the transport failed.
+ */
+boolean partition_breadth_first_search (graph_partition_t *partition,
+                                        unsigned int source,
+                                        shard_transport_t *transport,
+                                        unsigned int *levels)
+{
+    shard_search_t *searches, *search;
+    shard_batches_t batches;
+    shard_queue_t *queues = NULL;
+    shard_transport_t in_memory;
+    graph_shard_t *shard;
+    unsigned int num_shards = partition->num_shards, *swap;
+    boolean searched = FALSE, any_left;
+    
+    if (source >= partition->num_vertices) {
+        
+        return FALSE;
+    }
+    searches = (shard_search_t *) calloc (num_shards, sizeof(shard_search_t));
+    batches.vertices = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                PARTITION_BATCH * num_shards);
+    batches.counts = (unsigned int *) calloc (num_shards, sizeof(unsigned int));
+    if (searches == NULL || batches.vertices == NULL || batches.counts == NULL) {
+        goto done;
+    }
+    if (transport == NULL) {
+        queues = (shard_queue_t *) calloc (num_shards, sizeof(shard_queue_t));
+        if (queues == NULL) {
+            goto done;
+        }
+        in_memory.send = queue_batch;
+        in_memory.receive = dequeue_batches;
+        in_memory.arg = queues;
+        transport = &in_memory;
+    }
+    for (unsigned int id = 0; id < num_shards; id++) {
+        search = &searches[id];
+        shard = &partition->shards[id];
+        search->shard = shard;
+        search->levels = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                  (shard->num_vertices + 1));
+        search->frontier = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                    (shard->num_vertices + 1));
+        search->next = (unsigned int *) malloc (sizeof(unsigned int) *
+                                                (shard->num_vertices + 1));
+        search->sent = (unsigned char *) calloc (shard->num_ghosts + 1, 1);
+        if (search->levels == NULL || search->frontier == NULL ||
+            search->next == NULL || search->sent == NULL) {
+            goto done;
+        }
+        for (unsigned int i = 0; i < shard->num_vertices; i++) {
+            search->levels[i] = CSR_UNREACHED;
+        }
+    }
+    search = &searches[partition->owners[source]];
+    search->levels[partition->local_ids[source]] = 0;
+    search->frontier[search->frontier_size++] = partition->local_ids[source];
+    
+    for (unsigned int level = 1; ; level++) {
+        for (unsigned int id = 0; id < num_shards; id++) {
+            searches[id].next_level = level;
+            if (!expand_shard(&searches[id], &batches, num_shards, transport)) {
+                goto done;
+            }
+        }
+        any_left = FALSE;
+        for (unsigned int id = 0; id < num_shards; id++) {
+            search = &searches[id];
+            if (!transport->receive(transport->arg, id, visit_sent, search)) {
+                goto done;
+            }
+            swap = search->frontier;
+            search->frontier = search->next;
+            search->next = swap;
+            search->frontier_size = search->next_size;
+            search->next_size = 0;
+            any_left = any_left || search->frontier_size;
+        }
+        if (!any_left) {
+            break;
+        }
+    }
+    
+    for (unsigned int id = 0; id < num_shards; id++) {
+        shard = &partition->shards[id];
+        for (unsigned int i = 0; i < shard->num_vertices; i++) {
+            levels[shard->global_ids[i]] = searches[id].levels[i];
+        }
+    }
+    searched = TRUE;
+
+done:
+    if (searches) {
+        for (unsigned int id = 0; id < num_shards; id++) {
+            free(searches[id].levels);
+            free(searches[id].frontier);
+            free(searches[id].next);
+            free(searches[id].sent);
+        }
+    }
+    if (queues) {
+        for (unsigned int id = 0; id < num_shards; id++) {
+            free(queues[id].vertices);
+        }
+    }
+    free(searches);
+    free(batches.vertices);
+    free(batches.counts);
+    free(queues);
+    
+    return searched;
+}
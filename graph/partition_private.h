@@ -0,0 +1,57 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file partition_private.h
+ * @author Ashutosh Grewal
+ * @date 04/09/17.
+ *
+ * @brief Private definition of the shards of a CSR snapshot shared by the
+ *        files that build or search them. This separate header file is made
+ *        as we do not want these definitions made visible to the rest of the
+ *        system.
+ */
+#ifndef PARTITION_PRIVATE_H
+#define PARTITION_PRIVATE_H
+
+#include "public.h"
+#include "partition.h"
+
+/**
+ * @brief The vertices one shard owns and their edges.
+ *
+ * @details
+ * The shard numbers its vertices on its own. Those it owns come first, from 0
+ * to num_vertices - 1, in the order of their numbers in the snapshot. The
+ * vertices owned by other shards that they have edges to, the ghosts, come
+ * after them, so a neighbor numbered num_vertices or more is ghost number
+ * neighbor - num_vertices. The neighbors are laid out as in the snapshot, and
+ * a ghost's entry in owners and remote_ids says where to find it, so a shard
+ * needs nothing but itself to be searched.
+ */
+struct graph_shard_s {
+    unsigned int id; /**< Number of the shard. */
+    unsigned int num_vertices; /**< Number of vertices the shard owns. */
+    unsigned int num_ghosts; /**< Number of ghosts. */
+    unsigned int *global_ids; /**< Snapshot number of every owned vertex and
+                                   then of every ghost. */
+    unsigned int *offsets; /**< Start of each owned vertex's neighbors, has
+                                num_vertices + 1 entries. */
+    unsigned int *neighbors; /**< Shard numbers of the adjacent vertices. */
+    unsigned int *owners; /**< Shard owning each ghost. */
+    unsigned int *remote_ids; /**< Number of each ghost in its owner. */
+    void **data; /**< The data stored at each owned vertex. */
+};
+
+/**
+ * @brief The shards of a snapshot and where each vertex went.
+ */
+struct graph_partition_s {
+    unsigned int num_shards; /**< Number of shards. */
+    unsigned int num_vertices; /**< Number of vertices in the snapshot. */
+    unsigned int *owners; /**< Shard owning each vertex of the snapshot. */
+    unsigned int *local_ids; /**< Number of each vertex in its owner. */
+    unsigned long edge_cut; /**< Number of edges between vertices of
+                                 different shards. */
+    graph_shard_t *shards; /**< The shards. */
+};
+
+#endif /* PARTITION_PRIVATE_H */
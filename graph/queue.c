@@ -10,25 +10,35 @@
  * A queue data structure is a type of linked list where all new elements are
  * pushed to the back while all deletions happen at the front. This is like a
  * queue of people waiting in line to get into a bus.
- * This is implemented as a structure of nodes where we track the first and
- * last element and each node is linked to the next via pointer.
+ * This is implemented as a ring buffer: an array of elements where we track the
+ * position of the first element and the number of elements, wrapping around to
+ * the start of the array once we reach its end. When the array fills up, it is
+ * doubled in size, so pushing and popping don't allocate memory in the common
+ * case. A queue can be emptied with reset_queue and used again, keeping the
+ * array it has grown to.
  *
  * @bug Some of these functions don't check if the passed in queue pointer is
  *      NULL.
  */
 #include <string.h>
 #include <stdlib.h>
-#include <assert.h>
 #include "queue.h"
 #include "public.h"
-#include "list_private.h"
+
+#define QUEUE_DEFAULT_CAPACITY 16
 
 /**
  * @brief The queue data structure.
  */
 struct queue_s {
-    node_t *first; /**< Pointer to the first element of the queue. */
-    node_t *last; /**< Pointer to the last element of the queue. */
+    void **elements; /**< Ring buffer of the opaque data stored. */
+    unsigned int capacity; /**< Number of elements the buffer has room for,
+                                always a power of two. */
+    unsigned int first; /**< Position of the first element of the queue. */
+    unsigned int count; /**< Number of elements in the queue. */
+#ifdef GRAPH_ENABLE_STATS
+    unsigned int high_water; /**< Most elements the queue has held. */
+#endif
 };
 
 /**
@@ -38,17 +48,82 @@ struct queue_s {
  *         allocation failed.
  */
 queue_t *create_queue (void)
+{
+    return create_queue_with_capacity(QUEUE_DEFAULT_CAPACITY);
+}
+
+/**
+ * @brief Create and initialize the queue data structure with room for the
+ *        given number of elements.
+ *
+ * @param[in] capacity Number of elements the queue is expected to hold, the
+ *                     queue still grows beyond it if needed.
+ *
+ * @return Pointer to the queue data structure if successful, NULL if memory
+ *         allocation failed.
+ */
+queue_t *create_queue_with_capacity (unsigned int capacity)
 {
     queue_t *queue;
+    unsigned int size;
+    
+    /*
+     * A power of two lets us wrap around using a mask.
+     */
+    for (size = QUEUE_DEFAULT_CAPACITY; size < capacity; size *= 2);
     
     queue = (queue_t *) malloc (sizeof(queue_t));
-    if (queue != NULL) {
-         memset(queue, 0, sizeof(queue_t));
+    if (queue == NULL) {
+        
+        return NULL;
     }
+    queue->elements = (void **) malloc (sizeof(void *) * size);
+    if (queue->elements == NULL) {
+        free(queue);
+        
+        return NULL;
+    }
+    queue->capacity = size;
+    queue->first = queue->count = 0;
+#ifdef GRAPH_ENABLE_STATS
+    queue->high_water = 0;
+#endif
     
     return queue;
 }
 
+/**
+ * @brief Double the room in the queue, straightening out the elements that
+ *        wrapped around.
+ *
+ * @param[in, out] queue The queue data structure.
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ */
+static boolean grow_queue (queue_t *queue)
+{
+    void **elements;
+    unsigned int wrapped;
+    
+    elements = (void **) realloc (queue->elements,
+                                  sizeof(void *) * queue->capacity * 2);
+    if (elements == NULL) {
+        
+        return FALSE;
+    }
+    
+    /*
+     * The queue is full, so the elements in front of first are the ones that
+     * wrapped around. Move them after the old end of the buffer.
+     */
+    wrapped = queue->first;
+    memcpy(elements + queue->capacity, elements, sizeof(void *) * wrapped);
+    queue->elements = elements;
+    queue->capacity *= 2;
+    
+    return TRUE;
+}
+
 /**
  * @brief Push an element to the back of the queue.
  *
@@ -59,21 +134,17 @@ queue_t *create_queue (void)
  */
 boolean push_to_queue (queue_t *queue, void *data)
 {
-    node_t *node;
-    
-    node = (node_t *) malloc (sizeof(node_t));
-    if (node == NULL) {
+    if (queue->count == queue->capacity && !grow_queue(queue)) {
         
         return FALSE;
     }
-    node->data = data;
-    node->next = NULL;
-    if (queue->first == NULL) {
-        queue->first = queue->last = node;
-    } else {
-        queue->last->next = node;
-        queue->last = node;
+    queue->elements[(queue->first + queue->count) & (queue->capacity - 1)] = data;
+    queue->count++;
+#ifdef GRAPH_ENABLE_STATS
+    if (queue->count > queue->high_water) {
+        queue->high_water = queue->count;
     }
+#endif
     
     return TRUE;
 }
@@ -88,40 +159,50 @@ boolean push_to_queue (queue_t *queue, void *data)
  */
 void *pop_from_queue (queue_t *queue)
 {
-    node_t *node;
     void *data;
     
-    if (queue->first == NULL) {
+    if (queue->count == 0) {
         
         return NULL;
-    } else if (queue->first == queue->last){
-        node = queue->first;
-        assert(queue->first->next == NULL);
-        queue->first = queue->last = NULL;
-    } else {
-        node = queue->first;
-        queue->first = queue->first->next;
     }
-    data = node->data;
-    free(node);
+    data = queue->elements[queue->first];
+    queue->first = (queue->first + 1) & (queue->capacity - 1);
+    queue->count--;
     
     return data;
 }
 
+#ifdef GRAPH_ENABLE_STATS
+/**
+ * @brief Return the most elements the queue has held since it was created.
+ *
+ * @param[in] queue The queue data structure.
+ *
+ * @return The high water mark of the queue.
+ */
+unsigned int get_queue_high_water (queue_t *queue)
+{
+    return queue->high_water;
+}
+#endif
+
+/**
+ * @brief Remove all the elements from the queue, keeping its room for the
+ *        next use.
+ *
+ * @param[in, out] queue The queue data structure.
+ */
+void reset_queue (queue_t *queue)
+{
+    queue->first = queue->count = 0;
+}
+
 /**
  * @brief Destroy the queue data structure and freeing the elements.
  *
  * @param[in, out] queue Pointer to the queue data structure.
  */
 void destroy_queue (queue_t *queue) {
-    node_t *node, *temp;
-    
-    node = queue->first;
-    while (node) {
-        temp = node;
-        node = node->next;
-        free(temp);
-    }
-    queue->first = queue->last = NULL;
+    free(queue->elements);
     free(queue);
 }
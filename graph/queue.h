@@ -17,8 +17,13 @@
 typedef struct queue_s queue_t;
 
 queue_t *create_queue (void);
+queue_t *create_queue_with_capacity (unsigned int);
 boolean push_to_queue (queue_t *, void *);
 void *pop_from_queue (queue_t *);
+void reset_queue (queue_t *);
+#ifdef GRAPH_ENABLE_STATS
+unsigned int get_queue_high_water (queue_t *);
+#endif
 void destroy_queue (queue_t *);
 
 #endif /* QUEUE_H */
@@ -0,0 +1,258 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file shortest_path.c
+ * @author Ashutosh Grewal
+ * @date 02/25/17.
+ *
+ * @brief This file implements the shortest path searches over the weighted
+ *        edges of a graph.
+ *
+ * @details
+ * The searches are Dijkstra's algorithm and A*, which is Dijkstra's algorithm
+ * ordering the frontier by the distance so far plus an estimate of the
+ * distance left. The frontier is the indexed heap of the traversal context,
+ * keyed by vertex id, and the distances and parents live in the context as
+ * well, so repeated searches with the same context don't allocate. A vertex
+ * is marked when it's first reached and settled once it leaves the heap, at
+ * which point its distance is final. A search for a target stops as soon as
+ * the target is settled.
+ */
+#include <stdlib.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "shortest_path.h"
+#include "graph_private.h"
+#include "adjacency.h"
+#include "traversal_private.h"
+#include "heap.h"
+#include "stats.h"
+
+/**
+ * @brief Search for the shortest paths from the source, the caller must hold
+ *        the graph's lock.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context.
+ * @param[in] source Vertex the paths start from.
+ * @param[in] target Vertex to stop at, NULL to find the paths to all the
+ *                   vertices.
+ * @param[in] heuristic Estimate of the distance left to the target, NULL for
+ *                      none.
+ * @param[in] arg Opaque argument passed to the heuristic.
+ *
+ * @return TRUE if the target was settled (or, without a target, the search
+ *         ran), FALSE otherwise.
+ */
+static boolean search_shortest_path (graph_t *graph, traversal_ctx_t *ctx,
+                                     vertex_t *source, vertex_t *target,
+                                     heuristic_t heuristic, void *arg)
+{
+    vertex_t *vertex, *adj_vertex;
+    unsigned int id, adj_id;
+    double key, distance;
+    
+    if (!begin_context_shortest_path(ctx, graph->num_vertices)) {
+        
+        return FALSE;
+    }
+    context_mark_visited(ctx, source->id);
+    ctx->distances[source->id] = 0;
+    ctx->depths[source->id] = 0;
+    ctx->parents[source->id] = NULL;
+    key = heuristic && target ? heuristic(source->data, target->data, arg) : 0;
+    if (!push_to_heap(ctx->heap, source->id, key)) {
+        
+        return FALSE;
+    }
+    
+    while (pop_from_heap(ctx->heap, &id, &key)) {
+        vertex = graph->vertices[id];
+        if (vertex == target) {
+            
+            return TRUE;
+        }
+        for (unsigned int i = 0; i < get_adjacent_count(vertex); i++) {
+            adj_vertex = get_adjacent_vertex(vertex, i);
+            adj_id = adj_vertex->id;
+            distance = ctx->distances[id] + get_adjacent_weight(vertex, i);
+            
+            /*
+             * A vertex reached before only moves if this path is shorter. For
+             * a heuristic that overestimates now and then, that may take a
+             * settled vertex back into the heap.
+             */
+            if (context_is_visited(ctx, adj_id) && ctx->distances[adj_id] <= distance) {
+                continue;
+            }
+            context_mark_visited(ctx, adj_id);
+            ctx->distances[adj_id] = distance;
+            ctx->depths[adj_id] = ctx->depths[id] + 1;
+            ctx->parents[adj_id] = vertex;
+            if (heuristic && target) {
+                distance += heuristic(adj_vertex->data, target->data, arg);
+            }
+            if (is_in_heap(ctx->heap, adj_id)) {
+                decrease_heap_key(ctx->heap, adj_id, distance);
+            } else if (!push_to_heap(ctx->heap, adj_id, distance)) {
+                
+                return FALSE;
+            }
+        }
+    }
+    
+    return target == NULL;
+}
+
+/**
+ * @brief Find the shortest path between two vertices of the graph using
+ *        Dijkstra's algorithm.
+ *
+ * @details
+ * The length of a path is the sum of the weights of its edges. Once this
+ * returns, get_path_from_context gives the path and get_distance_from_context
+ * the distance to any vertex settled by the search, till the context is used
+ * again or the graph is changed. Without a target, the search settles all
+ * the vertices that can be reached from the source.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] source Vertex the path starts from.
+ * @param[in] target Vertex the path ends at, NULL to find the paths to all
+ *                   the vertices.
+ * @param[out] distance Length of the path, if one is found and not NULL.
+ *
+ * @return TRUE if a path was found (or, without a target, the search ran),
+ *         FALSE if there's no path or memory allocation failed.
+ */
+boolean shortest_path_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                    vertex_t *source, vertex_t *target,
+                                    double *distance)
+{
+    return astar_shortest_path_with_context(graph, ctx, source, target, NULL,
+                                            NULL, distance);
+}
+
+/**
+ * @brief Find the shortest path between two vertices of the graph using A*.
+ *
+ * @details
+ * The heuristic estimates the distance between the data of a vertex and the
+ * data of the target, such as the straight line distance between two cities.
+ * The path found is the shortest one as long as the heuristic never
+ * overestimates, and the search settles fewer vertices the closer the
+ * estimate is.
+ *
+ * @see shortest_path_with_context
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in, out] ctx The traversal context, must not be in use by another
+ *                     thread.
+ * @param[in] source Vertex the path starts from.
+ * @param[in] target Vertex the path ends at.
+ * @param[in] heuristic Function estimating the distance left, NULL to search
+ *                      like shortest_path_with_context does.
+ * @param[in] arg Opaque argument passed to the heuristic.
+ * @param[out] distance Length of the path, if one is found and not NULL.
+ *
+ * @return TRUE if a path was found, FALSE if there's no path or memory
+ *         allocation failed.
+ */
+boolean astar_shortest_path_with_context (graph_t *graph, traversal_ctx_t *ctx,
+                                          vertex_t *source, vertex_t *target,
+                                          heuristic_t heuristic, void *arg,
+                                          double *distance)
+{
+    boolean found;
+    GRAPH_STATS_TIMER(timer);
+    
+    if (source == NULL) {
+        
+        return FALSE;
+    }
+    GRAPH_STATS_BEGIN(timer);
+    pthread_rwlock_rdlock(&graph->lock);
+    found = search_shortest_path(graph, ctx, source, target, heuristic, arg);
+    if (found && target && distance) {
+        *distance = ctx->distances[target->id];
+    }
+    pthread_rwlock_unlock(&graph->lock);
+    GRAPH_STATS_END(graph, GRAPH_OP_PATH, timer);
+    
+    return found;
+}
+
+/**
+ * @brief Is this vertex settled by the last shortest path search?
+ *
+ * @param[in] ctx The traversal context.
+ * @param[in] vertex The vertex.
+ *
+ * @return TRUE if the vertex is settled, FALSE otherwise.
+ */
+static boolean is_settled (traversal_ctx_t *ctx, vertex_t *vertex)
+{
+    if (ctx->heap == NULL || vertex->id >= ctx->capacity) {
+        
+        return FALSE;
+    }
+    
+    return context_is_visited(ctx, vertex->id) && !is_in_heap(ctx->heap, vertex->id);
+}
+
+/**
+ * @brief Get the distance of a vertex from the source of the last shortest
+ *        path search.
+ *
+ * @param[in] ctx The traversal context of the search.
+ * @param[in] vertex The vertex.
+ * @param[out] distance The distance.
+ *
+ * @return TRUE if the search settled the vertex, FALSE otherwise.
+ */
+boolean get_distance_from_context (traversal_ctx_t *ctx, vertex_t *vertex,
+                                   double *distance)
+{
+    if (!is_settled(ctx, vertex)) {
+        
+        return FALSE;
+    }
+    *distance = ctx->distances[vertex->id];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Get the path from the source of the last shortest path search to a
+ *        vertex.
+ *
+ * @param[in] ctx The traversal context of the search.
+ * @param[in] vertex The vertex the path ends at.
+ * @param[out] path Array for the vertices of the path, the source first.
+ * @param[in] max_length Number of vertices the array has room for.
+ *
+ * @return Number of vertices in the path, 0 if the search didn't settle the
+ *         vertex or the path doesn't fit in the array.
+ */
+unsigned int get_path_from_context (traversal_ctx_t *ctx, vertex_t *vertex,
+                                    vertex_t **path, unsigned int max_length)
+{
+    unsigned int length;
+    
+    if (!is_settled(ctx, vertex)) {
+        
+        return 0;
+    }
+    length = ctx->depths[vertex->id] + 1;
+    if (length > max_length) {
+        
+        return 0;
+    }
+    for (unsigned int i = length; i > 0; i--) {
+        path[i - 1] = vertex;
+        vertex = ctx->parents[vertex->id];
+    }
+    
+    return length;
+}
@@ -0,0 +1,27 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file shortest_path.h
+ * @author Ashutosh Grewal
+ * @date 02/25/17.
+ *
+ * @brief Header file containing APIs to find the shortest paths between the
+ *        vertices of a graph with weighted edges.
+ */
+#ifndef SHORTEST_PATH_H
+#define SHORTEST_PATH_H
+
+#include "public.h"
+#include "graph.h"
+#include "traversal.h"
+
+typedef double (*heuristic_t) (void *, void *, void *);
+
+boolean shortest_path_with_context (graph_t *, traversal_ctx_t *, vertex_t *,
+                                    vertex_t *, double *);
+boolean astar_shortest_path_with_context (graph_t *, traversal_ctx_t *, vertex_t *,
+                                          vertex_t *, heuristic_t, void *, double *);
+boolean get_distance_from_context (traversal_ctx_t *, vertex_t *, double *);
+unsigned int get_path_from_context (traversal_ctx_t *, vertex_t *, vertex_t **,
+                                    unsigned int);
+
+#endif /* SHORTEST_PATH_H */
@@ -0,0 +1,321 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file slab.c
+ * @author Ashutosh Grewal
+ * @date 02/04/17.
+ *
+ * @brief This file implements the slab pool.
+ *
+ * @details
+ * A slab pool hands out memory for small objects carved out of large chunks,
+ * so allocating many objects of the same size neither calls malloc for each
+ * one nor scatters them across the heap. Sizes are rounded up to a size class
+ * and every size class has its own chunks. Freed objects are kept on a free
+ * list of their size class and handed out again before carving more out of a
+ * chunk. Objects too big for any size class are allocated with malloc but
+ * still tracked by the pool.
+ * Everything allocated from the pool can be freed at once by releasing the
+ * pool, which frees the chunks without looking at the objects in them.
+ * Resetting the pool forgets the objects too, but keeps the chunks to carve
+ * the next objects out of, so filling the pool again doesn't go to malloc.
+ *
+ * @bug The pool is not thread safe, its users must serialize access to it.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "public.h"
+#include "slab.h"
+
+#define SLAB_ALIGNMENT 16
+#define SLAB_SMALL_LIMIT 256
+#define SLAB_NUM_SMALL_CLASSES (SLAB_SMALL_LIMIT / SLAB_ALIGNMENT)
+#define SLAB_NUM_LARGE_CLASSES 8
+#define SLAB_NUM_CLASSES (SLAB_NUM_SMALL_CLASSES + SLAB_NUM_LARGE_CLASSES)
+#define SLAB_LARGEST_CLASS (SLAB_SMALL_LIMIT << SLAB_NUM_LARGE_CLASSES)
+#define SLAB_CHUNK_SIZE (64 * 1024)
+#define SLAB_MIN_OBJECTS_PER_CHUNK 8
+
+/**
+ * @brief A chunk of memory objects are carved out of. The objects follow the
+ *        header.
+ */
+typedef struct slab_chunk_s {
+    struct slab_chunk_s *next; /**< Next chunk of the same pool. */
+    struct slab_chunk_s *prev; /**< Previous chunk, only used for the chunks
+                                    holding a single big object. */
+    size_t size; /**< Size of the chunk including this header. */
+    size_t padding; /**< Keeps the objects aligned. */
+} slab_chunk_t;
+
+/**
+ * @brief An object on the free list of its size class.
+ */
+typedef struct slab_free_object_s {
+    struct slab_free_object_s *next; /**< Next free object. */
+} slab_free_object_t;
+
+/**
+ * @brief All the objects of one size.
+ */
+typedef struct slab_class_s {
+    slab_free_object_t *free_list; /**< Objects freed back to the pool. */
+    char *next_object; /**< Next object not yet carved out of the current
+                            chunk. */
+    char *chunk_end; /**< End of the current chunk. */
+} slab_class_t;
+
+/**
+ * @brief The slab pool data structure.
+ */
+struct slab_pool_s {
+    slab_class_t classes[SLAB_NUM_CLASSES]; /**< Size classes. */
+    slab_chunk_t *chunks; /**< Chunks shared by the size classes. */
+    slab_chunk_t *big_objects; /**< Objects too big for any size class, each
+                                    in its own chunk. */
+    slab_chunk_t *spare; /**< Chunks kept by a reset, for the size classes to
+                              reuse. */
+};
+
+/**
+ * @brief Create and initialize the slab pool.
+ *
+ * @return Pointer to the slab pool if successful, NULL if memory allocation
+ *         failed.
+ */
+slab_pool_t *create_slab_pool (void)
+{
+    return (slab_pool_t *) calloc (1, sizeof(slab_pool_t));
+}
+
+/**
+ * @brief Find the size class of the given size.
+ *
+ * @param[in] size Size of the object.
+ * @param[out] class_size Size of the objects of the class.
+ *
+ * @return Index of the size class, SLAB_NUM_CLASSES if the object is too big.
+ */
+static unsigned int find_size_class (size_t size, size_t *class_size)
+{
+    unsigned int index;
+    size_t limit;
+    
+    if (size == 0) {
+        size = 1;
+    }
+    if (size <= SLAB_SMALL_LIMIT) {
+        index = (unsigned int) ((size + SLAB_ALIGNMENT - 1) / SLAB_ALIGNMENT);
+        *class_size = index * SLAB_ALIGNMENT;
+        
+        return index - 1;
+    }
+    index = SLAB_NUM_SMALL_CLASSES;
+    for (limit = SLAB_SMALL_LIMIT * 2; limit < size && index < SLAB_NUM_CLASSES;
+         limit *= 2) {
+        index++;
+    }
+    *class_size = limit;
+    
+    return index;
+}
+
+/**
+ * @brief Add a new chunk to a size class, reusing a spare one if it's big
+ *        enough.
+ *
+ * @param[in, out] pool The slab pool.
+ * @param[in, out] slab_class The size class.
+ * @param[in] class_size Size of the objects of the class.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+static boolean add_chunk (slab_pool_t *pool, slab_class_t *slab_class,
+                          size_t class_size)
+{
+    slab_chunk_t *chunk, **link;
+    size_t size;
+    
+    size = SLAB_CHUNK_SIZE;
+    if (size < sizeof(slab_chunk_t) + class_size * SLAB_MIN_OBJECTS_PER_CHUNK) {
+        size = sizeof(slab_chunk_t) + class_size * SLAB_MIN_OBJECTS_PER_CHUNK;
+    }
+    for (link = &pool->spare; *link && (*link)->size < size; link = &(*link)->next);
+    if (*link) {
+        chunk = *link;
+        *link = chunk->next;
+    } else {
+        chunk = (slab_chunk_t *) malloc (size);
+        if (chunk == NULL) {
+            
+            return FALSE;
+        }
+        chunk->size = size;
+    }
+    chunk->prev = NULL;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+    slab_class->next_object = (char *) (chunk + 1);
+    slab_class->chunk_end = (char *) chunk + chunk->size;
+    
+    return TRUE;
+}
+
+/**
+ * @brief Allocate memory for an object from the pool.
+ *
+ * @param[in, out] pool The slab pool.
+ * @param[in] size Size of the object.
+ *
+ * @return Pointer to the memory, aligned to 16 bytes, NULL if memory
+ *         allocation failed.
+ */
+void *allocate_from_slab_pool (slab_pool_t *pool, size_t size)
+{
+    slab_class_t *slab_class;
+    slab_free_object_t *object;
+    slab_chunk_t *chunk;
+    size_t class_size;
+    unsigned int index;
+    char *memory;
+    
+    index = find_size_class(size, &class_size);
+    if (index == SLAB_NUM_CLASSES) {
+        chunk = (slab_chunk_t *) malloc (sizeof(slab_chunk_t) + size);
+        if (chunk == NULL) {
+            
+            return NULL;
+        }
+        chunk->size = sizeof(slab_chunk_t) + size;
+        chunk->prev = NULL;
+        chunk->next = pool->big_objects;
+        if (pool->big_objects) {
+            pool->big_objects->prev = chunk;
+        }
+        pool->big_objects = chunk;
+        
+        return chunk + 1;
+    }
+    
+    slab_class = &pool->classes[index];
+    if (slab_class->free_list) {
+        object = slab_class->free_list;
+        slab_class->free_list = object->next;
+        
+        return object;
+    }
+    if (slab_class->next_object + class_size > slab_class->chunk_end &&
+        !add_chunk(pool, slab_class, class_size)) {
+        
+        return NULL;
+    }
+    memory = slab_class->next_object;
+    slab_class->next_object += class_size;
+    
+    return memory;
+}
+
+/**
+ * @brief Free an object allocated from the pool.
+ *
+ * @param[in, out] pool The slab pool.
+ * @param[in] memory Pointer to the object.
+ * @param[in] size Size the object was allocated with.
+ */
+void free_to_slab_pool (slab_pool_t *pool, void *memory, size_t size)
+{
+    slab_free_object_t *object;
+    slab_chunk_t *chunk;
+    size_t class_size;
+    unsigned int index;
+    
+    if (memory == NULL) {
+        
+        return;
+    }
+    index = find_size_class(size, &class_size);
+    if (index == SLAB_NUM_CLASSES) {
+        chunk = (slab_chunk_t *) memory - 1;
+        if (chunk->prev) {
+            chunk->prev->next = chunk->next;
+        } else {
+            pool->big_objects = chunk->next;
+        }
+        if (chunk->next) {
+            chunk->next->prev = chunk->prev;
+        }
+        free(chunk);
+        
+        return;
+    }
+    object = (slab_free_object_t *) memory;
+    object->next = pool->classes[index].free_list;
+    pool->classes[index].free_list = object;
+}
+
+/**
+ * @brief Free everything allocated from the pool at once. The pool can be
+ *        used again afterwards.
+ *
+ * @param[in, out] pool The slab pool.
+ */
+void release_slab_pool (slab_pool_t *pool)
+{
+    slab_chunk_t *chunk, *temp;
+    
+    if (pool == NULL) {
+        
+        return;
+    }
+    for (chunk = pool->chunks; chunk; chunk = temp) {
+        temp = chunk->next;
+        free(chunk);
+    }
+    for (chunk = pool->big_objects; chunk; chunk = temp) {
+        temp = chunk->next;
+        free(chunk);
+    }
+    for (chunk = pool->spare; chunk; chunk = temp) {
+        temp = chunk->next;
+        free(chunk);
+    }
+    memset(pool, 0, sizeof(slab_pool_t));
+}
+
+/**
+ * @brief Forget everything allocated from the pool at once, keeping the
+ *        chunks for the objects allocated next.
+ *
+ * @param[in, out] pool The slab pool.
+ */
+void reset_slab_pool (slab_pool_t *pool)
+{
+    slab_chunk_t *chunk, *temp;
+    
+    if (pool == NULL) {
+        
+        return;
+    }
+    for (chunk = pool->big_objects; chunk; chunk = temp) {
+        temp = chunk->next;
+        free(chunk);
+    }
+    for (chunk = pool->chunks; chunk; chunk = temp) {
+        temp = chunk->next;
+        chunk->next = pool->spare;
+        pool->spare = chunk;
+    }
+    memset(pool->classes, 0, sizeof(pool->classes));
+    pool->chunks = NULL;
+    pool->big_objects = NULL;
+}
+
+/**
+ * @brief Destroy the slab pool, freeing everything allocated from it.
+ *
+ * @param[in, out] pool Pointer to the slab pool.
+ */
+void destroy_slab_pool (slab_pool_t *pool)
+{
+    release_slab_pool(pool);
+    free(pool);
+}
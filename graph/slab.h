@@ -0,0 +1,27 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file slab.h
+ * @author Ashutosh Grewal
+ * @date 02/04/17.
+ *
+ * @brief This header file contains APIs to use the slab pool and some public
+ *        structure declarations (the definitions of these structures is not
+ *        visible to the rest of the system to prevent them from manipulating
+ *        without using APIs).
+ */
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+#include "public.h"
+
+typedef struct slab_pool_s slab_pool_t;
+
+slab_pool_t *create_slab_pool (void);
+void *allocate_from_slab_pool (slab_pool_t *, size_t);
+void free_to_slab_pool (slab_pool_t *, void *, size_t);
+void release_slab_pool (slab_pool_t *);
+void reset_slab_pool (slab_pool_t *);
+void destroy_slab_pool (slab_pool_t *);
+
+#endif /* SLAB_H */
@@ -0,0 +1,579 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file snapshot.c
+ * @author Ashutosh Grewal
+ * @date 04/05/17
+ *
+ * @brief This file implements the published versions of a graph, which
+ *        readers walk without taking the graph's lock.
+ *
+ * @details
+ * A writer changes the graph under its lock as usual and publishes a new
+ * version once the graph is in a state worth reading, say after a batch of
+ * changes. Readers pick up the current version and walk it for as long as
+ * they like while the writer goes on changing the graph and publishing newer
+ * versions, so a batch never stalls them and they never see half of one.
+ *
+ * A version numbers the vertices by their ids in the graph and lays them out
+ * in chunks of SNAPSHOT_CHUNK_SIZE vertices, each chunk like a small CSR
+ * snapshot. The graph marks the chunk of every vertex whose edges it changes,
+ * so publishing copies only the marked chunks and shares the rest with the
+ * version before. Deleting a vertex moves the last vertex to its id, which
+ * changes the chunks of the vertices with edges into it too. A directed graph
+ * that doesn't keep the edges into its vertices can't tell which ones those
+ * are and copies every chunk the next time.
+ *
+ * Versions are counted by the readers holding them, but a reader can't take
+ * a count on the current version and know it still exists in one step. Picking
+ * one up is done inside an epoch instead: the reader announces the epoch it
+ * saw in a slot, loads the current version, counts itself and leaves its
+ * slot. A version retired in some epoch can only have been loaded by readers
+ * that announced an earlier one, so it is freed once no slot holds an earlier
+ * epoch and no reader holds the version. That is checked every time a
+ * version is published and every time the last reader of a retired version
+ * releases it.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sched.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "graph_private.h"
+#include "adjacency.h"
+#include "snapshot.h"
+#include "snapshot_private.h"
+
+/**
+ * @brief Create the published versions of a graph, with none published yet.
+ *
+ * @return Pointer to the versions if successful, NULL if memory allocation
+ *         failed.
+ */
+static snapshot_state_t *create_snapshot_state (void)
+{
+    snapshot_state_t *state;
+    
+    state = (snapshot_state_t *) calloc (1, sizeof(snapshot_state_t));
+    if (state == NULL) {
+        
+        return NULL;
+    }
+    if (pthread_mutex_init(&state->lock, NULL) != 0) {
+        free(state);
+        
+        return NULL;
+    }
+    state->epoch = 1;
+    
+    return state;
+}
+
+/**
+ * @brief Copy the vertices of a chunk out of the graph, the caller must hold
+ *        the graph's lock.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[in] first Id of the first vertex of the chunk.
+ * @param[in] num_vertices Number of vertices in the chunk.
+ *
+ * @return Pointer to the chunk if successful, NULL if memory allocation
+ *         failed.
+ */
+static snapshot_chunk_t *build_chunk (graph_t *graph, unsigned int first,
+                                      unsigned int num_vertices)
+{
+    snapshot_chunk_t *chunk;
+    vertex_t *vertex;
+    unsigned int num_entries = 0;
+    
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        num_entries += get_adjacent_count(graph->vertices[first + i]);
+    }
+    chunk = (snapshot_chunk_t *) malloc (sizeof(snapshot_chunk_t) +
+                                         sizeof(unsigned int) * num_entries);
+    if (chunk == NULL) {
+        
+        return NULL;
+    }
+    chunk->refs = 1;
+    chunk->num_vertices = num_vertices;
+    num_entries = 0;
+    for (unsigned int i = 0; i < num_vertices; i++) {
+        vertex = graph->vertices[first + i];
+        chunk->data[i] = vertex->data;
+        chunk->offsets[i] = num_entries;
+        for (unsigned int j = 0; j < get_adjacent_count(vertex); j++) {
+            chunk->neighbors[num_entries++] = get_adjacent_vertex(vertex, j)->id;
+        }
+    }
+    chunk->offsets[num_vertices] = num_entries;
+    
+    return chunk;
+}
+
+/**
+ * @brief Drop a version's hold on its chunks and free it, the caller must
+ *        hold the versions' lock.
+ *
+ * @param[in, out] snapshot The version.
+ */
+static void free_snapshot (graph_snapshot_t *snapshot)
+{
+    for (unsigned int i = 0; i < snapshot->num_chunks; i++) {
+        if (snapshot->chunks[i] != NULL && --snapshot->chunks[i]->refs == 0) {
+            free(snapshot->chunks[i]);
+        }
+    }
+    free(snapshot);
+}
+
+/**
+ * @brief Tell whether a chunk of the current version can be shared by the
+ *        next one.
+ *
+ * @param[in] state The published versions.
+ * @param[in] chunk Number of the chunk.
+ * @param[in] num_vertices Number of vertices the chunk has in the graph now.
+ *
+ * @return TRUE if nothing in the chunk changed, FALSE otherwise.
+ */
+static boolean chunk_is_clean (snapshot_state_t *state, unsigned int chunk,
+                               unsigned int num_vertices)
+{
+    graph_snapshot_t *current = state->current;
+    
+    if (current == NULL || state->all_dirty || chunk >= state->num_dirty_chunks ||
+        chunk >= current->num_chunks ||
+        current->chunks[chunk]->num_vertices != num_vertices) {
+        
+        return FALSE;
+    }
+    
+    return !(state->dirty[chunk / SNAPSHOT_BITS_PER_WORD] &
+             (1UL << (chunk % SNAPSHOT_BITS_PER_WORD)));
+}
+
+/**
+ * @brief Free the retired versions no reader can reach any more, the caller
+ *        must hold the versions' lock.
+ *
+ * @param[in, out] state The published versions.
+ */
+static void reclaim_snapshots (snapshot_state_t *state)
+{
+    graph_snapshot_t **link, *snapshot;
+    unsigned long oldest = ULONG_MAX, epoch;
+    
+    for (unsigned int i = 0; i < SNAPSHOT_READER_SLOTS; i++) {
+        epoch = __atomic_load_n(&state->readers[i], __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    link = &state->retired;
+    while (*link != NULL) {
+        snapshot = *link;
+        if (snapshot->epoch <= oldest &&
+            __atomic_load_n(&snapshot->refs, __ATOMIC_ACQUIRE) == 0) {
+            *link = snapshot->next;
+            free_snapshot(snapshot);
+        } else {
+            link = &snapshot->next;
+        }
+    }
+}
+
+/**
+ * @brief Publish the graph as it is now as the version readers pick up.
+ *
+ * @details
+ * The chunks nothing changed in are shared with the version before, so
+ * publishing after a few changes copies a few chunks. The first version
+ * copies the whole graph, and until then the graph doesn't keep track of
+ * what changes. Publishing waits for the changes being made to the graph to
+ * finish but doesn't keep readers of the graph or of the versions waiting.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed, in which
+ *         case the current version stays.
+ */
+boolean graph_snapshot_publish (graph_t *graph)
+{
+    snapshot_state_t *state, *expected = NULL;
+    graph_snapshot_t *snapshot = NULL, *old;
+    unsigned int num_chunks, num_vertices, remaining;
+    unsigned long *dirty;
+    boolean published = FALSE;
+    
+    state = __atomic_load_n(&graph->snapshots, __ATOMIC_ACQUIRE);
+    if (state == NULL) {
+        state = create_snapshot_state();
+        if (state == NULL) {
+            
+            return FALSE;
+        }
+        if (!__atomic_compare_exchange_n(&graph->snapshots, &expected, state,
+                                         FALSE, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE)) {
+            pthread_mutex_destroy(&state->lock);
+            free(state);
+            state = expected;
+        }
+    }
+    
+    /*
+     * Holding the graph's lock for reading keeps writers from marking chunks
+     * while we copy them.
+     */
+    pthread_rwlock_rdlock(&graph->lock);
+    pthread_mutex_lock(&state->lock);
+    num_chunks = (graph->num_vertices + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE;
+    snapshot = (graph_snapshot_t *) calloc (1, sizeof(graph_snapshot_t) +
+                                               sizeof(snapshot_chunk_t *) * num_chunks);
+    dirty = (unsigned long *) calloc (num_chunks / SNAPSHOT_BITS_PER_WORD + 1,
+                                      sizeof(unsigned long));
+    if (snapshot == NULL || dirty == NULL) {
+        free(dirty);
+        goto done;
+    }
+    snapshot->state = state;
+    snapshot->refs = 1;
+    snapshot->data_is_equal = graph->data_is_equal;
+    snapshot->start = graph->vertex ? graph->vertex->id : UINT_MAX;
+    snapshot->num_vertices = graph->num_vertices;
+    snapshot->num_chunks = num_chunks;
+    for (unsigned int i = 0; i < num_chunks; i++) {
+        remaining = graph->num_vertices - i * SNAPSHOT_CHUNK_SIZE;
+        num_vertices = remaining < SNAPSHOT_CHUNK_SIZE ? remaining : SNAPSHOT_CHUNK_SIZE;
+        if (chunk_is_clean(state, i, num_vertices)) {
+            snapshot->chunks[i] = state->current->chunks[i];
+            snapshot->chunks[i]->refs++;
+            continue;
+        }
+        snapshot->chunks[i] = build_chunk(graph, i * SNAPSHOT_CHUNK_SIZE,
+                                          num_vertices);
+        if (snapshot->chunks[i] == NULL) {
+            free(dirty);
+            goto done;
+        }
+    }
+    
+    /*
+     * Readers loading the current version after the epoch moves on get the
+     * new one, so the old one waits for the readers from before.
+     */
+    old = state->current;
+    __atomic_store_n(&state->current, snapshot, __ATOMIC_SEQ_CST);
+    snapshot = NULL;
+    if (old != NULL) {
+        old->epoch = __atomic_add_fetch(&state->epoch, 1, __ATOMIC_SEQ_CST);
+        old->next = state->retired;
+        state->retired = old;
+        __atomic_sub_fetch(&old->refs, 1, __ATOMIC_ACQ_REL);
+    }
+    free(state->dirty);
+    state->dirty = dirty;
+    state->num_dirty_chunks = num_chunks;
+    state->all_dirty = FALSE;
+    reclaim_snapshots(state);
+    published = TRUE;
+
+done:
+    if (snapshot != NULL) {
+        free_snapshot(snapshot);
+    }
+    pthread_mutex_unlock(&state->lock);
+    pthread_rwlock_unlock(&graph->lock);
+    
+    return published;
+}
+
+/**
+ * @brief Pick up the current version of the graph, which stays as it is till
+ *        it's released.
+ *
+ * @details
+ * This takes neither the graph's lock nor the one publishing takes, so it
+ * never waits for a writer.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ *
+ * @return The version, NULL if none was published yet.
+ */
+graph_snapshot_t *graph_snapshot_acquire (graph_t *graph)
+{
+    snapshot_state_t *state;
+    graph_snapshot_t *snapshot;
+    unsigned long epoch, expected;
+    unsigned int slot;
+    
+    state = __atomic_load_n(&graph->snapshots, __ATOMIC_ACQUIRE);
+    if (state == NULL) {
+        
+        return NULL;
+    }
+    
+    /*
+     * Threads start looking for a free slot at different places, so they
+     * rarely fight over one.
+     */
+    slot = (unsigned int) (((uintptr_t) pthread_self() >> 4) % SNAPSHOT_READER_SLOTS);
+    epoch = __atomic_load_n(&state->epoch, __ATOMIC_SEQ_CST);
+    for (;;) {
+        expected = 0;
+        if (__atomic_compare_exchange_n(&state->readers[slot], &expected, epoch,
+                                        FALSE, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_RELAXED)) {
+            break;
+        }
+        slot = (slot + 1) % SNAPSHOT_READER_SLOTS;
+        if (slot == 0) {
+            sched_yield();
+        }
+    }
+    snapshot = __atomic_load_n(&state->current, __ATOMIC_SEQ_CST);
+    if (snapshot != NULL) {
+        __atomic_add_fetch(&snapshot->refs, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&state->readers[slot], 0, __ATOMIC_RELEASE);
+    
+    return snapshot;
+}
+
+/**
+ * @brief Release a version picked up with graph_snapshot_acquire.
+ *
+ * @details
+ * The last reader of a version that was replaced frees it, along with the
+ * chunks no other version shares.
+ *
+ * @param[in, out] snapshot The version, NULL does nothing.
+ */
+void graph_snapshot_release (graph_snapshot_t *snapshot)
+{
+    snapshot_state_t *state;
+    
+    if (snapshot == NULL) {
+        
+        return;
+    }
+    state = snapshot->state;
+    if (__atomic_sub_fetch(&snapshot->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&state->lock);
+        reclaim_snapshots(state);
+        pthread_mutex_unlock(&state->lock);
+    }
+}
+
+/**
+ * @brief Return the number of vertices in a version.
+ *
+ * @param[in] snapshot The version.
+ *
+ * @return Number of vertices, numbered by their ids in the graph at the time.
+ */
+unsigned int graph_snapshot_num_vertices (graph_snapshot_t *snapshot)
+{
+    return snapshot->num_vertices;
+}
+
+/**
+ * @brief Return the data stored at a vertex of a version.
+ *
+ * @param[in] snapshot The version.
+ * @param[in] vertex Number of the vertex.
+ *
+ * @return The opaque data, NULL if there is no such vertex.
+ */
+void *graph_snapshot_get_data (graph_snapshot_t *snapshot, unsigned int vertex)
+{
+    if (vertex >= snapshot->num_vertices) {
+        
+        return NULL;
+    }
+    
+    return snapshot->chunks[vertex / SNAPSHOT_CHUNK_SIZE]->data[vertex % SNAPSHOT_CHUNK_SIZE];
+}
+
+/**
+ * @brief Return the adjacent vertices of a vertex of a version as one array.
+ *
+ * @details
+ * They come in the order the graph's traversals follow them. In a directed
+ * graph these are the vertices the edges out of the vertex go to. The array
+ * lives as long as the version is held.
+ *
+ * @param[in] snapshot The version.
+ * @param[in] vertex Number of the vertex.
+ * @param[out] begin Numbers of the adjacent vertices.
+ * @param[out] count Number of adjacent vertices.
+ *
+ * @return TRUE if successful, FALSE if there is no such vertex.
+ */
+boolean graph_snapshot_neighbors (graph_snapshot_t *snapshot, unsigned int vertex,
+                                  const unsigned int **begin, unsigned int *count)
+{
+    snapshot_chunk_t *chunk;
+    unsigned int i;
+    
+    if (vertex >= snapshot->num_vertices) {
+        
+        return FALSE;
+    }
+    chunk = snapshot->chunks[vertex / SNAPSHOT_CHUNK_SIZE];
+    i = vertex % SNAPSHOT_CHUNK_SIZE;
+    *begin = chunk->neighbors + chunk->offsets[i];
+    *count = chunk->offsets[i + 1] - chunk->offsets[i];
+    
+    return TRUE;
+}
+
+/**
+ * @brief Find the vertex containing the given data in a version, whether it
+ *        can be reached or not.
+ *
+ * @param[in] snapshot The version.
+ * @param[in] data Opaque data for which we need to search.
+ * @param[out] vertex Number of the vertex containing the data.
+ *
+ * @return TRUE if a vertex contains the data, FALSE otherwise.
+ */
+boolean graph_snapshot_find (graph_snapshot_t *snapshot, void *data,
+                             unsigned int *vertex)
+{
+    for (unsigned int i = 0; i < snapshot->num_vertices; i++) {
+        if (snapshot->data_is_equal(data, graph_snapshot_get_data(snapshot, i))) {
+            *vertex = i;
+            
+            return TRUE;
+        }
+    }
+    
+    return FALSE;
+}
+
+/**
+ * @brief Find a vertex with the given data in a version traversing in a
+ *        breadth first fashion from the graph's vertex.
+ *
+ * @param[in] snapshot The version.
+ * @param[in] data Opaque data for which we need to search.
+ * @param[out] vertex Number of the vertex containing the data.
+ *
+ * @return TRUE if the data was found, FALSE otherwise or if memory allocation
+ *         failed.
+ */
+boolean graph_snapshot_breadth_first_search (graph_snapshot_t *snapshot,
+                                             void *data, unsigned int *vertex)
+{
+    unsigned int *frontier, head, tail, current, count;
+    const unsigned int *neighbors;
+    unsigned long *visited;
+    boolean found = FALSE;
+    
+    if (snapshot->start == UINT_MAX) {
+        
+        return FALSE;
+    }
+    frontier = (unsigned int *) malloc (sizeof(unsigned int) * snapshot->num_vertices);
+    visited = (unsigned long *) calloc (snapshot->num_vertices / SNAPSHOT_BITS_PER_WORD + 1,
+                                        sizeof(unsigned long));
+    if (frontier == NULL || visited == NULL) {
+        goto done;
+    }
+    
+    head = tail = 0;
+    frontier[tail++] = snapshot->start;
+    visited[snapshot->start / SNAPSHOT_BITS_PER_WORD] |=
+        1UL << (snapshot->start % SNAPSHOT_BITS_PER_WORD);
+    while (head < tail) {
+        current = frontier[head++];
+        if (snapshot->data_is_equal(data, graph_snapshot_get_data(snapshot, current))) {
+            *vertex = current;
+            found = TRUE;
+            break;
+        }
+        if (!graph_snapshot_neighbors(snapshot, current, &neighbors, &count)) {
+            continue;
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            if (visited[neighbors[i] / SNAPSHOT_BITS_PER_WORD] &
+                (1UL << (neighbors[i] % SNAPSHOT_BITS_PER_WORD))) {
+                continue;
+            }
+            visited[neighbors[i] / SNAPSHOT_BITS_PER_WORD] |=
+                1UL << (neighbors[i] % SNAPSHOT_BITS_PER_WORD);
+            frontier[tail++] = neighbors[i];
+        }
+    }
+
+done:
+    free(frontier);
+    free(visited);
+    
+    return found;
+}
+
+/**
+ * @brief Note that a vertex moved to a new id, the caller must hold the
+ *        graph's lock for writing.
+ *
+ * @details
+ * The vertex has already taken its new id. Besides its own chunk, the chunks
+ * of the vertices with edges into it hold its old id.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex The vertex.
+ */
+void mark_snapshot_moved (graph_t *graph, vertex_t *vertex)
+{
+    if (graph->snapshots == NULL) {
+        
+        return;
+    }
+    mark_snapshot_vertex(graph, vertex);
+    if (graph->mode == GRAPH_UNDIRECTED) {
+        for (unsigned int i = 0; i < get_adjacent_count(vertex); i++) {
+            mark_snapshot_vertex(graph, get_adjacent_vertex(vertex, i));
+        }
+    } else if (graph->mode == GRAPH_DIRECTED_IN_EDGES) {
+        for (unsigned int i = 0; i < get_in_count(vertex); i++) {
+            mark_snapshot_vertex(graph, get_in_vertex(vertex, i));
+        }
+    } else {
+        graph->snapshots->all_dirty = TRUE;
+    }
+}
+
+/**
+ * @brief Free all the versions of the graph, which no reader may hold any
+ *        more.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ */
+void destroy_snapshots (graph_t *graph)
+{
+    snapshot_state_t *state = graph->snapshots;
+    graph_snapshot_t *snapshot;
+    
+    if (state == NULL) {
+        
+        return;
+    }
+    while (state->retired != NULL) {
+        snapshot = state->retired;
+        state->retired = snapshot->next;
+        free_snapshot(snapshot);
+    }
+    if (state->current != NULL) {
+        free_snapshot(state->current);
+    }
+    free(state->dirty);
+    pthread_mutex_destroy(&state->lock);
+    free(state);
+    graph->snapshots = NULL;
+}
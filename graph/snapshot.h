@@ -0,0 +1,32 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file snapshot.h
+ * @author Ashutosh Grewal
+ * @date 04/05/17.
+ *
+ * @brief Header file containing APIs to the published versions of a graph,
+ *        which readers walk without taking the graph's lock, and some public
+ *        structure declarations (the definitions of these structures is not
+ *        visible to the rest of the system to prevent them from manipulating
+ *        without using APIs).
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "public.h"
+#include "graph.h"
+
+typedef struct graph_snapshot_s graph_snapshot_t;
+
+boolean graph_snapshot_publish (graph_t *);
+graph_snapshot_t *graph_snapshot_acquire (graph_t *);
+void graph_snapshot_release (graph_snapshot_t *);
+unsigned int graph_snapshot_num_vertices (graph_snapshot_t *);
+void *graph_snapshot_get_data (graph_snapshot_t *, unsigned int);
+boolean graph_snapshot_neighbors (graph_snapshot_t *, unsigned int,
+                                  const unsigned int **, unsigned int *);
+boolean graph_snapshot_find (graph_snapshot_t *, void *, unsigned int *);
+boolean graph_snapshot_breadth_first_search (graph_snapshot_t *, void *,
+                                             unsigned int *);
+
+#endif /* SNAPSHOT_H */
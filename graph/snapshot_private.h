@@ -0,0 +1,114 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file snapshot_private.h
+ * @author Ashutosh Grewal
+ * @date 04/05/17.
+ *
+ * @brief Private definition of the published versions of a graph, shared by
+ *        the graph, which marks what it changes, and the snapshots. This
+ *        separate header file is made as we do not want these definitions
+ *        made visible to the rest of the system.
+ */
+#ifndef SNAPSHOT_PRIVATE_H
+#define SNAPSHOT_PRIVATE_H
+
+#include <limits.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "graph_private.h"
+#include "snapshot.h"
+
+/**
+ * @brief Number of vertices in a chunk of a version.
+ */
+#define SNAPSHOT_CHUNK_SIZE 256
+
+/**
+ * @brief Number of readers that can be picking up a version at once.
+ */
+#define SNAPSHOT_READER_SLOTS 64
+
+#define SNAPSHOT_BITS_PER_WORD (sizeof(unsigned long) * CHAR_BIT)
+
+/**
+ * @brief The vertices of a version with ids from one multiple of
+ *        SNAPSHOT_CHUNK_SIZE to the next, laid out like a CSR snapshot.
+ *
+ * @details
+ * A chunk nothing changed in since the last version is shared by the next
+ * one instead of being copied again.
+ */
+typedef struct snapshot_chunk_s {
+    unsigned int refs; /**< Number of versions sharing the chunk. */
+    unsigned int num_vertices; /**< Number of vertices in the chunk. */
+    void *data[SNAPSHOT_CHUNK_SIZE]; /**< The data stored at each vertex. */
+    unsigned int offsets[SNAPSHOT_CHUNK_SIZE + 1]; /**< Start of each
+                                                        vertex's neighbors. */
+    unsigned int neighbors[]; /**< Ids of the adjacent vertices of all the
+                                   vertices in the chunk. */
+} snapshot_chunk_t;
+
+/**
+ * @brief An immutable version of the graph.
+ */
+struct graph_snapshot_s {
+    snapshot_state_t *state; /**< The versions this one belongs to. */
+    unsigned int refs; /**< Readers holding the version, plus one while it's
+                            the current one. */
+    unsigned long epoch; /**< Epoch it was retired in, 0 while current. */
+    graph_snapshot_t *next; /**< Next retired version. */
+    data_is_equal_t data_is_equal; /**< Function pointer to compare the data. */
+    unsigned int start; /**< Id of the graph's vertex, UINT_MAX if the graph
+                             was empty. */
+    unsigned int num_vertices; /**< Number of vertices. */
+    unsigned int num_chunks; /**< Number of chunks. */
+    snapshot_chunk_t *chunks[]; /**< The chunks, in order of vertex ids. */
+};
+
+/**
+ * @brief The published versions of a graph.
+ */
+struct snapshot_state_s {
+    graph_snapshot_t *current; /**< The version readers pick up. */
+    graph_snapshot_t *retired; /**< Versions replaced but maybe still read. */
+    unsigned long epoch; /**< Bumped every time a version is retired. */
+    unsigned long readers[SNAPSHOT_READER_SLOTS]; /**< Epoch each reader
+                                                       picking up a version
+                                                       saw, 0 for a free
+                                                       slot. */
+    unsigned long *dirty; /**< Chunks of the current version changed since
+                               it was published. */
+    unsigned int num_dirty_chunks; /**< Number of chunks dirty has bits for,
+                                        chunks past those are new. */
+    boolean all_dirty; /**< TRUE if any chunk may have changed. */
+    pthread_mutex_t lock; /**< Serializes publishing and reclaiming. */
+};
+
+void mark_snapshot_moved (graph_t *, vertex_t *);
+void destroy_snapshots (graph_t *);
+
+/**
+ * @brief Note that the vertex with this id or its edges out changed, the
+ *        caller must hold the graph's lock for writing.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] vertex The vertex.
+ */
+static inline void mark_snapshot_vertex (graph_t *graph, vertex_t *vertex)
+{
+    snapshot_state_t *state = graph->snapshots;
+    unsigned int chunk;
+    
+    if (state == NULL) {
+        
+        return;
+    }
+    chunk = vertex->id / SNAPSHOT_CHUNK_SIZE;
+    if (chunk < state->num_dirty_chunks) {
+        state->dirty[chunk / SNAPSHOT_BITS_PER_WORD] |=
+            1UL << (chunk % SNAPSHOT_BITS_PER_WORD);
+    }
+}
+
+#endif /* SNAPSHOT_PRIVATE_H */
@@ -11,22 +11,30 @@
  * pushed to the front and all deletions happen at the front. This can be 
  * visualized as a stack of dishes being kept on top of each other and then being
  * picked back for washing. The last one put is the one picked up first.
- * This is implemented as a structure of nodes where we track the top of the 
- * list and each node is linked to the next via a pointer.
+ * This is implemented as an array of elements where we track the number of
+ * elements, the top of the stack being the last one. When the array fills up,
+ * it is doubled in size, so pushing and popping don't allocate memory in the
+ * common case. A stack can be emptied with reset_stack and used again, keeping
+ * the array it has grown to.
  * 
  * @bug No bugs are know at this point.
  */
-#include "list_private.h"
-#include "list.h"
 #include "stack.h"
 #include <stdlib.h>
 #include <string.h>
 
+#define STACK_DEFAULT_CAPACITY 16
+
 /**
  * @brief The stack data structure.
  */
 struct stack_s {
-    node_t *top;      /**< Pointer to the top element of the stack. */
+    void **elements; /**< Array of the opaque data stored, bottom first. */
+    unsigned int capacity; /**< Number of elements the array has room for. */
+    unsigned int count; /**< Number of elements in the stack. */
+#ifdef GRAPH_ENABLE_STATS
+    unsigned int high_water; /**< Most elements the stack has held. */
+#endif
 };
 
 /**
@@ -36,13 +44,43 @@ struct stack_s {
  *         if allocation failed.
  */
 stack_type *create_stack (void)
+{
+    return create_stack_with_capacity(STACK_DEFAULT_CAPACITY);
+}
+
+/**
+ * @brief Create and intialize the stack data structure with room for the given
+ *        number of elements.
+ *
+ * @param[in] capacity Number of elements the stack is expected to hold, the
+ *                     stack still grows beyond it if needed.
+ *
+ * @return Pointer to the stack data structure if allocation was successful, NULL
+ *         if allocation failed.
+ */
+stack_type *create_stack_with_capacity (unsigned int capacity)
 {
     stack_type *stack;
     
+    if (capacity == 0) {
+        capacity = STACK_DEFAULT_CAPACITY;
+    }
     stack = (stack_type *) malloc (sizeof(stack_type));
-    if (stack != NULL) {
-        stack->top = NULL;
+    if (stack == NULL) {
+        
+        return NULL;
+    }
+    stack->elements = (void **) malloc (sizeof(void *) * capacity);
+    if (stack->elements == NULL) {
+        free(stack);
+        
+        return NULL;
     }
+    stack->capacity = capacity;
+    stack->count = 0;
+#ifdef GRAPH_ENABLE_STATS
+    stack->high_water = 0;
+#endif
     
     return stack;
 }
@@ -57,22 +95,30 @@ stack_type *create_stack (void)
  */
 boolean push_to_stack (stack_type *stack, void *data)
 {
-    node_t *node;
+    void **elements;
     
     if (stack == NULL) {
         return FALSE;
     }
     
-    node = (node_t *) malloc (sizeof(node_t));
-    if (node != NULL) {
-        node->data = data;
-        node->next = stack->top;
-        stack->top = node;
-        
-        return TRUE;
+    if (stack->count == stack->capacity) {
+        elements = (void **) realloc (stack->elements,
+                                      sizeof(void *) * stack->capacity * 2);
+        if (elements == NULL) {
+            
+            return FALSE;
+        }
+        stack->elements = elements;
+        stack->capacity *= 2;
     }
+    stack->elements[stack->count++] = data;
+#ifdef GRAPH_ENABLE_STATS
+    if (stack->count > stack->high_water) {
+        stack->high_water = stack->count;
+    }
+#endif
     
-    return FALSE;
+    return TRUE;
 }
 
 /**
@@ -85,25 +131,47 @@ boolean push_to_stack (stack_type *stack, void *data)
  */
 void *pop_from_stack (stack_type *stack)
 {
-    node_t *node;
-    void *data;
-    
     if (stack == NULL) {
         return NULL;
     }
     
-    if (stack->top != NULL) {
-        node = stack->top;
-        data = node->data;
-        stack->top = node->next;
-        free(node);
+    if (stack->count > 0) {
         
-        return data;
+        return stack->elements[--stack->count];
     }
     
     return NULL;
 }
 
+#ifdef GRAPH_ENABLE_STATS
+/**
+ * @brief Return the most elements the stack has held since it was created.
+ *
+ * @param[in] stack Pointer to the stack data structure.
+ *
+ * @return The high water mark of the stack.
+ */
+unsigned int get_stack_high_water (stack_type *stack)
+{
+    return stack->high_water;
+}
+#endif
+
+/**
+ * @brief Remove all the elements from the stack, keeping its room for the
+ *        next use.
+ *
+ * @param[in, out] stack Pointer to the stack data structure.
+ */
+void reset_stack (stack_type *stack)
+{
+    if (stack == NULL) {
+        
+        return;
+    }
+    stack->count = 0;
+}
+
 /**
  * @brief Destory the stack data structure, freeing all it's elements in the
  *        process.
@@ -112,18 +180,10 @@ void *pop_from_stack (stack_type *stack)
  */
 void destroy_stack (stack_type *stack)
 {
-    node_t *node, *temp;
-    
     if (stack == NULL) {
         
         return;
     }
-    node = stack->top;
-    while (node) {
-        temp = node;
-        node = node->next;
-        free(temp);
-    }
-    stack->top = NULL;
+    free(stack->elements);
     free(stack);
 }
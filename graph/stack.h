@@ -17,8 +17,13 @@
 typedef struct stack_s stack_type;
 
 stack_type *create_stack (void);
+stack_type *create_stack_with_capacity (unsigned int);
 boolean push_to_stack (stack_type *, void *);
 void *pop_from_stack (stack_type *);
+void reset_stack (stack_type *);
+#ifdef GRAPH_ENABLE_STATS
+unsigned int get_stack_high_water (stack_type *);
+#endif
 void destroy_stack (stack_type *);
 
 #endif /* STACK_H */
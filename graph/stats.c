@@ -0,0 +1,138 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file stats.c
+ * @author Ashutosh Grewal
+ * @date 03/29/17
+ *
+ * @brief This file implements the stats the graph keeps about its API calls.
+ *
+ * @details
+ * Building with GRAPH_ENABLE_STATS defined makes every graph count the calls
+ * to its APIs, the time spent in them and the allocations they make, along
+ * with the vertices and edges its searches and traversals visit, the lookups
+ * made by find_in_graph or while changing it and the most vertices the
+ * frontier of a walk held.
+ * Readers update the stats side by side, so they are kept with relaxed
+ * atomics and a copy taken while the graph is in use may mix the stats from
+ * before and after a call. Without GRAPH_ENABLE_STATS nothing is kept. The
+ * graph still has room for the stats, left zeroed, so code built with and
+ * without the flag agrees on the layout of graph_t.
+ */
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "public.h"
+#include "graph.h"
+#include "allocator.h"
+#include "stats.h"
+
+#ifdef GRAPH_ENABLE_STATS
+
+/**
+ * @brief Return the time in nanoseconds from some fixed point.
+ *
+ * @return The time.
+ */
+static uint64_t now_in_nanoseconds (void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * @brief Note where an API call started.
+ *
+ * @param[out] timer The timer of the call.
+ */
+void begin_op_timer (op_timer_t *timer)
+{
+    get_thread_allocations(&timer->allocations, &timer->bytes);
+    timer->start = now_in_nanoseconds();
+}
+
+/**
+ * @brief Add what an API call did to the stats of the graph.
+ *
+ * @details
+ * The allocations counted are the ones the calling thread made since the
+ * call started, so they belong to the call even while other threads use the
+ * graph.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ * @param[in] op The kind of API call.
+ * @param[in] timer The timer of the call.
+ */
+void end_op_timer (graph_t *graph, graph_op_t op, op_timer_t *timer)
+{
+    graph_op_stats_t *stats = &graph->stats.ops[op];
+    unsigned long allocations;
+    unsigned long long bytes;
+    uint64_t end;
+    
+    end = now_in_nanoseconds();
+    get_thread_allocations(&allocations, &bytes);
+    __atomic_fetch_add(&stats->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->nanoseconds, end - timer->start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->allocations, allocations - timer->allocations,
+                       __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->bytes, bytes - timer->bytes, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Raise a high water mark to a value if it's lower.
+ *
+ * @param[in, out] mark The high water mark.
+ * @param[in] value The value.
+ */
+void raise_high_water (unsigned long *mark, unsigned long value)
+{
+    unsigned long current;
+    
+    current = __atomic_load_n(mark, __ATOMIC_RELAXED);
+    while (current < value &&
+           !__atomic_compare_exchange_n(mark, &current, value, FALSE,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+#endif /* GRAPH_ENABLE_STATS */
+
+/**
+ * @brief Copy the stats of the graph.
+ *
+ * @param[in] graph Pointer to the graph data structure.
+ * @param[out] stats The stats, all 0 if they aren't kept.
+ *
+ * @return TRUE if the library was built with GRAPH_ENABLE_STATS, FALSE
+ *         otherwise.
+ */
+boolean graph_get_stats (graph_t *graph, graph_stats_t *stats)
+{
+#ifdef GRAPH_ENABLE_STATS
+    pthread_rwlock_rdlock(&graph->lock);
+    memcpy(stats, &graph->stats, sizeof(graph_stats_t));
+    pthread_rwlock_unlock(&graph->lock);
+    
+    return TRUE;
+#else
+    memset(stats, 0, sizeof(graph_stats_t));
+    
+    return FALSE;
+#endif
+}
+
+/**
+ * @brief Set all the stats of the graph back to 0.
+ *
+ * @param[in, out] graph Pointer to the graph data structure.
+ */
+void graph_reset_stats (graph_t *graph)
+{
+#ifdef GRAPH_ENABLE_STATS
+    pthread_rwlock_wrlock(&graph->lock);
+    memset(&graph->stats, 0, sizeof(graph_stats_t));
+    pthread_rwlock_unlock(&graph->lock);
+#endif
+}
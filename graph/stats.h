@@ -0,0 +1,59 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file stats.h
+ * @author Ashutosh Grewal
+ * @date 03/29/17.
+ *
+ * @brief This header file contains the macros the graph's API calls keep
+ *        their stats with.
+ *
+ * @details
+ * Unless GRAPH_ENABLE_STATS is defined, every macro expands to nothing, so
+ * the stats cost neither time nor memory.
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include "public.h"
+#include "graph.h"
+
+#ifdef GRAPH_ENABLE_STATS
+
+#include <stdint.h>
+
+/**
+ * @brief Where an API call started, to find what it has done when it ends.
+ */
+typedef struct op_timer_s {
+    uint64_t start; /**< Time the call started at, in nanoseconds. */
+    unsigned long allocations; /**< Allocations made by the thread till then. */
+    unsigned long long bytes; /**< Bytes those allocations asked for. */
+} op_timer_t;
+
+void begin_op_timer (op_timer_t *);
+void end_op_timer (graph_t *, graph_op_t, op_timer_t *);
+void raise_high_water (unsigned long *, unsigned long);
+
+#define GRAPH_STATS_TIMER(timer) op_timer_t timer
+#define GRAPH_STATS_BEGIN(timer) begin_op_timer(&(timer))
+#define GRAPH_STATS_END(graph, op, timer) end_op_timer((graph), (op), &(timer))
+#define GRAPH_STATS_COUNTER(counter) unsigned long counter = 0
+#define GRAPH_STATS_COUNT(counter, n) ((counter) += (n))
+#define GRAPH_STATS_ADD(graph, field, n) \
+    __atomic_fetch_add(&(graph)->stats.field, (n), __ATOMIC_RELAXED)
+#define GRAPH_STATS_RAISE(graph, field, n) \
+    raise_high_water(&(graph)->stats.field, (n))
+
+#else
+
+#define GRAPH_STATS_TIMER(timer)
+#define GRAPH_STATS_BEGIN(timer) ((void) 0)
+#define GRAPH_STATS_END(graph, op, timer) ((void) 0)
+#define GRAPH_STATS_COUNTER(counter)
+#define GRAPH_STATS_COUNT(counter, n) ((void) 0)
+#define GRAPH_STATS_ADD(graph, field, n) ((void) 0)
+#define GRAPH_STATS_RAISE(graph, field, n) ((void) 0)
+
+#endif /* GRAPH_ENABLE_STATS */
+
+#endif /* STATS_H */
@@ -0,0 +1,223 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file traversal.c
+ * @author Ashutosh Grewal
+ * @date 01/28/17
+ *
+ * @brief This file implements the traversal context.
+ *
+ * @details
+ * A traversal context holds the visited marks and the frontier of a search or
+ * a traversal. Each thread searching a graph brings its own context, which
+ * lets them run at the same time, and reusing a context across calls avoids
+ * allocating the marks and the frontier every time.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "public.h"
+#include "traversal.h"
+#include "traversal_private.h"
+#include "queue.h"
+#include "stack.h"
+#include "heap.h"
+
+/**
+ * @brief Create and initialize the traversal context.
+ *
+ * @return Pointer to the traversal context if successful, NULL if memory
+ *         allocation failed.
+ */
+traversal_ctx_t *create_traversal_context (void)
+{
+    traversal_ctx_t *ctx;
+    
+    ctx = (traversal_ctx_t *) calloc (1, sizeof(traversal_ctx_t));
+    if (ctx == NULL) {
+        
+        return NULL;
+    }
+    ctx->queue = create_queue();
+    ctx->stack = create_stack();
+    if (ctx->queue == NULL || ctx->stack == NULL) {
+        destroy_traversal_context(ctx);
+        
+        return NULL;
+    }
+    
+    return ctx;
+}
+
+/**
+ * @brief Get the context ready for a new search or traversal.
+ *
+ * @details
+ * Moving to the next epoch marks every vertex as not visited. Once in four
+ * billion traversals the epoch wraps around, at which point the marks are
+ * cleared for real.
+ *
+ * @param[in, out] ctx The traversal context.
+ * @param[in] num_ids The number of vertex ids the traversal might mark.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean begin_context_traversal (traversal_ctx_t *ctx, unsigned int num_ids)
+{
+    unsigned int *marks, *depths, capacity;
+    void **parents;
+    
+    if (num_ids > ctx->capacity) {
+        capacity = ctx->capacity ? ctx->capacity : 64;
+        while (capacity < num_ids) {
+            capacity *= 2;
+        }
+        
+        /*
+         * Should one of these fail, the ones before it are merely larger than
+         * the capacity says, which is harmless.
+         */
+        marks = (unsigned int *) realloc (ctx->marks, sizeof(unsigned int) * capacity);
+        if (marks == NULL) {
+            
+            return FALSE;
+        }
+        ctx->marks = marks;
+        depths = (unsigned int *) realloc (ctx->depths, sizeof(unsigned int) * capacity);
+        if (depths == NULL) {
+            
+            return FALSE;
+        }
+        ctx->depths = depths;
+        parents = (void **) realloc (ctx->parents, sizeof(void *) * capacity);
+        if (parents == NULL) {
+            
+            return FALSE;
+        }
+        ctx->parents = parents;
+        memset(marks + ctx->capacity, 0,
+               sizeof(unsigned int) * (capacity - ctx->capacity));
+        ctx->capacity = capacity;
+    }
+    
+    /*
+     * Drop whatever an earlier search that stopped early left behind.
+     */
+    reset_queue(ctx->queue);
+    reset_stack(ctx->stack);
+    
+    ctx->epoch++;
+    if (ctx->epoch == 0) {
+        memset(ctx->marks, 0, sizeof(unsigned int) * ctx->capacity);
+        ctx->epoch = 1;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Get the context ready for a new shortest path search.
+ *
+ * @details
+ * On top of what begin_context_traversal does, this makes room for the
+ * distances and the heap the first time the context is used for a shortest
+ * path search, and empties the heap.
+ *
+ * @param[in, out] ctx The traversal context.
+ * @param[in] num_ids The number of vertex ids the search might mark.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean begin_context_shortest_path (traversal_ctx_t *ctx, unsigned int num_ids)
+{
+    double *distances;
+    
+    if (!begin_context_traversal(ctx, num_ids)) {
+        
+        return FALSE;
+    }
+    if (ctx->heap == NULL) {
+        ctx->heap = create_heap();
+        if (ctx->heap == NULL) {
+            
+            return FALSE;
+        }
+    }
+    if (ctx->distances_capacity < ctx->capacity) {
+        distances = (double *) realloc (ctx->distances, sizeof(double) * ctx->capacity);
+        if (distances == NULL) {
+            
+            return FALSE;
+        }
+        ctx->distances = distances;
+        ctx->distances_capacity = ctx->capacity;
+    }
+    if (!reserve_heap(ctx->heap, ctx->capacity)) {
+        
+        return FALSE;
+    }
+    reset_heap(ctx->heap);
+    
+    return TRUE;
+}
+
+/**
+ * @brief Get the context ready for a new bidirectional search.
+ *
+ * @details
+ * The search needs two epochs, one for each side: ctx->epoch - 1 marks the
+ * vertices reached from the source and ctx->epoch the vertices reached from
+ * the target. Both are newer than any mark left behind by earlier searches.
+ *
+ * @param[in, out] ctx The traversal context.
+ * @param[in] num_ids The number of vertex ids the search might mark.
+ *
+ * @return TRUE if successful, FALSE if memory allocation failed.
+ */
+boolean begin_context_bidirectional (traversal_ctx_t *ctx, unsigned int num_ids)
+{
+    if (!begin_context_traversal(ctx, num_ids)) {
+        
+        return FALSE;
+    }
+    if (ctx->reverse_queue == NULL) {
+        ctx->reverse_queue = create_queue();
+        if (ctx->reverse_queue == NULL) {
+            
+            return FALSE;
+        }
+    }
+    reset_queue(ctx->reverse_queue);
+    
+    ctx->epoch++;
+    if (ctx->epoch == 0) {
+        memset(ctx->marks, 0, sizeof(unsigned int) * ctx->capacity);
+        ctx->epoch = 2;
+    }
+    
+    return TRUE;
+}
+
+/**
+ * @brief Destroy the traversal context.
+ *
+ * @param[in, out] ctx Pointer to the traversal context.
+ */
+void destroy_traversal_context (traversal_ctx_t *ctx)
+{
+    if (ctx == NULL) {
+        
+        return;
+    }
+    if (ctx->queue) {
+        destroy_queue(ctx->queue);
+    }
+    destroy_stack(ctx->stack);
+    if (ctx->reverse_queue) {
+        destroy_queue(ctx->reverse_queue);
+    }
+    free(ctx->marks);
+    free(ctx->depths);
+    free(ctx->parents);
+    free(ctx->distances);
+    destroy_heap(ctx->heap);
+    free(ctx);
+}
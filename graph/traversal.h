@@ -0,0 +1,22 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file traversal.h
+ * @date 01/28/17
+ * @author Ashutosh Grewal
+ *
+ * @brief Header file containing APIs to the traversal context and some public
+ *        structure declarations (the definitions of these structures is not
+ *        visible to the rest of the system to prevent them from manipulating
+ *        without using APIs).
+ */
+#ifndef TRAVERSAL_H
+#define TRAVERSAL_H
+
+#include "public.h"
+
+typedef struct traversal_ctx_s traversal_ctx_t;
+
+traversal_ctx_t *create_traversal_context (void);
+void destroy_traversal_context (traversal_ctx_t *);
+
+#endif /* TRAVERSAL_H */
@@ -0,0 +1,78 @@
+/**
+ * @copyright © 2016 Ashutosh Grewal. All rights reserved.
+ * @file traversal_private.h
+ * @date 01/28/17
+ * @author Ashutosh Grewal
+ *
+ * @brief Private definition of the traversal context shared by the files that
+ *        search or traverse a graph. This separate header file is made as we
+ *        do not want these definitions made visible to the rest of the system.
+ */
+#ifndef TRAVERSAL_PRIVATE_H
+#define TRAVERSAL_PRIVATE_H
+
+#include "public.h"
+#include "queue.h"
+#include "stack.h"
+#include "heap.h"
+
+/**
+ * @brief The traversal context.
+ *
+ * @details
+ * Everything a search or a traversal changes while it runs lives in the
+ * context instead of the graph, so any number of them can run on the same
+ * graph at once as long as each one uses its own context. A vertex is
+ * visited if its mark matches the context's epoch, so starting a new
+ * traversal only needs the epoch to move forward. The depth and parent of a
+ * vertex are only meaningful once it's been marked in the current epoch.
+ */
+struct traversal_ctx_s {
+    unsigned int *marks; /**< Epoch that last visited each vertex id. */
+    unsigned int *depths; /**< Depth at which each vertex id was reached. */
+    void **parents; /**< Vertex each vertex id was reached from. */
+    unsigned int capacity; /**< Number of vertex ids marks, depths and parents
+                                have room for. */
+    unsigned int epoch; /**< Epoch of the current traversal. */
+    queue_t *queue; /**< Frontier of the breadth first traversals. */
+    stack_type *stack; /**< Frontier of the depth first traversals. */
+    double *distances; /**< Distance of each vertex id from the source of a
+                            shortest path search, NULL till the first one. */
+    unsigned int distances_capacity; /**< Number of vertex ids distances has
+                                          room for. */
+    heap_t *heap; /**< Frontier of the shortest path searches, NULL till the
+                       first one. */
+    queue_t *reverse_queue; /**< Frontier of the target's side of a
+                                 bidirectional search, NULL till the first
+                                 one. */
+};
+
+boolean begin_context_traversal (traversal_ctx_t *, unsigned int);
+boolean begin_context_shortest_path (traversal_ctx_t *, unsigned int);
+boolean begin_context_bidirectional (traversal_ctx_t *, unsigned int);
+
+/**
+ * @brief Has this vertex been visited before in the current traversal?
+ *
+ * @param[in] ctx The traversal context.
+ * @param[in] id Id of the vertex under consideration.
+ *
+ * @return TRUE if we've visited this vertex before, FALSE otherwise.
+ */
+static inline boolean context_is_visited (traversal_ctx_t *ctx, unsigned int id)
+{
+    return ctx->marks[id] == ctx->epoch;
+}
+
+/**
+ * @brief Mark this vertex as visited in the current traversal.
+ *
+ * @param[in, out] ctx The traversal context.
+ * @param[in] id Id of the vertex we're asked to mark.
+ */
+static inline void context_mark_visited (traversal_ctx_t *ctx, unsigned int id)
+{
+    ctx->marks[id] = ctx->epoch;
+}
+
+#endif /* TRAVERSAL_PRIVATE_H */